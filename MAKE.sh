@@ -32,8 +32,17 @@ mkdir -p -v $buildDir
 
 
 t=0.25
-# -g = debug, -Os = Optimize Size
-Compile=(avr-gcc -Wall -g -Os -I "includes/fat" -I "includes/sd" -I "includes/gen" -I "includes/lcd" -I "includes/mp3" -DF_CPU=16000000 -mmcu=atmega1280 -c -o)
+# -g = debug, -Os = Optimize Size, -fstack-usage = write stack frame sizes
+#counters reported by the 'stats' and 'bench' commands of avr_fat_test.c.
+#They are left out of other builds as they add work to every SPI transfer
+#and SD command.
+statDefs=()
+if [ "$testFile" = "avr_fat_test.c" ]
+then
+    statDefs=(-DSPI_BYTE_COUNTER=1 -DSD_CMD_STATS=1)
+fi
+
+Compile=(avr-gcc -Wall -g -Os -fstack-usage -I "includes/fat" -I "includes/sd" -I "includes/gen" -I "includes/lcd" -I "includes/mp3" -DF_CPU=16000000 "${statDefs[@]}" -mmcu=atmega1280 -c -o)
 Link=(avr-gcc -Wall -g -mmcu=atmega1280 -o)
 IHex=(avr-objcopy -j .text -j .data -O ihex)
 
@@ -118,6 +127,104 @@ else
 fi
 
 
+echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/fat_cache.o "$fatDir"/fat_cache.c"
+"${Compile[@]}" $buildDir/fat_cache.o $fatDir/fat_cache.c
+status=$?
+sleep $t
+if [ $status -gt 0 ]
+then
+    echo -e "error compiling FAT_CACHE.C"
+    echo -e "program exiting with code $status"
+    exit $status
+else
+    echo -e "Compiling FAT_CACHE.C successful"
+fi
+
+
+echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/fat_arena.o "$fatDir"/fat_arena.c"
+"${Compile[@]}" $buildDir/fat_arena.o $fatDir/fat_arena.c
+status=$?
+sleep $t
+if [ $status -gt 0 ]
+then
+    echo -e "error compiling FAT_ARENA.C"
+    echo -e "program exiting with code $status"
+    exit $status
+else
+    echo -e "Compiling FAT_ARENA.C successful"
+fi
+
+
+echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/fat_path.o "$fatDir"/fat_path.c"
+"${Compile[@]}" $buildDir/fat_path.o $fatDir/fat_path.c
+status=$?
+sleep $t
+if [ $status -gt 0 ]
+then
+    echo -e "error compiling FAT_PATH.C"
+    echo -e "program exiting with code $status"
+    exit $status
+else
+    echo -e "Compiling FAT_PATH.C successful"
+fi
+
+
+echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/fat_index.o "$fatDir"/fat_index.c"
+"${Compile[@]}" $buildDir/fat_index.o $fatDir/fat_index.c
+status=$?
+sleep $t
+if [ $status -gt 0 ]
+then
+    echo -e "error compiling FAT_INDEX.C"
+    echo -e "program exiting with code $status"
+    exit $status
+else
+    echo -e "Compiling FAT_INDEX.C successful"
+fi
+
+
+echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/fat_lib.o "$fatDir"/fat_lib.c"
+"${Compile[@]}" $buildDir/fat_lib.o $fatDir/fat_lib.c
+status=$?
+sleep $t
+if [ $status -gt 0 ]
+then
+    echo -e "error compiling FAT_LIB.C"
+    echo -e "program exiting with code $status"
+    exit $status
+else
+    echo -e "Compiling FAT_LIB.C successful"
+fi
+
+
+echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/fat_sort.o "$fatDir"/fat_sort.c"
+"${Compile[@]}" $buildDir/fat_sort.o $fatDir/fat_sort.c
+status=$?
+sleep $t
+if [ $status -gt 0 ]
+then
+    echo -e "error compiling FAT_SORT.C"
+    echo -e "program exiting with code $status"
+    exit $status
+else
+    echo -e "Compiling FAT_SORT.C successful"
+fi
+
+
+echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/fat_ckpt.o "$fatDir"/fat_ckpt.c"
+"${Compile[@]}" $buildDir/fat_ckpt.o $fatDir/fat_ckpt.c
+status=$?
+sleep $t
+if [ $status -gt 0 ]
+then
+    echo -e "error compiling FAT_CKPT.C"
+    echo -e "program exiting with code $status"
+    exit $status
+else
+    echo -e "Compiling FAT_CKPT.C successful"
+fi
+
+
 echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/fat_to_sd.o "$fatDir"/fat_to_sd.c"
 "${Compile[@]}" $buildDir/fat_to_sd.o $fatDir/fat_to_sd.c
 status=$?
@@ -174,6 +281,20 @@ else
 fi
 
 
+echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/sched.o "$genDir"/sched.c"
+"${Compile[@]}" $buildDir/sched.o $genDir/sched.c
+status=$?
+sleep $t
+if [ $status -gt 0 ]
+then
+    echo -e "error compiling SCHED.C"
+    echo -e "program exiting with code $status"
+    exit $status
+else
+    echo -e "Compiling SCHED.C successful"
+fi
+
+
 echo -e "\n>> COMPILE: "${Compile[@]}" "$buildDir"/sd_spi_base.o "$sdDir"/sd_spi_base.c"
 "${Compile[@]}" $buildDir/sd_spi_base.o $sdDir/sd_spi_base.c
 status=$?
@@ -202,8 +323,8 @@ else
 fi
 
 
-echo -e "\n>> LINK: "${Link[@]}" "$buildDir"/test.elf "$buildDir"/_test.o  "$buildDir"/spi.o "$buildDir"/sd_spi_base.o "$buildDir"/sd_spi_rwe.o "$buildDir"/usart0.o "$buildDir"/prints.o "$buildDir"/fat_bpb.o "$buildDir"/fat.o "$buildDir"/fat_to_sd.o" "$buildDir"/lcd_base.o" "$buildDir"/lcd_sf.o" "$buildDir"/mp3.o
-"${Link[@]}" $buildDir/test.elf $buildDir/test.o $buildDir/spi.o $buildDir/sd_spi_base.o $buildDir/sd_spi_rwe.o $buildDir/usart0.o $buildDir/prints.o $buildDir/fat.o $buildDir/fat_bpb.o $buildDir/fat_to_sd.o $buildDir/lcd_base.o $buildDir/lcd_sf.o $buildDir/mp3.o
+echo -e "\n>> LINK: ${Link[@]} $buildDir/test.elf $buildDir/test.o $buildDir/spi.o $buildDir/sd_spi_base.o $buildDir/sd_spi_rwe.o $buildDir/usart0.o $buildDir/prints.o $buildDir/fat.o $buildDir/fat_bpb.o $buildDir/fat_to_sd.o $buildDir/fat_cache.o $buildDir/fat_arena.o $buildDir/fat_path.o $buildDir/fat_index.o $buildDir/fat_lib.o $buildDir/fat_sort.o $buildDir/fat_ckpt.o $buildDir/lcd_base.o $buildDir/lcd_sf.o $buildDir/mp3.o $buildDir/sched.o"
+"${Link[@]}" $buildDir/test.elf $buildDir/test.o $buildDir/spi.o $buildDir/sd_spi_base.o $buildDir/sd_spi_rwe.o $buildDir/usart0.o $buildDir/prints.o $buildDir/fat.o $buildDir/fat_bpb.o $buildDir/fat_to_sd.o $buildDir/fat_cache.o $buildDir/fat_arena.o $buildDir/fat_path.o $buildDir/fat_index.o $buildDir/fat_lib.o $buildDir/fat_sort.o $buildDir/fat_ckpt.o $buildDir/lcd_base.o $buildDir/lcd_sf.o $buildDir/mp3.o $buildDir/sched.o
 status=$?
 sleep $t
 if [ $status -gt 0 ]
@@ -232,6 +353,26 @@ fi
 
 
 
+echo -e "\n>> MEMORY USAGE: avr-size -C --mcu=atmega1280 "$buildDir"/test.elf"
+avr-size -C --mcu=atmega1280 $buildDir/test.elf
+
+# static SRAM (.data + .bss), compared with the previous build's.
+sram=$(avr-size -A $buildDir/test.elf | awk '$1 == ".data" || $1 == ".bss" {n += $2} END {print n}')
+if [ -f $buildDir/sram.prev ]
+then
+    prev=$(cat $buildDir/sram.prev)
+    echo -e "Static SRAM: $sram bytes. Previous build: $prev bytes. Freed: $((prev - sram)) bytes"
+else
+    echo -e "Static SRAM: $sram bytes"
+fi
+echo $sram > $buildDir/sram.prev
+
+# stack frame size of each FAT function, largest first, from -fstack-usage.
+echo -e "\n>> STACK FRAME SIZES (bytes) OF FAT FUNCTIONS"
+cat $buildDir/fat*.su | awk -F'\t' '{n = split($1, f, ":"); print $2 "\t" f[n]}' | sort -n -r
+
+
+
 echo -e "\n>> DOWNLOAD HEX FILE TO AVR"
 echo "avrdude -p atmega1280 -c dragon_jtag -U flash:w:test.hex:i -P usb"
 avrdude -p atmega1280 -c dragon_jtag -U flash:w:$buildDir/test.hex:i -P usb
@@ -64,6 +64,7 @@
 #define FIRST_SEC_POS_IN_CLUS     0
 #define FIRST_ENT_POS_IN_SEC      0
 #define LAST_ENTRY_POS_IN_SEC     SECTOR_LEN - ENTRY_LEN
+#define ENTRIES_PER_SEC           (SECTOR_LEN / ENTRY_LEN)
 
 /* 
  * ----------------------------------------------------------------------------
@@ -152,7 +153,8 @@
  *               found in three separate ranges of bytes. The values below
  *               represent the start and end byte offsets of these three 
  *               ranges. A long name may be distributed among multiple 32-byte
- *               entries.
+ *               entries. Each char is a 2-byte UTF-16 code, low byte first, 
+ *               so an entry holds LN_CHARS_PER_ENTRY chars.
  * ----------------------------------------------------------------------------
  */
 #define LN_CHAR_RANGE_1_BEGIN      1
@@ -161,6 +163,10 @@
 #define LN_CHAR_RANGE_2_END       26
 #define LN_CHAR_RANGE_3_BEGIN     28
 #define LN_CHAR_RANGE_3_END       32
+#define LN_CHARS_PER_ENTRY        13
+
+// byte of each long name entry holding the checksum of its short name.
+#define LN_CHKSUM_BYTE_OFFSET     13
 
 /* 
  * ----------------------------------------------------------------------------
@@ -201,6 +207,16 @@
 // unit used when printing an entry's file size. Set to BYTE or KB 
 #define FS_UNIT                 BYTE   
 
+//
+// Number of extents held in the map of each open FatFile. Each one requires
+// 12 bytes of SRAM. If a file has more fragments than this, the map keeps
+// every 2nd, 4th, ... fragment as a checkpoint. Must be even. Can be set at
+// build time with -DFAT_FILE_EXTENTS=n.
+//
+#ifndef FAT_FILE_EXTENTS
+#define FAT_FILE_EXTENTS        8
+#endif//FAT_FILE_EXTENTS
+
 /* 
  * ----------------------------------------------------------------------------
  *                                                              FAT ERROR FLAGS
@@ -210,6 +226,7 @@
  */
 #define SUCCESS                0x00
 #define INVALID_NAME           0x01
+#define SCAN_YIELD             0x02 // scan stopped early, call again
 #define FILE_NOT_FOUND         0x04
 #define DIR_NOT_FOUND          0x08
 #define END_OF_FILE            0x10
@@ -302,8 +319,8 @@ FatDir;
  *       
  * Notes       : Any instance of this struct should first be initialized by
  *               passing it to fat_InitEntry, after which, fat_SetNextEntry
- *               should be the only function that currently updates the 
- *               instance.
+ *               or fat_CursorNextEntry should be the only functions that 
+ *               update the instance.
  * 
  * Warnings    : Members of an instance of this struct should never be set
  *               manually, but only by passing it to the FAT functions.
@@ -320,6 +337,121 @@ typedef struct
 } 
 FatEntry;
 
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                  FAT DIRECTORY CURSOR STRUCT
+ *
+ * Description : Instances of this struct are used to iterate over the entries
+ *               of a FAT directory. The cursor holds the directory sector it
+ *               is scanning, so that consecutive entries in the same sector
+ *               are found without accessing the disk.
+ *       
+ * Notes       : 1) Any instance of this struct should first be set to a 
+ *                  directory by passing it to fat_InitCursor, after which,
+ *                  fat_CursorNextEntry should be the only function that 
+ *                  updates the instance.
+ *               2) An instance requires more than SECTOR_LEN bytes of SRAM.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct 
+{
+  uint32_t clusIndx;                   // index of the cluster being scanned
+  uint16_t clusNum;                    // position of clusIndx in dir's chain
+  uint8_t  secNumInClus;               // sector number in cluster of secArr
+  uint16_t entPos;                     // position of next entry in secArr
+  uint8_t  secLoaded;                  // 1 if secArr holds the sector
+  uint8_t  secArr[SECTOR_LEN];         // the directory sector being scanned
+} 
+FatCursor;
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                   FAT ENTRY REFERENCE STRUCT
+ *
+ * Description : A compact handle to an entry in a FAT directory. It holds the
+ *               location of the entry and the fields of its short name entry
+ *               that are needed to filter and open it, but not its name. The
+ *               name is decoded from the disk, only when needed, by 
+ *               fat_GetEntryName.
+ *       
+ * Notes       : 1) An instance is set by fat_CursorNextRef and is about 28 
+ *                  bytes, compared with about 150 bytes for a FatEntry.
+ *               2) entNum counts the 32-byte entries of the directory from 0,
+ *                  and is the number of the entry's first long name entry, 
+ *                  or of its short name entry if it has no long name. A 
+ *                  cursor can be returned to the entry with fat_SeekCursor.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct 
+{
+  uint32_t lnClusIndx;                 // cluster index of first ln entry
+  uint8_t  lnSecNumInClus;             // sector in cluster of first ln entry
+  uint16_t lnEntPos;                   // position in sector of first ln entry
+  uint8_t  lnEntCnt;                   // number of ln entries. 0 if no ln.
+  uint16_t entNum;                     // number in dir of its first entry
+  uint32_t snClusIndx;                 // cluster index of the sn entry
+  uint8_t  snSecNumInClus;             // sector in cluster of the sn entry
+  uint16_t snEntPos;                   // position in sector of the sn entry
+  uint8_t  attr;                       // attribute byte of the sn entry
+  uint8_t  snChkSum;                   // checksum of the short name
+  uint32_t fstClusIndx;                // index of entry's first cluster
+  uint32_t fileSize;                   // file size in bytes
+} 
+FatEntryRef;
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                       FAT FILE EXTENT STRUCT
+ *
+ * Description : A run of consecutive clusters belonging to a file.
+ *       
+ * Notes       : fileClus is the position of the run's first cluster in the 
+ *               file, where 0 is the file's first cluster. clusIndx is the 
+ *               FAT index of that cluster.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct 
+{
+  uint32_t fileClus;                   // position of first cluster in file
+  uint32_t clusIndx;                   // FAT index of first cluster
+  uint32_t clusCnt;                    // number of clusters in the run
+} 
+FatExtent;
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                              FAT FILE STRUCT
+ *
+ * Description : Instances of this struct are handles to files opened for 
+ *               reading. A handle tracks the current byte position in the 
+ *               file and the cluster holding it, and buffers the sector 
+ *               holding it. It also holds a map of the file's cluster chain
+ *               as a list of extents, used to locate the cluster holding any
+ *               position without following the chain.
+ *       
+ * Notes       : 1) An instance of this struct is set by fat_Open and should
+ *                  only be updated by fat_Read, fat_Seek and fat_Close.
+ *               2) An instance requires more than SECTOR_LEN bytes of SRAM.
+ *               3) If the file has more than FAT_FILE_EXTENTS fragments, the
+ *                  extents are sparse checkpoints. The chain is then followed
+ *                  from the nearest checkpoint before a position.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct 
+{
+  uint32_t fstClusIndx;                // index of file's first cluster
+  uint32_t fileSize;                   // file size in bytes
+  uint32_t pos;                        // current byte position in the file
+  uint32_t clusIndx;                   // index of the cluster at clusNum
+  uint32_t clusNum;                    // position of clusIndx in the chain
+  uint32_t secNumOnDisk;               // disk address of sector in secArr
+  uint8_t  secLoaded;                  // 1 if secArr holds secNumOnDisk
+  FatExtent ext[FAT_FILE_EXTENTS];     // map of file's cluster chain
+  uint8_t  extCnt;                     // number of extents in ext
+  uint8_t  secArr[SECTOR_LEN];         // the file sector last read
+} 
+FatFile;
+
 /*
  ******************************************************************************
  *                           FUNCTION PROTOTYPES
@@ -372,6 +504,222 @@ void fat_InitEntry(FatEntry *ent, const BPB *bpb);
  */
 uint8_t fat_SetNextEntry(FatEntry *currEntry, const BPB *bpb);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  INITIALIZE DIRECTORY CURSOR
+ *                                      
+ * Description : Sets a FatCursor instance to the first entry of a directory.
+ * 
+ * Arguments   : cur   - Pointer to the FatCursor instance to be initialized.
+ *               dir   - Pointer to a FatDir instance. The cursor will iterate
+ *                       over the entries of this directory.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_InitCursor(FatCursor *cur, const FatDir *dir);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  SEEK CURSOR TO ENTRY NUMBER
+ *                                      
+ * Description : Sets a FatCursor instance to the 32-byte entry at position
+ *               entNum of a directory, e.g. the entNum of a FatEntryRef.
+ * 
+ * Arguments   : cur      - Pointer to the FatCursor instance to be set.
+ *               dir      - Pointer to a FatDir instance. The cursor will 
+ *                          iterate over the entries of this directory.
+ *               entNum   - Number of the entry in the directory, from 0.
+ *               bpb      - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS, END_OF_DIRECTORY if the directory's cluster chain
+ *               ends before entNum, or FAILED_READ_SECTOR if a FAT sector 
+ *               could not be read.
+ * 
+ * Notes       : The cluster holding the entry is found by following the 
+ *               directory's cluster chain. No directory sector is read.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_SeekCursor(FatCursor *cur, const FatDir *dir, uint16_t entNum,
+                       const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                       SEEK CURSOR TO ENTRY NUMBER IN CLUSTER
+ *                                      
+ * Description : Same as fat_SeekCursor, but the index of the cluster holding
+ *               the entry is given, so the chain is not followed.
+ * 
+ * Arguments   : cur        - Pointer to the FatCursor instance to be set.
+ *               clusIndx   - Index of the cluster holding the entry, e.g. the
+ *                            lnClusIndx of a FatEntryRef with a long name, 
+ *                            or else its snClusIndx.
+ *               entNum     - Number of the entry in the directory, from 0.
+ *               bpb        - Pointer to the BPB struct instance.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_SeekCursorInClus(FatCursor *cur, uint32_t clusIndx, uint16_t entNum,
+                          const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              HASH ENTRY NAME
+ *                                      
+ * Description : Returns a 16-bit hash (djb2) of an entry name, used as a key
+ *               for cached lookups of the entry.
+ * 
+ * Arguments   : nameStr   - The name string.
+ * 
+ * Returns     : The hash.
+ * ----------------------------------------------------------------------------
+ */
+uint16_t fat_HashName(const char nameStr[]);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                           SET FAT ENTRY TO NEXT CURSOR ENTRY
+ *                                      
+ * Description : Advances a FatCursor to the next short name entry in its
+ *               directory and updates a FatEntry instance to that entry.
+ * 
+ * Arguments   : cur   - Pointer to a FatCursor instance previously set by 
+ *                       fat_InitCursor. 
+ *               ent   - Pointer to a FatEntry instance. Its members will be
+ *                       updated to the next entry found by the cursor.
+ *               bpb   - Pointer to the BPB struct instance.
+ *
+ * Returns     : A FAT Error Flag. If any value other than SUCCESS is returned 
+ *               then the function was unable to update the FatEntry.
+ * 
+ * Notes       : A sector is only read from the disk when the cursor crosses
+ *               a sector boundary, and the FAT only when it crosses a cluster
+ *               boundary.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CursorNextEntry(FatCursor *cur, FatEntry *ent, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                         SCAN FOR NEXT CURSOR ENTRY (LIMITED)
+ *                                      
+ * Description : Same as fat_CursorNextEntry, but each sector read is taken 
+ *               from a budget, and the scan stops when the budget is used up,
+ *               so that a long scan can be resumed later.
+ * 
+ * Arguments   : cur         - Pointer to a FatCursor instance previously set
+ *                             by fat_InitCursor. 
+ *               ent         - Pointer to a FatEntry instance. Its members 
+ *                             will be updated to the next entry found by the
+ *                             cursor.
+ *               secBudget   - Pointer to the number of sectors that may be 
+ *                             read. Decremented for each sector read. If 0 
+ *                             (a null pointer) there is no limit.
+ *               bpb         - Pointer to the BPB struct instance.
+ *
+ * Returns     : A FAT Error Flag. SCAN_YIELD if the budget was used up before
+ *               an entry was found. 
+ * 
+ * Notes       : 1) On SCAN_YIELD, ent is not changed and the cursor is left 
+ *                  where the scan stopped. Calling again with the same cursor
+ *                  and a new budget continues the scan, e.g. the next time a
+ *                  scheduler task runs.
+ *               2) If the budget runs out part way through a long name, the 
+ *                  cursor is moved back to its first entry, which is read
+ *                  again by the next call. If the long name began in a sector
+ *                  read by this call it is finished instead, which takes one
+ *                  sector more than the budget.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CursorScanEntry(FatCursor *cur, FatEntry *ent, 
+                            uint8_t *secBudget, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                        SET FAT ENTRY REFERENCE TO NEXT ENTRY
+ *                                      
+ * Description : Advances a FatCursor to the next entry in its directory whose
+ *               attribute byte matches, and sets a FatEntryRef to it. Long 
+ *               names are checked but not decoded, and entries that do not 
+ *               match are skipped without any name work.
+ * 
+ * Arguments   : cur        - Pointer to a FatCursor instance previously set 
+ *                            by fat_InitCursor. 
+ *               ref        - Pointer to a FatEntryRef instance. Set to the
+ *                            next matching entry.
+ *               attrMask   - Attribute bits to test.
+ *               attrVal    - Value the tested bits must have, e.g. 
+ *                            attrMask = DIR_ENTRY_ATTR | VOLUME_ID_ATTR and
+ *                            attrVal = DIR_ENTRY_ATTR for directories only,
+ *                            or attrMask = 0 and attrVal = 0 for any entry.
+ *               bpb        - Pointer to the BPB struct instance.
+ *
+ * Returns     : A FAT Error Flag. END_OF_DIRECTORY if there are no more 
+ *               matching entries.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CursorNextRef(FatCursor *cur, FatEntryRef *ref, uint8_t attrMask,
+                          uint8_t attrVal, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        GET NAME OF FAT ENTRY
+ *                                      
+ * Description : Decodes the name of the entry referenced by a FatEntryRef 
+ *               into a caller buffer. This is the long name, or the short 
+ *               name if the entry does not have a long name, i.e. the same 
+ *               string a FatEntry holds in lnStr.
+ * 
+ * Arguments   : ref      - Pointer to a FatEntryRef set by fat_CursorNextRef.
+ *               nameStr  - Array of at least LN_STR_LEN_MAX chars. The name
+ *                          is copied here as a string.
+ *               bpb      - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY if the 
+ *               long name entries continue past the end of the directory's
+ *               cluster chain, e.g. if ref is stale.
+ * 
+ * Notes       : The entry's sectors are read through the sector cache, so if
+ *               this is called right after fat_CursorNextRef they are 
+ *               normally still cached and no disk access occurs.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_GetEntryName(const FatEntryRef *ref, char nameStr[], 
+                         const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      MATCH NAME OF FAT ENTRY
+ *                                      
+ * Description : Compares a string to the name of the entry referenced by a
+ *               FatEntryRef, without decoding the whole name. The chars of 
+ *               each long name entry are compared in turn, and the 
+ *               comparison stops at the first entry that differs.
+ * 
+ * Arguments   : ref      - Pointer to a FatEntryRef set by fat_CursorNextRef.
+ *               nameStr  - The name to compare. Case-sensitive.
+ *               bpb      - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS if the entry's name is nameStr, FILE_NOT_FOUND if it
+ *               is not, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY as for 
+ *               fat_GetEntryName.
+ * 
+ * Notes       : 1) The name compared is the one fat_GetEntryName loads, i.e.
+ *                  the long name, or the short name if the entry does not 
+ *                  have a long name. Chars outside of the standard ascii 
+ *                  range are skipped and the name is truncated at 
+ *                  LN_STR_LEN_MAX - 1 chars, so a name is found by the 
+ *                  string 'ls' prints for it.
+ *               2) No sector is read if nameStr is too long for the number of
+ *                  long name entries, and the comparison stops at the first
+ *                  long name entry whose checksum is not that of the short 
+ *                  name.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_MatchEntryName(const FatEntryRef *ref, const char nameStr[],
+                           const BPB *bpb);
+
 /*
  * ----------------------------------------------------------------------------
  *                                                            SET FAT DIRECTORY
@@ -403,6 +751,58 @@ uint8_t fat_SetNextEntry(FatEntry *currEntry, const BPB *bpb);
  */
 uint8_t fat_SetDir(FatDir *dir, const char newDirStr[], const BPB *bpb);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                 SET FAT DIRECTORY TO A CHILD
+ *                                       
+ * Description : Sets a FatDir instance to the child directory referenced by a
+ *               FatEntryRef.
+ * 
+ * Arguments   : dir         - Pointer to the FatDir instance to be set to the
+ *                             child directory.
+ *               ref         - Pointer to a FatEntryRef referencing a 
+ *                             directory entry in dir, e.g. set by 
+ *                             fat_FindEntry.
+ *               newDirStr   - The name of the child directory.
+ *               bpb         - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS or FAILED_READ_SECTOR. If FAILED_READ_SECTOR, dir is
+ *               unchanged.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_SetDirToEntry(FatDir *dir, const FatEntryRef *ref, 
+                          const char newDirStr[], const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           FIND ENTRY BY NAME
+ *                                       
+ * Description : Searches a directory for an entry whose name matches nameStr
+ *               and whose attribute byte matches, and sets a FatEntryRef to 
+ *               it.
+ * 
+ * Arguments   : dir        - Pointer to the FatDir instance to search.
+ *               nameStr    - The name of the entry. Case-sensitive.
+ *               attrMask   - Attribute bits to test, as for fat_CursorNextRef.
+ *               attrVal    - Value the tested bits must have.
+ *               ref        - Pointer to a FatEntryRef instance. This will be
+ *                            set to the matching entry if it is found.
+ *               bpb        - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS if found, END_OF_DIRECTORY if not, or the error 
+ *               returned by fat_CursorNextRef or fat_MatchEntryName.
+ * 
+ * Notes       : 1) nameStr must be a long name unless a long name for the 
+ *                  entry does not exist, in which case it must be a short 
+ *                  name.
+ *               2) If a name index of dir is in use (FAT_INDEX.H) it is
+ *                  searched first, so only the sector(s) of the entry are read.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_FindEntry(const FatDir *dir, const char nameStr[], 
+                      uint8_t attrMask, uint8_t attrVal, FatEntryRef *ref,
+                      const BPB *bpb);
+
 /*
  * ----------------------------------------------------------------------------
  *                                            PRINT DIRECTORY ENTRIES TO SCREEN
@@ -448,12 +848,126 @@ uint8_t fat_PrintDir(const FatDir *dir, uint8_t entFlds, const BPB *bpb);
  * Returns     : FAT Error Flag. If any value other than END_OF_FILE is 
  *               returned, then an issue has occurred.
  *  
- * Notes       : fileStr must be a long name unless a long name for a given
- *               entry does not exist, in which case it must be a short name.
+ * Notes       : 1) fileStr must be a long name unless a long name for a given
+ *                  entry does not exist, in which case it must be a short 
+ *                  name.
+ *               2) The number of bytes printed is the file size held in the
+ *                  file's short name entry.
  * ----------------------------------------------------------------------------
  */
 uint8_t fat_PrintFile(const FatDir *dir, const char fileStr[], const BPB *bpb);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    OPEN FILE
+ *                                       
+ * Description : Sets a FatFile instance to the start of a file in a directory.
+ * 
+ * Arguments   : file       - Pointer to the FatFile instance to be set.
+ *               dir        - Pointer to a FatDir instance. This directory must
+ *                            contain the entry for the file to be opened.
+ *               fileStr    - Pointer to a string. This is the name of the file
+ *                            to be opened.
+ *               bpb        - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, INVALID_NAME, FILE_NOT_FOUND, CORRUPT_FAT_ENTRY if
+ *               the cluster chain is shorter than the file size, or another
+ *               FAT Error Flag if the directory could not be searched.
+ *  
+ * Notes       : 1) fileStr must be a long name unless a long name for a given
+ *                  entry does not exist, in which case it must be a short 
+ *                  name.
+ *               2) The file's cluster chain is followed once here to build
+ *                  its extent map. Each FAT sector holding the chain is read
+ *                  once.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_Open(FatFile *file, const FatDir *dir, const char fileStr[], 
+                 const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                               OPEN FILE AT ITS FIRST CLUSTER
+ *                                       
+ * Description : Sets a FatFile instance to the start of the file whose first
+ *               cluster and size are given, without searching a directory.
+ * 
+ * Arguments   : file          - Pointer to the FatFile instance to be set.
+ *               fstClusIndx   - Index of the file's first cluster, e.g. the
+ *                               fstClusIndx of its FatEntryRef.
+ *               fileSize      - File size in bytes.
+ *               bpb           - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY if the 
+ *               cluster chain is shorter than the file size.
+ *  
+ * Notes       : This is used by fat_Open once the file's entry is found, and
+ *               can be used to open a file whose entry was found earlier, 
+ *               e.g. a track of the library (FAT_LIB.H).
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_OpenAtClus(FatFile *file, uint32_t fstClusIndx, uint32_t fileSize,
+                       const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    READ FILE
+ *                                       
+ * Description : Reads up to len bytes from the current position of an open
+ *               file into buf and advances the position by the number read.
+ * 
+ * Arguments   : file        - Pointer to a FatFile instance set by fat_Open.
+ *               buf         - Pointer to the array to be loaded.
+ *               len         - Number of bytes requested.
+ *               bytesRead   - Pointer to an integer that will be set to the 
+ *                             number of bytes loaded into buf.
+ *               bpb         - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS if len bytes were read, END_OF_FILE if the end of the
+ *               file was reached first, or FAILED_READ_SECTOR or 
+ *               CORRUPT_FAT_ENTRY if the file could not be read.
+ *  
+ * Notes       : Whole, sector-aligned sectors are loaded directly into buf,
+ *               using a single FATtoDisk_ReadSectors call for each run of 
+ *               sectors that are consecutive on the disk. Other reads are 
+ *               copied from the sector buffered in the FatFile instance.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_Read(FatFile *file, uint8_t buf[], uint16_t len, 
+                 uint16_t *bytesRead, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    SEEK FILE
+ *                                       
+ * Description : Sets the current byte position of an open file.
+ * 
+ * Arguments   : file   - Pointer to a FatFile instance set by fat_Open.
+ *               pos    - Byte position from the start of the file.
+ *
+ * Returns     : SUCCESS, or END_OF_FILE if pos is beyond the end of the file,
+ *               in which case the position is set to the end of the file.
+ *  
+ * Notes       : No disk access occurs here. The next call to fat_Read finds
+ *               the cluster holding pos from the file's extent map.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_Seek(FatFile *file, uint32_t pos);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                   CLOSE FILE
+ *                                       
+ * Description : Closes an open file. Any further call to fat_Read with this
+ *               FatFile instance will return END_OF_FILE.
+ * 
+ * Arguments   : file   - Pointer to a FatFile instance set by fat_Open.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_Close(FatFile *file);
+
 /*
  *-----------------------------------------------------------------------------
  *                                                         PRINT FAT ERROR FLAG
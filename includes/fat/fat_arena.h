@@ -0,0 +1,108 @@
+/*
+ * File       : FAT_ARENA.H
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ * 
+ * Interface for a statically allocated arena of work buffers used by the FAT
+ * module. Functions that need a sector sized object only while they run, 
+ * i.e. the boot sector, a directory cursor or a file handle, borrow a slot 
+ * and return it before they return, instead of placing the object on the 
+ * stack. The arena is sized for the deepest nesting of borrows in the FAT 
+ * module, so the RAM it uses is fixed at link time and the stack no longer 
+ * needs room for these objects.
+ */
+
+#ifndef FAT_ARENA_H
+#define FAT_ARENA_H
+
+/*
+ ******************************************************************************
+ *                                   MACROS
+ ******************************************************************************
+ */
+
+//
+// Most slots borrowed at once by the FAT module. Each of these holds two:
+//  - fat_PrintFile's FatFile while fat_Open's search holds a FatCursor.
+//  - fat_OpenPath's and fat_ResolvePath's working FatDir while fat_FindEntry
+//    or fat_IndexLookup holds a FatCursor.
+//  - pvt_GetDirHash (fat_LibOpen) holds a FatDir and a FatCursor.
+//  - fat_LibBuild's FatDir while fat_SortNext, its page selection or
+//    pvt_CountEntries holds a FatCursor.
+// Nothing may borrow while two slots are held.
+//
+#define FAT_ARENA_DEPTH           2
+
+//
+// Number of slots in the arena. Each slot is the size of the largest object
+// borrowed, i.e. a FatFile. Must be at least FAT_ARENA_DEPTH, and no more 
+// than 8. Can be set at build time with -DFAT_ARENA_SLOTS=n.
+//
+#ifndef FAT_ARENA_SLOTS
+#define FAT_ARENA_SLOTS           FAT_ARENA_DEPTH
+#endif//FAT_ARENA_SLOTS
+
+#if FAT_ARENA_SLOTS < FAT_ARENA_DEPTH || FAT_ARENA_SLOTS > 8
+#error "FAT_ARENA_SLOTS must be between FAT_ARENA_DEPTH and 8"
+#endif
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            BORROW ARENA SLOT
+ *                                       
+ * Description : Returns a free slot of the arena and marks it in use.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : Pointer to the slot. It is large enough and aligned for a 
+ *               FatFile, a FatCursor, a FatDir or a sector array.
+ * 
+ * Warnings    : The arena is only for use by the FAT module, which never 
+ *               borrows more than FAT_ARENA_DEPTH slots at once, so a slot 
+ *               is always free. Every slot borrowed must be returned by 
+ *               fat_ArenaReturn before the borrowing function returns.
+ * ----------------------------------------------------------------------------
+ */
+void *fat_ArenaBorrow(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            RETURN ARENA SLOT
+ *                                       
+ * Description : Marks a slot returned by fat_ArenaBorrow as free.
+ * 
+ * Arguments   : slot     - Pointer returned by fat_ArenaBorrow.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_ArenaReturn(void *slot);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       ARENA SLOT SIZE / PEAK
+ *                                       
+ * Description : fat_ArenaSlotSize returns the size of each slot in bytes. 
+ *               fat_ArenaPeak returns the most slots that have been in use 
+ *               at once.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : size in bytes, or number of slots.
+ * ----------------------------------------------------------------------------
+ */
+uint16_t fat_ArenaSlotSize(void);
+uint8_t fat_ArenaPeak(void);
+
+#endif //FAT_ARENA_H
@@ -73,6 +73,12 @@
 #define ROOT_CLUS_POS2         45
 #define ROOT_CLUS_POS3         46
 #define ROOT_CLUS_POS4         47
+#define FS_INFO_POS_LSB        48
+#define FS_INFO_POS_MSB        49
+#define VOL_ID_POS1            67
+#define VOL_ID_POS2            68
+#define VOL_ID_POS3            69
+#define VOL_ID_POS4            70
 
 
 // Returns True if Sectors Per Cluster is a valid value and false otherwise.
@@ -93,8 +99,12 @@
  * Description : The members of this struct correspond to the Bios Parameter 
  *               Block fields needed by this module.
  * 
- * Notes       : dataRegionFirstSector is not a BPB field is a value calculated
- *               from the BPB values that is used frequently.
+ * Notes       : 1) dataRegionFirstSector is not a BPB field is a value 
+ *                  calculated from the BPB values that is used frequently.
+ *               2) volId is the volume serial number set when the volume was 
+ *                  formatted. It is used to tell volumes apart.
+ *               3) fsInfoSector is the disk's sector address of the FSInfo
+ *                  sector, calculated from the BPB's FSInfo sector number.
  * ----------------------------------------------------------------------------
  */
 typedef struct
@@ -106,6 +116,8 @@ typedef struct
   uint32_t fatSize32;
   uint32_t rootClus;
   uint32_t dataRegionFirstSector;
+  uint32_t volId;
+  uint32_t fsInfoSector;
 } 
 BPB;
 
@@ -0,0 +1,151 @@
+/*
+ * File       : FAT_CACHE.H
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Interface for a small LRU cache of disk sectors used by the FAT module. The
+ * cache sits between FAT.C and the FATtoDisk interface. Sectors that are read
+ * repeatedly, such as FAT sectors and directory sectors, are then only read
+ * from the disk once while they remain in the cache.
+ */
+
+#ifndef FAT_CACHE_H
+#define FAT_CACHE_H
+
+/*
+ ******************************************************************************
+ *                                   MACROS
+ ******************************************************************************
+ */
+
+//
+// Number of sectors held in the cache. Each one requires SECTOR_LEN + 4 bytes
+// of SRAM plus 1 byte for the LRU order, so 2 sectors use about 1 KB and 8
+// sectors use about 4 KB of the ATmega1280's 8 KB. Must be between 1 and 255.
+// Can be set at build time with -DFAT_CACHE_SECTORS=n.
+//
+#ifndef FAT_CACHE_SECTORS
+#define FAT_CACHE_SECTORS         2
+#endif//FAT_CACHE_SECTORS
+
+// sector number used to mark an empty cache slot. Never a valid sector.
+#define CACHE_EMPTY_SLOT          0xFFFFFFFF
+
+/*
+ ******************************************************************************
+ *                                  STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      CACHE ACCESS STATISTICS
+ *
+ * Description : Counters updated by the cache read functions.
+ *
+ * Members     : hits     - number of sector requests found in the cache.
+ *               misses   - number of sector requests read from the disk.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint32_t hits;
+  uint32_t misses;
+}
+FatCacheStats;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        GET SECTOR FROM CACHE
+ *
+ * Description : Sets secPtr to point to the cached copy of the sector at
+ *               secNum. If the sector is not in the cache it is read from the
+ *               disk into the least recently used cache slot.
+ *
+ * Arguments   : secNum   - Address of the sector on the disk.
+ *               secPtr   - Pointer to the pointer that will be set to the
+ *                          cached sector.
+ *
+ * Returns     : READ_SECTOR_SUCCESS or FAILED_READ_SECTOR.
+ *
+ * Notes       : The sector pointed to is only valid until the next call to a
+ *               cache function, after which it may have been replaced.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CacheGetSector(uint32_t secNum, const uint8_t **secPtr);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        READ SECTOR VIA CACHE
+ *
+ * Description : Same as fat_CacheGetSector, but the sector is copied into
+ *               secArr. Can be used in place of FATtoDisk_ReadSingleSector.
+ *
+ * Arguments   : secNum   - Address of the sector on the disk.
+ *               secArr   - Pointer to a SECTOR_LEN array to be loaded.
+ *
+ * Returns     : READ_SECTOR_SUCCESS or FAILED_READ_SECTOR.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CacheReadSector(uint32_t secNum, uint8_t secArr[]);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       WRITE SECTOR VIA CACHE
+ *
+ * Description : Writes secArr to the sector at secNum on the disk, and 
+ *               updates the cached copy of the sector if there is one.
+ *
+ * Arguments   : secNum   - Address of the sector on the disk.
+ *               secArr   - Pointer to the SECTOR_LEN array to be written.
+ *
+ * Returns     : WRITE_SECTOR_SUCCESS or FAILED_WRITE_SECTOR.
+ *
+ * Notes       : A sector that is not cached is not added to the cache, so 
+ *               writing does not remove the sectors being read.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CacheWriteSector(uint32_t secNum, const uint8_t secArr[]);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                             INVALIDATE CACHE
+ *
+ * Description : Empties all of the cache slots.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ *
+ * Notes       : Must be called if the disk is replaced or remounted, or if
+ *               the disk is written to other than by fat_CacheWriteSector.
+ * ----------------------------------------------------------------------------
+ */
+void fat_CacheInvalidate(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       GET / RESET STATISTICS
+ *
+ * Description : Copies the cache counters into st, or clears them.
+ *
+ * Arguments   : st   - Pointer to a FatCacheStats instance to be loaded.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_CacheGetStats(FatCacheStats *st);
+void fat_CacheResetStats(void);
+
+#endif //FAT_CACHE_H
@@ -0,0 +1,178 @@
+/*
+ * File       : FAT_CKPT.H
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Interface for random access to the entries of a directory by their number,
+ * e.g. to step back to the previous entry or jump to the 500th. While the
+ * directory is scanned, the position of every interval'th entry is kept in a
+ * checkpoint table supplied by the application. An entry is then found by
+ * setting a cursor to the checkpoint before it and stepping forward, which
+ * takes fewer than interval steps. Each step only tests the attribute of an
+ * entry. No name is decoded.
+ */
+
+#ifndef FAT_CKPT_H
+#define FAT_CKPT_H
+
+/*
+ ******************************************************************************
+ *                                   MACROS
+ ******************************************************************************
+ */
+
+//
+// Number of entries, up to and including the last one found, whose positions
+// are also kept, so that stepping back over them takes one step each. 6 
+// bytes each.
+//
+#ifndef FAT_CKPT_RECENT
+#define FAT_CKPT_RECENT           8
+#endif//FAT_CKPT_RECENT
+
+/*
+ ******************************************************************************
+ *                                  STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            CHECKPOINT STRUCT
+ *
+ * Description : The position of an entry in its directory. 6 bytes.
+ *
+ * Members     : clusIndx   - index of the cluster holding the entry's first
+ *                            32-byte entry.
+ *               entNum     - the entNum of the entry's FatEntryRef.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint32_t clusIndx;
+  uint16_t entNum;
+}
+FatCkpt;
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      CHECKPOINT TABLE STRUCT
+ *
+ * Description : The checkpoints of one directory.
+ *
+ * Members     : dir        - the directory.
+ *               ckpts      - array holding the checkpoints. ckpts[i] is the
+ *                            position of entry i * interval.
+ *               ckptsMax   - number of elements in ckpts.
+ *               ckptCnt    - number of elements used.
+ *               interval   - entries between checkpoints.
+ *               attrMask   - attribute bits of the entries that are counted.
+ *               attrVal    - value the tested bits must have.
+ *               entCnt     - number of entries found so far.
+ *               complete   - 1 if entCnt is the number of entries in dir.
+ *               nxtEntNum  - number of the entry the cursor passed to the
+ *                            last fat_SeekEntry call will return next.
+ *               recent     - positions of the entries recentFst to 
+ *                            recentFst + recentCnt - 1.
+ *               recentFst  - number of the entry at recent[0].
+ *               recentCnt  - number of elements of recent used.
+ *
+ * Notes       : An instance is set by fat_CkptInit and should then only be
+ *               updated by the functions of this module.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  const FatDir *dir;
+  FatCkpt      *ckpts;
+  uint8_t       ckptsMax;
+  uint8_t       ckptCnt;
+  uint16_t      interval;
+  uint8_t       attrMask;
+  uint8_t       attrVal;
+  uint16_t      entCnt;
+  uint8_t       complete;
+  uint16_t      nxtEntNum;
+  FatCkpt       recent[FAT_CKPT_RECENT];
+  uint16_t      recentFst;
+  uint8_t       recentCnt;
+}
+FatCkptTable;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  INITIALIZE CHECKPOINT TABLE
+ *
+ * Description : Sets a FatCkptTable instance to an empty table for a
+ *               directory.
+ *
+ * Arguments   : tbl        - Pointer to the FatCkptTable instance.
+ *               dir        - Pointer to the FatDir instance of the directory.
+ *                            It must not change while tbl is used.
+ *               ckpts      - Array of ckptsMax FatCkpt elements. It must
+ *                            exist for as long as tbl is used.
+ *               ckptsMax   - Number of elements in ckpts. At least 1.
+ *               interval   - Entries between checkpoints, at least 1.
+ *               attrMask   - Attribute bits to test, as for fat_CursorNextRef.
+ *               attrVal    - Value the tested bits must have, e.g.
+ *                            attrMask = HIDDEN_ATTR | VOLUME_ID_ATTR and
+ *                            attrVal = 0 for the entries a listing shows.
+ *
+ * Returns     : void
+ *
+ * Notes       : 1) Only the entries whose attributes match are numbered. The
+ *                  "." and ".." entries are not numbered.
+ *               2) If the directory has more than ckptsMax * interval
+ *                  entries, every other checkpoint is dropped and the
+ *                  interval doubled as often as needed, so the table never
+ *                  grows, but an entry then takes more steps to find.
+ * ----------------------------------------------------------------------------
+ */
+void fat_CkptInit(FatCkptTable *tbl, const FatDir *dir, FatCkpt ckpts[],
+                  uint8_t ckptsMax, uint16_t interval, uint8_t attrMask,
+                  uint8_t attrVal);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            SEEK ENTRY NUMBER
+ *
+ * Description : Sets a FatEntryRef to the entry of the directory with a given
+ *               number, in the order the entries are in the directory.
+ *
+ * Arguments   : tbl      - Pointer to a FatCkptTable set by fat_CkptInit.
+ *               cur      - Pointer to a FatCursor instance. Left at the entry
+ *                          after entNum.
+ *               entNum   - Number of the entry, from 0.
+ *               ref      - Pointer to the FatEntryRef instance to be set.
+ *               bpb      - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, END_OF_DIRECTORY if the directory has no entry
+ *               entNum, or FAILED_READ_SECTOR.
+ *
+ * Notes       : 1) The entry is found from the nearest checkpoint before it,
+ *                  or from the furthest one if entNum has not been reached
+ *                  yet, in which case checkpoints are added on the way.
+ *               2) If cur is not changed between calls, the entry after the
+ *                  last one found (entNum + 1) is read from where cur was
+ *                  left, without going back to a checkpoint, so stepping
+ *                  forward takes one step. The FAT_CKPT_RECENT entries up to
+ *                  the last one found are found in one step, so stepping 
+ *                  back only goes to a checkpoint once every 
+ *                  FAT_CKPT_RECENT entries.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_SeekEntry(FatCkptTable *tbl, FatCursor *cur, uint16_t entNum,
+                      FatEntryRef *ref, const BPB *bpb);
+
+#endif //FAT_CKPT_H
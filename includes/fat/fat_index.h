@@ -0,0 +1,164 @@
+/*
+ * File       : FAT_INDEX.H
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ * 
+ * Interface for an optional index of the entry names of one directory. The 
+ * index maps a 16-bit hash of each name to the number of the entry in the 
+ * directory. It is built by fat_IndexBuild, a full scan of the directory,
+ * after which fat_FindEntry, and so fat_SetDir, fat_Open and the path 
+ * functions, find an entry of that directory by reading only the sector(s)
+ * holding it. Other directories are searched as if there were no index.
+ * The index's array is supplied by the application, so it can be placed in
+ * internal or external SRAM.
+ */
+
+#ifndef FAT_INDEX_H
+#define FAT_INDEX_H
+
+/*
+ ******************************************************************************
+ *                                   MACROS
+ ******************************************************************************
+ */
+
+// state of a FatNameIndex.
+#define INDEX_EMPTY               0    // not built
+#define INDEX_COMPLETE            1    // holds every entry of the directory
+#define INDEX_PARTIAL             2    // the directory has more than entsMax
+
+/*
+ ******************************************************************************
+ *                                  STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          INDEXED NAME STRUCT
+ *
+ * Description : An entry of a FatNameIndex. 4 bytes.
+ *
+ * Members     : nameHash   - fat_HashName of the entry's name.
+ *               entNum     - the entNum of the entry's FatEntryRef.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint16_t nameHash;
+  uint16_t entNum;
+}
+FatIndexEnt;
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            NAME INDEX STRUCT
+ *
+ * Description : An index of the names of a directory.
+ *
+ * Members     : ents          - array holding the index.
+ *               entsMax       - number of elements in ents.
+ *               entCnt        - number of elements used.
+ *               dirClusIndx   - first cluster of the directory indexed.
+ *               volId        - volId of the volume (BPB) indexed.
+ *               state         - one of the INDEX_ states.
+ *
+ * Notes       : An instance is set by fat_IndexInit and should then only be 
+ *               updated by the functions of this module.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  FatIndexEnt *ents;
+  uint16_t     entsMax;
+  uint16_t     entCnt;
+  uint32_t     dirClusIndx;
+  uint32_t     volId;
+  uint8_t      state;
+}
+FatNameIndex;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        INITIALIZE NAME INDEX
+ *
+ * Description : Sets a FatNameIndex instance to an empty index using an 
+ *               array supplied by the caller, and makes it the index used by
+ *               fat_FindEntry.
+ *
+ * Arguments   : idx       - Pointer to the FatNameIndex instance.
+ *               ents      - Array of entsMax FatIndexEnt elements. It must 
+ *                           exist for as long as the index is used.
+ *               entsMax   - Number of elements in ents. A directory with 
+ *                           more entries than this is only partly indexed.
+ *
+ * Returns     : void
+ *
+ * Notes       : Only one index is used at a time, so only the last directory
+ *               passed to fat_IndexBuild is indexed. Pass a null idx to stop
+ *               using an index.
+ * ----------------------------------------------------------------------------
+ */
+void fat_IndexInit(FatNameIndex *idx, FatIndexEnt ents[], uint16_t entsMax);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                             BUILD NAME INDEX
+ *
+ * Description : Scans a directory and sets the index in use to its entries.
+ *
+ * Arguments   : dir    - Pointer to the FatDir instance to index.
+ *               bpb    - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, or the error that stopped the scan, in which case 
+ *               the index is left empty.
+ *
+ * Notes       : The index is only built by this function, e.g. when the 
+ *               application changes to a large directory. It must be called
+ *               again if the directory changes on the disk.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_IndexBuild(const FatDir *dir, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         LOOK UP INDEXED NAME
+ *
+ * Description : Finds an entry of a directory by name using the index in 
+ *               use, if the index is of dir.
+ *
+ * Arguments   : dir        - Pointer to the FatDir instance to search.
+ *               nameStr    - The name of the entry.
+ *               attrMask   - Attribute bits to test, as for fat_FindEntry.
+ *               attrVal    - Value the tested bits must have.
+ *               ref        - Set to the entry if it is found.
+ *               err        - Set to SUCCESS if found, END_OF_DIRECTORY if 
+ *                            not, or to a read error.
+ *               bpb        - Pointer to the BPB struct instance.
+ *
+ * Returns     : 1 if err was set, or 0 if the directory must be searched, 
+ *               i.e. there is no index in use, it is not of dir, or it is
+ *               INDEX_PARTIAL and does not hold the name.
+ *
+ * Notes       : 1) This is called by fat_FindEntry. 
+ *               2) Each entry whose hash matches is read and its name and 
+ *                  attributes compared, so a hash collision is never 
+ *                  returned as a match.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_IndexLookup(const FatDir *dir, const char nameStr[], 
+                        uint8_t attrMask, uint8_t attrVal, FatEntryRef *ref,
+                        uint8_t *err, const BPB *bpb);
+
+#endif //FAT_INDEX_H
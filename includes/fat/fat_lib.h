@@ -0,0 +1,310 @@
+/*
+ * File       : FAT_LIB.H
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Interface for a music library index kept in a file on the volume. The
+ * library is built once by a walk of the volume's artist directories (the
+ * root directory's subdirectories), their album subdirectories and the
+ * .mp3 files in those. Each artist, album and track is a 32 byte record,
+ * 16 to a sector, and the records of each directory are in name order and
+ * consecutive. Once built, a screen of artists, albums or tracks is read
+ * from one or two sectors, and a track is opened by fat_OpenAtClus without
+ * searching any directory.
+ *
+ * The FAT module does not allocate clusters, so the library file must be
+ * created on the volume beforehand, e.g. on a PC, as a file named
+ * FAT_LIB_FILE_NAME in the root directory whose clusters are consecutive
+ * and which is large enough to hold the records. Its data is overwritten
+ * by fat_LibBuild. A file created on a freshly formatted card, or with a
+ * tool that preallocates contiguously, will do, e.g.
+ *   fsutil file createnew LIBRARY.IDX 262144     (Windows)
+ *   fallocate -l 256K LIBRARY.IDX                (Linux)
+ * 256 KB holds 8176 records.
+ */
+
+#ifndef FAT_LIB_H
+#define FAT_LIB_H
+
+/*
+ ******************************************************************************
+ *                                   MACROS
+ ******************************************************************************
+ */
+
+// name of the library file in the root directory.
+#define FAT_LIB_FILE_NAME         "LIBRARY.IDX"
+
+// extension of the files added to the library as tracks. Not case-sensitive.
+#define FAT_LIB_TRACK_EXT         ".mp3"
+
+//
+// Number of characters of a name kept in a record, i.e. the width of the
+// LCD. Names are sorted by these characters, without regard to case.
+//
+#define LIB_NAME_LEN              20
+
+#define LIB_REC_LEN               32
+#define LIB_RECS_PER_SEC          (SECTOR_LEN / LIB_REC_LEN)
+
+// identifies a built library file. Changed if the record format changes.
+#define LIB_MAGIC                 "AVRLIB2"
+#define LIB_MAGIC_LEN             8
+
+// FSInfo sector signatures and field positions, used by the fingerprint.
+#define FSI_LEAD_SIG              0x41615252
+#define FSI_STRUC_SIG             0x61417272
+#define FSI_LEAD_SIG_POS          0
+#define FSI_STRUC_SIG_POS         484
+#define FSI_FREE_COUNT_POS        488
+#define FSI_NXT_FREE_POS          492
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              LIB ERROR FLAGS
+ *
+ * Description : Flags returned by the fat_Lib functions.
+ * ----------------------------------------------------------------------------
+ */
+#define LIB_SUCCESS               0x00
+#define LIB_NOT_FOUND             0x01    // no FAT_LIB_FILE_NAME in root dir
+#define LIB_FRAGMENTED            0x02    // file's clusters not consecutive
+#define LIB_STALE                 0x04    // not built for the volume as it is
+#define LIB_TOO_SMALL             0x08    // file or work array is too small
+#define LIB_READ_FAILED           0x10
+#define LIB_WRITE_FAILED          0x20
+#define LIB_NO_RECORD             0x40    // record number beyond last record
+
+/*
+ ******************************************************************************
+ *                                  STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        LIBRARY RECORD STRUCT
+ *
+ * Description : An artist, album or track of the library. 32 bytes.
+ *
+ * Members     : name       - first LIB_NAME_LEN chars of the name, padded
+ *                            with nulls. Not null terminated if the name is
+ *                            LIB_NAME_LEN or more chars.
+ *               fstClus    - index of the first cluster of the directory or
+ *                            file.
+ *               fileSize   - track's file size in bytes. 0 for a directory.
+ *               fstChild   - artist or album: record number of its first
+ *                            album or track. 0 for a track.
+ *               childCnt   - artist or album: number of albums or tracks. 0
+ *                            for a track.
+ *
+ * Notes       : The records are stored in the byte order of the device that
+ *               built the library.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  char     name[LIB_NAME_LEN];
+  uint32_t fstClus;
+  uint32_t fileSize;
+  uint16_t fstChild;
+  uint16_t childCnt;
+}
+FatLibRec;
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    VOLUME FINGERPRINT STRUCT
+ *
+ * Description : Values of the volume that change when files are added to, or
+ *               removed from it. A library is stale if the fingerprint it was
+ *               built with is not the volume's current one.
+ *
+ * Members     : volId          - volume serial number (BPB).
+ *               freeClusCnt    - FSInfo free cluster count.
+ *               nxtFreeClus    - FSInfo next free cluster hint.
+ *               libClus        - first cluster of the library file.
+ *               dirHash        - hash of the name, attributes, first cluster
+ *                                and size of each entry of the root and
+ *                                artist directories.
+ *
+ * Notes       : 1) The FSInfo values are kept up to date by the operating
+ *                  systems that write to SD cards. dirHash also detects
+ *                  artists and albums that are renamed, added or removed
+ *                  when they are not, e.g. if FSInfo is not valid.
+ *               2) Album directories are not hashed, so a track that is
+ *                  only renamed is not detected. Call fat_LibBuild then.
+ *               3) dirHash is computed by reading the whole root and
+ *                  artist directories. See fat_LibOpen.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint32_t volId;
+  uint32_t freeClusCnt;
+  uint32_t nxtFreeClus;
+  uint32_t libClus;
+  uint32_t dirHash;
+}
+FatLibFp;
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        LIBRARY HEADER STRUCT
+ *
+ * Description : The start of the first sector of the library file. The
+ *               records begin at the file's second sector.
+ *
+ * Members     : magic       - LIB_MAGIC once the library is built.
+ *               fp          - the fingerprint of the volume it was built on.
+ *               artistCnt   - number of artists. Records 0 to artistCnt - 1.
+ *               albumCnt    - number of albums. They follow the artists.
+ *               trackCnt    - number of tracks. They follow the albums.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  char     magic[LIB_MAGIC_LEN];
+  FatLibFp fp;
+  uint16_t artistCnt;
+  uint16_t albumCnt;
+  uint16_t trackCnt;
+}
+FatLibHdr;
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                               LIBRARY STRUCT
+ *
+ * Description : The library file of a volume. Set by fat_LibOpen.
+ *
+ * Members     : fstSec      - disk address of the library file's first
+ *                             sector.
+ *               recsMax     - number of records the file can hold.
+ *               fp          - the current fingerprint of the volume.
+ *               artistCnt   - number of artists, or 0 if not built.
+ *               albumCnt    - number of albums.
+ *               trackCnt    - number of tracks.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint32_t fstSec;
+  uint16_t recsMax;
+  FatLibFp fp;
+  uint16_t artistCnt;
+  uint16_t albumCnt;
+  uint16_t trackCnt;
+}
+FatLib;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            OPEN LIBRARY FILE
+ *
+ * Description : Finds the library file in the root directory and sets a
+ *               FatLib instance to it, and checks that the library was built
+ *               for the volume as it is now.
+ *
+ * Arguments   : lib    - Pointer to the FatLib instance to be set.
+ *               bpb    - Pointer to the BPB struct instance.
+ *
+ * Returns     : LIB_SUCCESS if the library can be used, LIB_STALE if it must
+ *               be built first by fat_LibBuild, or LIB_NOT_FOUND,
+ *               LIB_FRAGMENTED, LIB_TOO_SMALL or LIB_READ_FAILED if the file
+ *               cannot be used.
+ *
+ * Notes       : 1) Reads the library file's entry, FAT sector(s), FSInfo
+ *                  sector and first sector.
+ *               2) For the fingerprint's dirHash, every call also reads
+ *                  every sector of the root directory and of each artist
+ *                  directory, the FAT sectors of their cluster chains, and
+ *                  the root sector again after each artist, and decodes the
+ *                  long name of every entry in them. This grows with the
+ *                  number of artists and albums, not with the library size,
+ *                  and is paid on every boot.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_LibOpen(FatLib *lib, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                BUILD LIBRARY
+ *
+ * Description : Walks the artist and album directories of the volume and
+ *               writes the library's records to the library file.
+ *
+ * Arguments   : lib       - Pointer to a FatLib instance set by fat_LibOpen.
+ *               secRecs   - Array of LIB_RECS_PER_SEC records holding the
+ *                           sector being written.
+ *               keys      - Array of keysMax keys used to sort each
+ *                           directory, as for fat_SortInit.
+ *               keysMax   - Number of elements in keys. At least 1.
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : LIB_SUCCESS, LIB_TOO_SMALL if the file cannot hold the
+ *               records, or LIB_READ_FAILED or LIB_WRITE_FAILED. If it
+ *               fails, the library is left stale.
+ *
+ * Notes       : 1) Each directory is iterated in name order by a FatSort
+ *                  (fat_sort), so a larger keys array takes fewer passes 
+ *                  over each directory. secRecs and keys are only needed 
+ *                  while building, so they can be local arrays of the 
+ *                  calling function.
+ *               2) Hidden entries, and entries whose name begins with '.',
+ *                  are not added.
+ *               3) FAT_SORT_KEY_LEN must be at least LIB_NAME_LEN, as the
+ *                  names of the records are taken from the sort keys.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_LibBuild(FatLib *lib, FatLibRec secRecs[], FatSortKey keys[],
+                     uint8_t keysMax, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           GET LIBRARY RECORD
+ *
+ * Description : Loads a record of the library.
+ *
+ * Arguments   : lib      - Pointer to a FatLib instance for which fat_LibOpen
+ *                          or fat_LibBuild returned LIB_SUCCESS.
+ *               recNum   - Record number. The artists are records 0 to
+ *                          artistCnt - 1. An artist's albums, and an album's
+ *                          tracks, are records fstChild to
+ *                          fstChild + childCnt - 1.
+ *               rec      - Pointer to the FatLibRec instance to be loaded.
+ *
+ * Returns     : LIB_SUCCESS, LIB_NO_RECORD or LIB_READ_FAILED.
+ *
+ * Notes       : The record's sector is read through the sector cache, so
+ *               consecutive records only require a read every
+ *               LIB_RECS_PER_SEC records.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_LibGetRec(const FatLib *lib, uint16_t recNum, FatLibRec *rec);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         PRINT LIB ERROR FLAG
+ *
+ * Description : Prints the name of a LIB error flag.
+ *
+ * Arguments   : err   - LIB error flag.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_LibPrintError(uint8_t err);
+
+#endif //FAT_LIB_H
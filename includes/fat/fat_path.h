@@ -0,0 +1,149 @@
+/*
+ * File       : FAT_PATH.H
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ * 
+ * Interface for resolving absolute and relative paths to directories and 
+ * files. Each directory found while resolving a path is kept in a small LRU 
+ * cache, keyed by the first cluster of its parent and a hash of its name. A
+ * path whose directories are in the cache, e.g. the album of the previous 
+ * track, is then resolved without scanning them.
+ */
+
+#ifndef FAT_PATH_H
+#define FAT_PATH_H
+
+/*
+ ******************************************************************************
+ *                                   MACROS
+ ******************************************************************************
+ */
+
+//
+// Number of directories held in the path cache. Each one requires about 33
+// bytes of SRAM. Must be between 1 and 255. Can be set at build time with 
+// -DFAT_PATH_CACHE_DIRS=n.
+//
+#ifndef FAT_PATH_CACHE_DIRS
+#define FAT_PATH_CACHE_DIRS       4
+#endif//FAT_PATH_CACHE_DIRS
+
+// separates the directory and file names of a path.
+#define PATH_SEPARATOR            '/'
+
+/*
+ ******************************************************************************
+ *                                  STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                 PATH CACHE ACCESS STATISTICS
+ *
+ * Description : Counters updated when a directory of a path is looked up.
+ *
+ * Members     : hits     - number of directories found in the cache.
+ *               misses   - number of directories found by scanning their 
+ *                          parent.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint32_t hits;
+  uint32_t misses;
+}
+FatPathCacheStats;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          RESOLVE PATH TO DIR
+ *
+ * Description : Sets a FatDir instance to the directory given by a path.
+ *
+ * Arguments   : dir       - Pointer to a FatDir instance. A relative path 
+ *                           starts from this directory. It is set to the 
+ *                           directory at the end of the path.
+ *               pathStr   - The path, e.g. "/Artist/Album" or "../Album".
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, INVALID_NAME if a name in the path is too long, 
+ *               DIR_NOT_FOUND if a directory in the path does not exist, or 
+ *               FAILED_READ_SECTOR / CORRUPT_FAT_ENTRY. If not SUCCESS, dir
+ *               is unchanged.
+ *
+ * Notes       : 1) A path starting with '/' is absolute. Names are separated
+ *                  by one or more '/'. A '/' at the end is ignored.
+ *               2) "." is the current directory and ".." is its parent. "~"
+ *                  is the root directory.
+ *               3) Names are case-sensitive, and must be long names unless a
+ *                  directory does not have one, as for fat_SetDir.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_ResolvePath(FatDir *dir, const char pathStr[], const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          OPEN FILE FROM PATH
+ *
+ * Description : Opens the file given by a path, as fat_Open does.
+ *
+ * Arguments   : file      - Pointer to the FatFile instance to be set.
+ *               dir       - Pointer to a FatDir instance. A relative path 
+ *                           starts from this directory. It is not changed.
+ *               pathStr   - The path of the file, e.g. 
+ *                           "/Artist/Album/Track.mp3".
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : An error returned by fat_ResolvePath for the directories of 
+ *               the path, INVALID_NAME if the path ends in '/', or a value
+ *               returned by fat_Open for the file.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_OpenPath(FatFile *file, const FatDir *dir, const char pathStr[],
+                     const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        INVALIDATE PATH CACHE
+ *
+ * Description : Empties the path cache. Must be called when a different 
+ *               volume is mounted.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ *
+ * Notes       : The name of a cached directory is compared with the entry it
+ *               refers to each time it is used, so a changed entry is not 
+ *               used, but a different volume may have the same entry.
+ * ----------------------------------------------------------------------------
+ */
+void fat_PathCacheInvalidate(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       GET / RESET STATISTICS
+ *
+ * Description : Copies the path cache counters into st, or clears them.
+ *
+ * Arguments   : st   - Pointer to a FatPathCacheStats instance to be loaded.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_PathCacheGetStats(FatPathCacheStats *st);
+void fat_PathCacheResetStats(void);
+
+#endif //FAT_PATH_H
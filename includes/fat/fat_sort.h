@@ -0,0 +1,194 @@
+/*
+ * File       : FAT_SORT.H
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Interface for iterating over the entries of a directory in name order,
+ * using a fixed amount of RAM whatever the size of the directory. The
+ * entries are sorted by selection: each pass over the directory selects the
+ * next page of entries, i.e. the first keysMax in name order that follow the
+ * last entry returned, into a key array supplied by the application. The
+ * first page takes one pass, and a directory of n entries takes n / keysMax
+ * passes in all, so a larger key array sorts a large directory faster.
+ */
+
+#ifndef FAT_SORT_H
+#define FAT_SORT_H
+
+/*
+ ******************************************************************************
+ *                                   MACROS
+ ******************************************************************************
+ */
+
+//
+// Number of chars of a name that are compared, without regard to case.
+// Entries whose names begin with the same FAT_SORT_KEY_LEN chars are
+// returned in the order they are in the directory. 20 is the width of the
+// LCD, and the length of the names of the library records (fat_lib).
+//
+#ifndef FAT_SORT_KEY_LEN
+#define FAT_SORT_KEY_LEN          20
+#endif//FAT_SORT_KEY_LEN
+
+/*
+ ******************************************************************************
+ *                                  STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              SORT KEY STRUCT
+ *
+ * Description : An entry selected by a pass. FAT_SORT_KEY_LEN + 2 bytes.
+ *
+ * Members     : key      - first FAT_SORT_KEY_LEN chars of the name, padded
+ *                          with nulls. Not null terminated.
+ *               entNum   - the entNum of the entry's FatEntryRef.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  char     key[FAT_SORT_KEY_LEN];
+  uint16_t entNum;
+}
+FatSortKey;
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    SORTED DIRECTORY ITERATOR
+ *
+ * Description : Iterates over the entries of a directory in name order.
+ *
+ * Members     : dir        - the directory being iterated.
+ *               attrMask   - attribute bits tested by each pass.
+ *               attrVal    - value the tested bits must have.
+ *               filter     - function choosing the entries returned by
+ *                            their names, or NULL.
+ *               keys       - array holding the page being returned.
+ *               keysMax    - number of elements in keys.
+ *               keyCnt     - number of keys selected by the last pass.
+ *               keyPos     - next key of the page to be returned.
+ *               last       - the last entry returned. Its key holds the
+ *                            first FAT_SORT_KEY_LEN chars of its name.
+ *               passCnt    - passes made over the directory.
+ *
+ * Notes       : An instance is set by fat_SortInit and should then only be
+ *               updated by the functions of this module.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  const FatDir *dir;
+  uint8_t       attrMask;
+  uint8_t       attrVal;
+  uint8_t     (*filter)(const char nameStr[], uint8_t attr);
+  FatSortKey   *keys;
+  uint8_t       keysMax;
+  uint8_t       keyCnt;
+  uint8_t       keyPos;
+  FatSortKey    last;
+  uint16_t      passCnt;
+}
+FatSort;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   INITIALIZE SORTED ITERATOR
+ *
+ * Description : Sets a FatSort instance to the first entry, in name order,
+ *               of a directory.
+ *
+ * Arguments   : srt        - Pointer to the FatSort instance.
+ *               dir        - Pointer to the FatDir instance of the directory.
+ *                            It must not change while srt is used.
+ *               keys       - Array of keysMax FatSortKey elements. It must
+ *                            exist for as long as srt is used.
+ *               keysMax    - Number of elements in keys. At least 1.
+ *               attrMask   - Attribute bits to test, as for fat_CursorNextRef.
+ *               attrVal    - Value the tested bits must have, e.g.
+ *                            attrMask = HIDDEN_ATTR | VOLUME_ID_ATTR and
+ *                            attrVal = 0 for the entries a listing shows.
+ *
+ * Returns     : void
+ *
+ * Notes       : 1) The "." and ".." entries are never returned.
+ *               2) A 16 element keys array and the FatSort instance take
+ *                  about 400 bytes of RAM. Each pass also borrows a cursor
+ *                  from the arena.
+ * ----------------------------------------------------------------------------
+ */
+void fat_SortInit(FatSort *srt, const FatDir *dir, FatSortKey keys[],
+                  uint8_t keysMax, uint8_t attrMask, uint8_t attrVal);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            NEXT SORTED ENTRY
+ *
+ * Description : Sets a FatEntryRef to the next entry of the directory in name
+ *               order.
+ *
+ * Arguments   : srt    - Pointer to a FatSort instance set by fat_SortInit.
+ *               ref    - Pointer to the FatEntryRef instance to be set. The
+ *                        name is then loaded by fat_GetEntryName, and the
+ *                        entry opened by fat_SetDirToEntry or fat_OpenAtClus.
+ *               bpb    - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, END_OF_DIRECTORY if every entry has been returned,
+ *               or FAILED_READ_SECTOR.
+ *
+ * Notes       : A call that starts a new page makes a pass over the whole
+ *               directory. Every other call only reads the sector holding
+ *               the entry, which is normally cached.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_SortNext(FatSort *srt, FatEntryRef *ref, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            SET SORTED FILTER
+ *
+ * Description : Sets a function that chooses, by their names, which of the
+ *               entries whose attributes match are returned.
+ *
+ * Arguments   : srt      - Pointer to a FatSort instance set by fat_SortInit.
+ *               filter   - Function returning 1 if the entry with the name
+ *                          and attribute byte is returned, or 0 if it is
+ *                          skipped. NULL returns every entry.
+ *
+ * Returns     : void
+ *
+ * Notes       : 1) Set before the first fat_SortNext call, or rewind srt.
+ *               2) fat_SortInit sets no filter.
+ * ----------------------------------------------------------------------------
+ */
+void fat_SortSetFilter(FatSort *srt,
+                       uint8_t (*filter)(const char nameStr[], uint8_t attr));
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       REWIND SORTED ITERATOR
+ *
+ * Description : Sets a FatSort instance back to the first entry in name
+ *               order.
+ *
+ * Arguments   : srt   - Pointer to a FatSort instance set by fat_SortInit.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_SortRewind(FatSort *srt);
+
+#endif //FAT_SORT_H
@@ -43,6 +43,10 @@
 #define FAILED_READ_SECTOR      0x08        // This should be defined in fat.h
 #endif//FAILED_READ_SECTOR
 
+// values that can be returned by FATtoDisk_WriteSingleSector.
+#define WRITE_SECTOR_SUCCESS    0
+#define FAILED_WRITE_SECTOR     0x01
+
 // Boot sector signature bytes. The last two bytes of BS should be these.
 #define BS_SIGN_1     0x55
 #define BS_SIGN_2     0xAA
@@ -101,4 +105,54 @@ uint32_t FATtoDisk_FindBootSector(void);
  */
 uint8_t FATtoDisk_ReadSingleSector(uint32_t blkNum, uint8_t blkArr[]);
 
+/* 
+ * ----------------------------------------------------------------------------
+ *                                           READ CONSECUTIVE SECTORS FROM DISK
+ *                                       
+ * Description : Loads the contents of consecutive sectors/blocks, beginning
+ *               at the specified address on the disk, into the array blksArr.
+ *
+ * Arguments   : startBlkNum   - Block number address of the first sector to
+ *                               be read.
+ *               blkCnt        - Number of consecutive sectors to read.
+ *               blksArr       - Pointer to the array that will be loaded with
+ *                               the contents of the sectors. Must be of length
+ *                               blkCnt * SECTOR_LEN.
+ * 
+ * Returns     : READ_SECTOR_SUCCES if successful.
+ *               READ_SECTOR_FAILED if failure.
+ * 
+ * Notes       : Used by the FAT module whenever it reads more than one 
+ *               consecutive sector, e.g. several sectors of a cluster or of
+ *               a run of consecutive clusters, so that the disk can transfer
+ *               them in a single operation. File data is always read with
+ *               this function, so a disk that can continue a transfer from
+ *               the previous call's last sector may do so.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t FATtoDisk_ReadSectors(uint32_t startBlkNum, uint16_t blkCnt, 
+                              uint8_t blksArr[]);
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                  WRITE SINGLE SECTOR TO DISK
+ *                                       
+ * Description : Writes the contents of blkArr to the sector/block at the 
+ *               specified address on the disk.
+ *
+ * Arguments   : blkNum    - Block number address of the sector/block on the
+ *                           disk that should be written.
+ *               blkArr    - Pointer to the SECTOR_LEN array to be written.
+ * 
+ * Returns     : WRITE_SECTOR_SUCCESS if successful.
+ *               FAILED_WRITE_SECTOR if failure.
+ * 
+ * Notes       : The FAT module does not allocate clusters or change entries,
+ *               so this is only used to overwrite the data of existing files
+ *               (see FAT_LIB.H). Use fat_CacheWriteSector, which keeps the 
+ *               sector cache up to date, rather than calling this directly.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t FATtoDisk_WriteSingleSector(uint32_t blkNum, const uint8_t blkArr[]);
+
 #endif //FAT_TO_DISK_IF_
@@ -0,0 +1,116 @@
+/*
+ * File       : FAT_TO_SD.H
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * SD card specific extensions of the FATtoDisk interface implemented in 
+ * FAT_TO_SD.C. These are called by the application, not by the FAT module.
+ */
+
+#ifndef FAT_TO_SD_H
+#define FAT_TO_SD_H
+
+#include "sd_spi_base.h"
+
+/*
+ ******************************************************************************
+ *                                 STRUCTS
+ ******************************************************************************
+ */
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                              CARD DESCRIPTOR
+ * 
+ * Description : Card parameters needed to translate a sector number into the
+ *               address expected by the card's read/write commands.
+ * 
+ * Members     : type       - SDSC or SDHC.
+ *               addrMult   - 1 if block addressable (SDHC), BLOCK_LEN if byte
+ *                            addressable (SDSC).
+ *               mounted    - Set to 1 once the descriptor is valid.
+ * 
+ * Notes       : The single instance of this struct is held in FAT_TO_SD.C and
+ *               is set by FATtoSD_Mount.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint8_t  type;
+  uint16_t addrMult;
+  uint8_t  mounted;
+}
+SDCardDesc;
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                       DISK ACCESS STATISTICS
+ * 
+ * Description : Counters updated by the FATtoDisk functions.
+ * 
+ * Members     : secReads   - number of sectors read from the card.
+ *               readCmds   - number of read commands (READ_SINGLE_BLOCK or
+ *                            READ_MULTIPLE_BLOCK) sent to the card. Sectors
+ *                            read from an open stream do not add to this.
+ *               spiBytes   - number of bytes clocked through the SPI port
+ *                            while reading those sectors. This includes
+ *                            command, response, token, data and CRC bytes.
+ *               secWrites  - number of sectors written to the card.
+ *
+ * Notes       : spiBytes is only counted if SPI_BYTE_COUNTER is set in SPI.H.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint32_t secReads;
+  uint32_t readCmds;
+  uint32_t spiBytes;
+  uint32_t secWrites;
+}
+FATtoSDStats;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        MOUNT SD CARD FOR FAT
+ *                                       
+ * Description : Sets the card descriptor used by the FATtoDisk functions from
+ *               the CTV instance set by sd_InitModeSPI. 
+ *
+ * Arguments   : ctv   - Pointer to the CTV instance that was set by a 
+ *                       successful call to sd_InitModeSPI.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : Should be called once after sd_InitModeSPI and before 
+ *               fat_SetBPB. If it is not called, the card type is requested
+ *               from the card (SEND_CSD) once, on the first disk access.
+ * ----------------------------------------------------------------------------
+ */
+void FATtoSD_Mount(const CTV *ctv);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       GET / RESET STATISTICS
+ *                                       
+ * Description : Copies the disk access counters into st, or clears them.
+ *
+ * Arguments   : st   - Pointer to a FATtoSDStats instance to be loaded.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void FATtoSD_GetStats(FATtoSDStats *st);
+void FATtoSD_ResetStats(void);
+
+#endif //FAT_TO_SD_H
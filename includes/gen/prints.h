@@ -9,12 +9,54 @@
  * Copyright (c) 2020, 2021
  * 
  * Interface for some print functions used to print strings and unsigned
- * integers in decimal, binary, and hex formats.
+ * integers in decimal, binary, and hex formats. Output can also be formatted
+ * into a line buffer and sent in one call. Constant strings should be kept 
+ * in program memory and printed with the *P functions, e.g. 
+ * print_StrP(PSTR("text")), so that they do not take up SRAM.
  */
 
 #ifndef PRINTS_H
 #define PRINTS_H
 
+#include <avr/pgmspace.h>
+
+/*
+ ******************************************************************************
+ *                                    MACROS
+ ******************************************************************************
+ */
+
+// max field width of print_DecW and print_BufDec. Must be at least 10.
+#define PRINT_WIDTH_MAX     16
+
+// number of chars held by a PrintBuf. Must be at least PRINT_WIDTH_MAX.
+#ifndef PRINT_BUF_LEN
+#define PRINT_BUF_LEN       80
+#endif//PRINT_BUF_LEN
+
+/*
+ ******************************************************************************
+ *                                   STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           LINE BUFFER STRUCT
+ *
+ * Description : Holds formatted output until it is sent by print_BufFlush.
+ *
+ * Members     : str      - the chars to send. Not null terminated.
+ *               len      - number of chars in str.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  char    str[PRINT_BUF_LEN];
+  uint8_t len;
+}
+PrintBuf;
+
 /*
  ******************************************************************************
  *                            FUNCTION PROTOTYPES   
@@ -34,6 +76,44 @@
  */
 void print_Dec(uint32_t num);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                   PRINT FIXED WIDTH UNSIGNED DECIMAL INTEGER
+ * 
+ * Description : Prints num in decimal, right aligned in a field of at least
+ *               width chars, e.g. print_DecW(7, 2, '0') prints "07".
+ * 
+ * Arguments   : num     Unsigned integer to be printed to the screen.
+ *               width   Min number of chars to print, up to PRINT_WIDTH_MAX.
+ *               pad     Char printed before the digits to fill the width.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void print_DecW(uint32_t num, uint8_t width, char pad);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                              FORMAT UNSIGNED DECIMAL INTEGER
+ * 
+ * Description : Writes the decimal digits of num to str, right aligned in a
+ *               field of at least width chars. str is not null terminated.
+ * 
+ * Arguments   : str     Array the digits are written to. It must hold at 
+ *                       least max(width, 10) chars.
+ *               num     Unsigned integer to be formatted.
+ *               width   Min number of chars to write.
+ *               pad     Char written before the digits to fill the width, 
+ *                       e.g. ' ' or '0'.
+ * 
+ * Returns     : number of chars written to str.
+ * 
+ * Notes       : Digits are found by subtracting powers of 10 rather than by
+ *               dividing, which the AVR must do in software.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t print_FmtDec(char *str, uint32_t num, uint8_t width, char pad);
+
 /*
  * ----------------------------------------------------------------------------
  *                                                 PRINT BINARY FORM OF INTEGER 
@@ -79,4 +159,51 @@ void print_Hex(uint32_t num);
  */
 void print_Str(char *str);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                             PRINT C-STRING IN PROGRAM MEMORY
+ *                                       
+ * Description : Prints a C-string that is stored in program memory (flash).
+ * 
+ * Argument    : str     Pointer to a null-terminated string in program 
+ *                       memory, e.g. PSTR("text") or an array declared 
+ *                       PROGMEM.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void print_StrP(const char *str);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        LINE BUFFER FUNCTIONS
+ *                                       
+ * Description : print_BufInit empties a line buffer. print_BufStr, 
+ *               print_BufStrP (program memory string), print_BufChar and 
+ *               print_BufDec add to the end of the line. 
+ *               print_BufFlush sends the line to the screen in one call and 
+ *               empties it.
+ * 
+ * Argument    : buf     Pointer to a PrintBuf instance.
+ *               str     String to add.
+ *               c       Char to add.
+ *               num     Unsigned integer to add in decimal.
+ *               width   Min number of chars to add for num, up to 
+ *                       PRINT_WIDTH_MAX.
+ *               pad     Char added before the digits of num to fill width.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : If the buffer becomes full it is flushed, so that nothing is
+ *               lost, i.e. a line longer than PRINT_BUF_LEN is sent in more
+ *               than one call.
+ * ----------------------------------------------------------------------------
+ */
+void print_BufInit(PrintBuf *buf);
+void print_BufChar(PrintBuf *buf, char c);
+void print_BufStr(PrintBuf *buf, const char *str);
+void print_BufStrP(PrintBuf *buf, const char *str);
+void print_BufDec(PrintBuf *buf, uint32_t num, uint8_t width, char pad);
+void print_BufFlush(PrintBuf *buf);
+
 #endif //PRINTS_H
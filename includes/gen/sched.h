@@ -0,0 +1,213 @@
+/*
+ * File       : SCHED.H
+ * Version    : 1.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Interface for a small cooperative task scheduler. Each task is a function
+ * that does a bounded amount of work and returns, which is its yield point.
+ * The return value is the number of milliseconds until the task is ready to
+ * run again. Of the tasks that are ready, the one with the earliest deadline
+ * is run next. Time is kept by a 1 ms Timer0 compare interrupt.
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+/*
+ ******************************************************************************
+ *                                    MACROS
+ ******************************************************************************
+ */
+
+// max number of tasks that can be added with sched_AddTask.
+#ifndef SCHED_TASKS_MAX
+#define SCHED_TASKS_MAX      8
+#endif//SCHED_TASKS_MAX
+
+//
+// Timer0 runs in CTC mode with a prescaler of 64, so at F_CPU = 16 MHz it
+// counts every 4 us and SCHED_TICK_TOP + 1 counts is 1 ms.
+//
+#define SCHED_TICK_TOP       ((F_CPU / 64 / 1000) - 1)
+#define SCHED_US_PER_COUNT   (64000000UL / F_CPU)
+
+//
+// Returned by a task function to suspend the task until it is woken by
+// sched_Wake.
+//
+#define SCHED_SUSPEND        0xFFFF
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                  ERROR FLAGS
+ *
+ * Description : Flags returned by sched_AddTask.
+ * ----------------------------------------------------------------------------
+ */
+#define SCHED_SUCCESS        0x00
+#define SCHED_TASKS_FULL     0x01         // SCHED_TASKS_MAX already added
+
+/*
+ ******************************************************************************
+ *                                   STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                  TASK STRUCT
+ *
+ * Description : An instance of this struct is a task that can be run by the
+ *               scheduler. It is set by sched_AddTask.
+ *
+ * Members     : fn            - task function. It returns the ms until it is
+ *                               ready again, 0 if it has more work to do, or
+ *                               SCHED_SUSPEND.
+ *               name          - name printed by sched_PrintTrace. Points to
+ *                               program memory.
+ *               relDeadline   - ms after becoming ready by which the task
+ *                               should have been run.
+ *               release       - time (ms) at which the task becomes ready.
+ *               deadline      - release + relDeadline.
+ *               suspended     - 1 if waiting for sched_Wake.
+ *               runCnt        - times the task has been run.
+ *               missCnt       - runs that started after the deadline.
+ *               maxLatency    - most time (us) from becoming ready to being
+ *                               run.
+ *               maxRunTime    - most time (us) taken by one run of fn, i.e.
+ *                               the longest the task went without yielding.
+ *
+ * Warnings    : Members are set by sched_AddTask and updated by the 
+ *               scheduler. They should never be set manually.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint16_t (*fn)(void);
+  const char *name;
+  uint16_t relDeadline;
+  uint32_t release;
+  uint32_t deadline;
+  uint8_t  suspended;
+  uint32_t runCnt;
+  uint16_t missCnt;
+  uint32_t maxLatency;
+  uint32_t maxRunTime;
+}
+SchedTask;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         INITIALIZE SCHEDULER
+ *
+ * Description : Removes all tasks and starts the 1 ms Timer0 tick.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ *
+ * Notes       : Global interrupts must be enabled (sei) for time to advance.
+ * ----------------------------------------------------------------------------
+ */
+void sched_Init(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                     ADD TASK
+ *
+ * Description : Sets a task instance and adds it to the scheduler. The task
+ *               is ready to run immediately.
+ *
+ * Arguments   : task          - pointer to the SchedTask instance. It must
+ *                               exist for as long as the scheduler runs.
+ *               fn            - the task function.
+ *               name          - name of the task, for sched_PrintTrace. It
+ *                               must be in program memory, e.g. PSTR("name").
+ *               relDeadline   - ms after the task becomes ready by which it
+ *                               should have been run. Tasks with shorter
+ *                               deadlines are run first.
+ *
+ * Returns     : SCHED_SUCCESS or SCHED_TASKS_FULL.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t sched_AddTask(SchedTask *task, uint16_t (*fn)(void),
+                      const char *name, uint16_t relDeadline);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    WAKE TASK
+ *
+ * Description : Makes a task ready to run now, whether it was suspended or
+ *               waiting for its next release time.
+ *
+ * Arguments   : task   - pointer to the SchedTask instance.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sched_Wake(SchedTask *task);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          RUN NEXT TASK / RUN
+ *
+ * Description : sched_RunNext runs the ready task with the earliest deadline,
+ *               if any. sched_Run calls sched_RunNext forever.
+ *
+ * Arguments   : void
+ *
+ * Returns     : sched_RunNext returns 1 if a task was run, else 0.
+ *
+ * Notes       : Tasks are never pre-empted. A task that does not return
+ *               delays every other task, so long operations must be split
+ *               into steps, e.g. by using fat_CursorScanEntry with a sector
+ *               budget for a directory scan.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t sched_RunNext(void);
+void sched_Run(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        MILLISECONDS / MICROS
+ *
+ * Description : Returns the time since sched_Init in ms, or in us.
+ *
+ * Arguments   : void
+ *
+ * Returns     : time in ms or us.
+ *
+ * Notes       : sched_Micros has a resolution of SCHED_US_PER_COUNT.
+ * ----------------------------------------------------------------------------
+ */
+uint32_t sched_Millis(void);
+uint32_t sched_Micros(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          PRINT / RESET TRACE
+ *
+ * Description : sched_PrintTrace prints, for each task, the number of runs,
+ *               deadline misses, max latency and max run time.
+ *               sched_ResetTrace clears them.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sched_PrintTrace(void);
+void sched_ResetTrace(void);
+
+#endif //SCHED_H
@@ -46,6 +46,46 @@
 
 #define SPI_REG_BIT_LEN      8
 
+//
+// Devices on the SPI bus. Each device has its own chip select pin and its own
+// clock and mode profile, which is loaded into SPCR/SPSR when it is selected.
+//
+#define SPI_DEV_SD           0              // SD card on SS0
+#define SPI_DEV_VS_SCI       1              // VS1053 control interface, SS1
+#define SPI_DEV_VS_SDI       2              // VS1053 data interface, SS2
+#define SPI_DEV_CNT          3
+#define SPI_DEV_NONE         0xFF           // no device selected
+
+//
+// SPI clock divisors for spi_SetProfile. Bits 0 and 1 are SPR1:SPR0 of SPCR
+// and bit 2 is SPI2X of SPSR. At F_CPU = 16 MHz, SPI_CLK_DIV_2 is 8 MHz and 
+// SPI_CLK_DIV_128 is 125 KHz.
+//
+#define SPI_CLK_DIV_2        0x04
+#define SPI_CLK_DIV_4        0x00
+#define SPI_CLK_DIV_8        0x05
+#define SPI_CLK_DIV_16       0x01
+#define SPI_CLK_DIV_32       0x06
+#define SPI_CLK_DIV_64       0x02
+#define SPI_CLK_DIV_128      0x03
+
+// SPI modes for spi_SetProfile. CPOL and CPHA bits of SPCR.
+#define SPI_MODE_0           0x00
+#define SPI_MODE_1           (1 << CPHA)
+#define SPI_MODE_2           (1 << CPOL)
+#define SPI_MODE_3           (1 << CPOL | 1 << CPHA)
+
+//
+// Set to 1 to count every byte clocked through the SPI port. The count is
+// read with spi_GetByteCount and is used to measure the SPI traffic of higher
+// level operations (e.g. bytes per sector read). Off by default so that the
+// counter is not on the transmit path. MAKE.SH sets it for the AVR_FAT_TEST
+// build, whose 'stats' and 'bench' commands report it.
+//
+#ifndef SPI_BYTE_COUNTER
+#define SPI_BYTE_COUNTER     0
+#endif//SPI_BYTE_COUNTER
+
 /*
  ******************************************************************************
  *                              FUNCTION PROTOTYPES
@@ -65,6 +105,121 @@
  */
 void spi_MasterInit(void);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       SET SPI DEVICE PROFILE
+ * 
+ * Description : Sets the SPI mode and clock divisor that will be used each
+ *               time the device is selected by spi_Select.
+ * 
+ * Arguments   : dev      - SPI_DEV_SD, SPI_DEV_VS_SCI or SPI_DEV_VS_SDI.
+ *               mode     - SPI_MODE_0 to SPI_MODE_3.
+ *               clkDiv   - one of the SPI_CLK_DIV_n macros.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : If dev is currently selected the new profile is loaded 
+ *               immediately.
+ * ----------------------------------------------------------------------------
+ */
+void spi_SetProfile(uint8_t dev, uint8_t mode, uint8_t clkDiv);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      SET DEVICE RELEASE HOOK
+ * 
+ * Description : Sets a function that is called when dev is still selected 
+ *               and a different device is selected with spi_Select. This lets
+ *               a device finish a transaction that it holds its chip select 
+ *               for (e.g. an SD card read stream) before it loses the bus.
+ * 
+ * Arguments   : dev    - SPI_DEV_SD, SPI_DEV_VS_SCI or SPI_DEV_VS_SDI.
+ *               hook   - function to call, or 0 for none. It is called with 
+ *                        dev selected and should end by calling 
+ *                        spi_Deselect(dev).
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void spi_SetReleaseHook(uint8_t dev, void (*hook)(void));
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                 SELECT / DESELECT SPI DEVICE
+ * 
+ * Description : spi_Select loads the device's mode and clock profile and 
+ *               asserts (sets low) its chip select pin, de-asserting all of
+ *               the others. spi_Deselect de-asserts the device's chip select.
+ * 
+ * Arguments   : dev   - SPI_DEV_SD, SPI_DEV_VS_SCI or SPI_DEV_VS_SDI.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : 1) If another device is still selected when spi_Select is 
+ *                  called, that device's release hook is called first.
+ *               2) The bus is busy from spi_Select until spi_Deselect or 
+ *                  spi_Park. An interrupt routine that uses the bus must 
+ *                  check spi_IsBusy first.
+ * ----------------------------------------------------------------------------
+ */
+void spi_Select(uint8_t dev);
+void spi_Deselect(uint8_t dev);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              PARK SPI DEVICE
+ * 
+ * Description : Leaves the device selected but marks the bus as not busy, so
+ *               another device may be selected, in which case the parked
+ *               device's release hook is called first.
+ * 
+ * Arguments   : dev   - SPI_DEV_SD, SPI_DEV_VS_SCI or SPI_DEV_VS_SDI.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : Used by a device that holds its chip select between 
+ *               transactions (e.g. an SD card read stream). It must select
+ *               itself again with spi_Select before continuing, and must 
+ *               then check that its release hook was not called.
+ * ----------------------------------------------------------------------------
+ */
+void spi_Park(uint8_t dev);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              BUS BUSY / IDLE
+ * 
+ * Description : spi_IsBusy returns 1 if a device is selected and in the middle
+ *               of a transaction, else 0. spi_SetIdleHook sets a function that
+ *               is called by spi_Deselect and spi_Park when the bus stops 
+ *               being busy.
+ * 
+ * Arguments   : hook   - function to call, or 0 for none.
+ * 
+ * Returns     : spi_IsBusy returns 1 or 0.
+ * 
+ * Notes       : The idle hook lets work that an interrupt had to defer, 
+ *               because the bus was busy, run as soon as the bus is free. 
+ *               It may be called from within itself, and must guard against
+ *               this.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t spi_IsBusy(void);
+void spi_SetIdleHook(void (*hook)(void));
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      GET SELECTED SPI DEVICE
+ * 
+ * Description : Returns the device that is currently selected.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : SPI_DEV_SD, SPI_DEV_VS_SCI, SPI_DEV_VS_SDI or SPI_DEV_NONE.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t spi_GetSelected(void);
+
 /*
  * ----------------------------------------------------------------------------
  *                                                             SPI RECEIVE BYTE
@@ -91,4 +246,56 @@ uint8_t spi_MasterReceive(void);
  */
 void spi_MasterTransmit(uint8_t byte);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            SPI RECEIVE BLOCK
+ * 
+ * Description : Receives len bytes into buf, sending 0xFF for each one. 
+ * 
+ * Arguments   : buf   - pointer to the array to be loaded. Must be at least 
+ *                       length len.
+ *               len   - number of bytes to receive.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : The next 0xFF is loaded into SPDR as soon as the previous 
+ *               byte is read from it, and the byte is stored while the next
+ *               one is being transferred. Use this rather than calling
+ *               spi_MasterTransmit and spi_MasterReceive for each byte.
+ * ----------------------------------------------------------------------------
+ */
+void spi_ReceiveBlock(uint8_t buf[], uint16_t len);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           SPI TRANSMIT BLOCK
+ * 
+ * Description : Sends len bytes from buf. The received bytes are discarded.
+ * 
+ * Arguments   : buf   - pointer to the array of bytes to send.
+ *               len   - number of bytes to send.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : The next byte is loaded from buf while the previous one is
+ *               being transferred.
+ * ----------------------------------------------------------------------------
+ */
+void spi_TransmitBlock(const uint8_t buf[], uint16_t len);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           GET SPI BYTE COUNT
+ * 
+ * Description : Returns the number of bytes transmitted (and therefore also
+ *               received) by the SPI port since initialization. The counter
+ *               wraps around at 2^32.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : SPI byte count, or 0 if SPI_BYTE_COUNTER is not set.
+ * ----------------------------------------------------------------------------
+ */
+uint32_t spi_GetByteCount(void);
+
 #endif  //SPI_H
@@ -8,7 +8,12 @@
  * Author     : Joshua Fain
  * Copyright (c) 2020, 2021
  * 
- * Interface for interacting with the ATMega's USART0 port.
+ * Interface for interacting with the ATMega's USART0 port. Transmitted bytes
+ * are sent from a queue by the data register empty (UDRE) interrupt, so the
+ * print functions do not wait for each character to be sent. Received bytes
+ * are put in a queue by the receive complete (RXC) interrupt, so none are 
+ * lost while the firmware is busy, and a command line can be collected from
+ * it without blocking.
  */
 
 #ifndef USART0_H
@@ -27,6 +32,73 @@
 #define BAUD        9600                    // decimal baud rate
 #define UBRR_VALUE  ((F_CPU/16/BAUD) - 1)   // calculate value for UBRR
 
+//
+// Length of the transmit queue. Bytes passed to usart_Transmit are queued
+// and sent by the UDRE interrupt. Must be a power of 2, no more than 128.
+//
+#ifndef USART_TX_BUF_LEN
+#define USART_TX_BUF_LEN  64
+#endif//USART_TX_BUF_LEN
+
+#if (USART_TX_BUF_LEN & (USART_TX_BUF_LEN - 1)) || USART_TX_BUF_LEN > 128
+#error "USART_TX_BUF_LEN must be a power of 2, no more than 128"
+#endif
+
+//
+// Length of the receive queue. Bytes received while it is full are dropped.
+// Must be a power of 2, no more than 128.
+//
+#ifndef USART_RX_BUF_LEN
+#define USART_RX_BUF_LEN  32
+#endif//USART_RX_BUF_LEN
+
+#if (USART_RX_BUF_LEN & (USART_RX_BUF_LEN - 1)) || USART_RX_BUF_LEN > 128
+#error "USART_RX_BUF_LEN must be a power of 2, no more than 128"
+#endif
+
+// max number of chars, including the null, held by a UsartLine.
+#ifndef USART_LINE_MAX_CHAR
+#define USART_LINE_MAX_CHAR  100
+#endif//USART_LINE_MAX_CHAR
+
+// value of the backspace key on my keyboard, ascii 'del'.
+#define USART_BACKSPACE   127
+
+// returned by usart_PollLine
+#define USART_LINE_NONE       0             // line not finished yet
+#define USART_LINE_READY      1             // line finished by return
+#define USART_LINE_OVERFLOW   2             // line too long, chars dropped
+
+/*
+ ******************************************************************************
+ *                                   STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                  LINE STRUCT
+ *
+ * Description : Holds a command line while it is being typed. Used with
+ *               usart_PollLine.
+ *
+ * Members     : str           - the chars of the line. Null terminated when
+ *                               usart_PollLine returns USART_LINE_READY.
+ *               len           - number of chars in str.
+ *               overflow      - 1 if chars were dropped because str was full.
+ *               done          - 1 if the line was returned by the last call
+ *                               to usart_PollLine.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  char    str[USART_LINE_MAX_CHAR];
+  uint8_t len;
+  uint8_t overflow;
+  uint8_t done;
+}
+UsartLine;
+
 /*
  *******************************************************************************
  *                             FUNCTION PROTOTYPES
@@ -51,27 +123,138 @@ void usart_Init(void);
  * ----------------------------------------------------------------------------
  *                                                           USART RECEIVE BYTE
  *                                         
- * Description : Receives a byte using the USART0 on the ATmega target device.
+ * Description : Returns the next received byte from the receive queue. If the
+ *               queue is empty, waits until a byte is received.
  * 
  * Arguments   : void
  * 
- * Returns     : byte received by the USART0, i.e. value in UDR0.
+ * Returns     : byte received by the USART0.
  * ----------------------------------------------------------------------------
  */
 uint8_t usart_Receive(void);
 
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          USART RECEIVE READY
+ *                                         
+ * Description : Checks whether a received byte is waiting in the receive
+ *               queue, so that usart_Receive can be called without blocking.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : 1 if a byte has been received, else 0.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t usart_ReceiveReady(void);
+
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        USART RECEIVE DROPPED
+ *                                         
+ * Description : Returns the number of received bytes that were dropped 
+ *               because the receive queue was full, and clears the count.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : number of dropped bytes, up to 255.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t usart_ReceiveDropped(void);
+
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       INITIALIZE / POLL LINE
+ *                                         
+ * Description : usart_InitLine empties a line. usart_PollLine adds the 
+ *               received bytes to the line, echoing them, until return is 
+ *               received or the receive queue is empty. Never waits.
+ * 
+ * Arguments   : line     pointer to a UsartLine instance.
+ * 
+ * Returns     : usart_PollLine returns USART_LINE_NONE if return has not been 
+ *               received yet, else USART_LINE_READY, or USART_LINE_OVERFLOW if 
+ *               chars were dropped because the line was full.
+ * 
+ * Notes       : 1) USART_BACKSPACE or '\b' removes the last char. Other non-
+ *                  printable chars are ignored.
+ *               2) When a line is returned, line->str is null terminated and
+ *                  holds until the next call to usart_PollLine, which starts
+ *                  a new line.
+ * ----------------------------------------------------------------------------
+ */
+void usart_InitLine(UsartLine *line);
+uint8_t usart_PollLine(UsartLine *line);
+
+
 /*
  * ----------------------------------------------------------------------------
  *                                                          USART TRANSMIT BYTE
  *                                       
- * Description : Sends a byte to another device via the USART0.
+ * Description : Queues a byte to be sent by USART0. If the transmit queue is
+ *               full, waits until there is room.
  * 
  * Arguments   : data     byte to sent via USART0.
  * 
  * Returns     : void
+ * 
+ * Notes       : 1) Bytes are sent from the queue by the UDRE interrupt, so 
+ *                  this returns as soon as the byte is queued. Global 
+ *                  interrupts must be enabled (sei) for this.
+ *               2) If called with global interrupts disabled and the queue
+ *                  is full, queued bytes are sent here by polling, so that
+ *                  this does not wait forever.
  * ----------------------------------------------------------------------------
  */
 void usart_Transmit(uint8_t data);
 
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      USART TRY TRANSMIT BYTE
+ *                                       
+ * Description : Queues a byte to be sent by USART0 if there is room in the 
+ *               transmit queue. Never waits.
+ * 
+ * Arguments   : data     byte to sent via USART0.
+ * 
+ * Returns     : 1 if the byte was queued, 0 if the queue was full.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t usart_TryTransmit(uint8_t data);
+
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    USART TRANSMIT QUEUE ROOM
+ *                                       
+ * Description : Returns the number of bytes that can be queued without 
+ *               waiting.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : free bytes in the transmit queue.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t usart_TxRoom(void);
+
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                  USART FLUSH
+ *                                       
+ * Description : Waits until every queued byte has been sent.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : void
+ * 
+ * Notes       : Call before anything that stops the UDRE interrupt from 
+ *               running for a long time, e.g. a reset or sleep.
+ * ----------------------------------------------------------------------------
+ */
+void usart_Flush(void);
+
 #endif //USART0_H
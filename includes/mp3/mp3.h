@@ -1,60 +1,108 @@
 /*
- *
- * File       : MP3_TEST.H
- * Author     : Joshua Fain
+ * File       : MP3.H
+ * Version    : 1.0
  * Target     : ATMega1280
  * Compiler   : AVR-GCC 9.3.0
  * Downloader : AVRDUDE 6.3
  * License    : GNU GPLv3
  * Author     : Joshua Fain
  * Copyright (c) 2020, 2021
- * 
- * DESCRIPTION: 
  *
+ * Interface for the VS1053 audio decoder. The decoder's control interface
+ * (SCI) and data interface (SDI) share the AVR's SPI port with the SD card.
+ * Audio files are read from the FAT volume with fat_Read into a ring buffer
+ * of 32 byte chunks, which are sent to the SDI by the DREQ pin's interrupt
+ * whenever the decoder signals it can take them.
  */
 
 #ifndef MP3_H
 #define MP3_H
 
-/* 
+#include "spi.h"
+#include "fat_bpb.h"
+#include "fat.h"
+
+/*
+ ******************************************************************************
+ *                                    MACROS
+ ******************************************************************************
+ */
+
+/*
  * ----------------------------------------------------------------------------
  *                                                                  CHIP SELECT
  *
- * Description : defines the SPI port's chip select pin for the SD card.
- * 
+ * Description : defines the SPI port's chip select pins for the VS1053. XCS
+ *               selects the control interface (SCI) and XDCS selects the data
+ *               interface (SDI).
+ *
  * Notes       : 1) Assert by setting CS low. De-Assert by setting CS high.
- *               2) SSO, defined in SPI.H, is used here as the CS pin.
- *               3) SPI.H also defines a second SS pin (SS1) for connecting 
- *                  multiple devices to the SPI port of the AVR. Therefore, 
- *                  this MACRO must also ensure the SS1 pin is de-asserted 
- *                  (set high) when SS0 is asserted (set low).
+ *               2) SS1 and SS2, defined in SPI.H, are used as the XCS and
+ *                  XDCS pins.
+ *               3) The chip selects are owned by the SPI bus functions in
+ *                  SPI.H, which load the SCI or SDI clock profile and stop an
+ *                  open SD card read stream before the pin is asserted.
  * ----------------------------------------------------------------------------
  */
-#define XCS_ASSERT      SPI_PORT = ((SPI_PORT & ~(1 << SS1)) | (1 << SS0)      \
-                                   | (1 << SS2));
-#define XCS_DEASSERT    SPI_PORT |= (1 << SS1);
+#define XCS_ASSERT      spi_Select(SPI_DEV_VS_SCI);
+#define XCS_DEASSERT    spi_Deselect(SPI_DEV_VS_SCI);
 
-#define XDCS_ASSERT     SPI_PORT = ((SPI_PORT & ~(1 << SS2)) | (1 << SS0)      \
-                                   | (1 << SS1));
-#define XDCS_DEASSERT   SPI_PORT |= (1 << SS2);
+#define XDCS_ASSERT     spi_Select(SPI_DEV_VS_SDI);
+#define XDCS_DEASSERT   spi_Deselect(SPI_DEV_VS_SDI);
 
+//
+// SPI clock divisors for the VS1053. SCI reads and writes must be clocked at
+// less than CLKI / 7 and SDI writes at less than CLKI / 4. Following reset,
+// CLKI = XTALI = 12.288 MHz, so the limits are 1.75 MHz and 3.07 MHz, and
+// SCI is clocked at F_CPU / 16 = 1 MHz and SDI at F_CPU / 8 = 2 MHz. Once 
+// SCI_CLOCKF is set to VS_CLOCKF_VAL, CLKI is 43 MHz, and the FAST divisors
+// are used.
+//
+#ifndef VS_SCI_CLK_DIV
+#define VS_SCI_CLK_DIV  SPI_CLK_DIV_16
+#endif//VS_SCI_CLK_DIV
 
+#ifndef VS_SDI_CLK_DIV
+#define VS_SDI_CLK_DIV  SPI_CLK_DIV_8
+#endif//VS_SDI_CLK_DIV
+
+#ifndef VS_SCI_FAST_CLK_DIV
+#define VS_SCI_FAST_CLK_DIV  SPI_CLK_DIV_4
+#endif//VS_SCI_FAST_CLK_DIV
+
+#ifndef VS_SDI_FAST_CLK_DIV
+#define VS_SDI_FAST_CLK_DIV  SPI_CLK_DIV_2
+#endif//VS_SDI_FAST_CLK_DIV
+
+// Hardware reset pin
 #define XRESET           PD0
 #define HW_RST_ASSERT    PORTD = (PORTD & ~(1 << XRESET));
 #define HW_RST_DEASSERT  PORTD |= (1 << XRESET);
 
-#define DREQ     PIND1 
-
-
+//
+// Data request pin. DREQ is high when the decoder can take at least 32 bytes
+// of SDI data or an SCI command.
+//
+#define DREQ             PIND1
+#define DREQ_HIGH        (PIND & (1 << DREQ))
 
+//
+// Number of times DREQ is polled before giving up. At F_CPU = 16 MHz one poll
+// takes about 0.5 us, so this is roughly 30 ms, which is longer than the
+// decoder's reset time.
+//
+#define DREQ_TIMEOUT_LIMIT     0xFFFF
 
+// SCI instructions
+#define VS_INS_READ      0x03
+#define VS_INS_WRITE     0x02
 
 //SCI Registers
 #define VS_SCI_MODE		  0x00	//RW	Mode control
 #define VS_SCI_STATUS	  0x01	//RW	Status
 #define VS_SCI_BASS		  0x02	//RW	Built-in bass enhancer
 #define VS_SCI_CLOCKF	  0x03	//RW	Clock freq+doubler
-#define VS_SCI_DEC_TIME	0x04	//R		Decode time in seconds 
+#define VS_SCI_DEC_TIME	0x04	//R		Decode time in seconds
 #define VS_SCI_AUDATA	  0x05	//RW	Misc. audio data
 #define VS_SCI_WRAM		  0x06	//RW	RAM write
 #define VS_SCI_WRAMADDR	0x07	//RW	Base address for RAM write
@@ -73,6 +121,7 @@
 #define SM_LAYER12      0x0002    // Allow MPEG layers I & II
 #define SM_RESET        0x0004    // Soft reset
 #define SM_OUTOFWAV     0x0008    // Jump out of WAV decoding
+#define SM_CANCEL       0x0008    // Cancel decoding current file (VS1053)
 #define SM_SETTOZERO1   0x0010    // Set to zero
 #define SM_TESTS        0x0020    // Allow SDI tests
 #define SM_STREAM       0x0040    // Stream mode
@@ -83,10 +132,294 @@
 #define SM_SDINEW       0x0800    // VS1002 native SPI modes
 #define SM_SETTOZERO3   0x1000    // Set to zero
 #define SM_SETTOZERO4   0x2000    // Set to zero
- 
 
-void VSReset(void);
-void VSSCIWrite(unsigned char ad, unsigned short data);
-void VSSDITransfer(unsigned int len, unsigned char *spi_buf);
+//
+// SCI_CLOCKF value set by vs_Init. SC_MULT = 3.5x, giving CLKI = 43 MHz, and
+// SC_ADD = 1.0x, which lets the decoder raise CLKI to 4.5x when it needs to.
+//
+#ifndef VS_CLOCKF_VAL
+#define VS_CLOCKF_VAL   0x8800
+#endif//VS_CLOCKF_VAL
+
+// Volume set by vs_Init. 0x00 is loudest, 0xFE is silent, per channel.
+#ifndef VS_DEFAULT_VOL
+#define VS_DEFAULT_VOL  0x20
+#endif//VS_DEFAULT_VOL
+
+// SDI data is sent in chunks of this many bytes, each time DREQ is high.
+#define VS_SDI_CHUNK_LEN       32
+
+//
+// WRAM address of the endFillByte parameter. This byte is sent following the
+// end of a file to flush the decoder.
+//
+#define VS_END_FILL_BYTE_ADDR  0x1E06
+
+// Number of endFillBytes sent when a file ends, and when cancelling.
+#define VS_END_FILL_LEN        2052
+#define VS_CANCEL_FILL_MAX     2048
+
+//
+// Number of VS_SDI_CHUNK_LEN byte chunks in the ring buffer between the SD
+// card and the decoder. Must be a power of 2, no more than 128. The ring 
+// must hold enough audio to cover the longest time the main loop can go
+// without refilling it, e.g. the slowest SD card read. Use the watermarks 
+// returned by vs_GetFeedStats to check this.
+//
+#ifndef VS_RING_CHUNKS
+#define VS_RING_CHUNKS         16
+#endif//VS_RING_CHUNKS
+
+#if (VS_RING_CHUNKS & (VS_RING_CHUNKS - 1)) || VS_RING_CHUNKS > 128
+#error "VS_RING_CHUNKS must be a power of 2, no more than 128"
+#endif
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                  ERROR FLAGS
+ *
+ * Description : Flags returned by the VS1053 functions.
+ * ----------------------------------------------------------------------------
+ */
+#define VS_SUCCESS             0x00
+#define VS_DREQ_TIMEOUT        0x01         // DREQ never went high
+#define VS_FILE_READ_ERROR     0x02         // fat_Read failed
+#define VS_CANCEL_FAILED       0x04         // SM_CANCEL was not cleared
+#define VS_PLAYING             0x08         // playback is not finished
+
+/*
+ ******************************************************************************
+ *                                   STRUCTS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          SDI FEED STATISTICS
+ *
+ * Description : Counters kept by the DREQ interrupt feeder, returned by 
+ *               vs_GetFeedStats.
+ *
+ * Members     : underruns   - number of times DREQ was high while the ring
+ *                             buffer was empty and the file was still 
+ *                             being read. The decoder's own FIFO may still
+ *                             be playing, but is no longer being refilled.
+ *               highWater   - most chunks that were in the ring buffer.
+ *               lowWater    - fewest chunks that were in the ring buffer 
+ *                             when a chunk was sent to the decoder.
+ *
+ * Notes       : underruns and lowWater are only kept once the decoder's 
+ *               FIFO has been filled at the start of a file.
+ *               chunksFed   - number of chunks sent to the decoder.
+ *               deferred    - number of times the feeder could not send a
+ *                             chunk because the SPI port was busy.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint16_t underruns;
+  uint8_t  highWater;
+  uint8_t  lowWater;
+  uint32_t chunksFed;
+  uint16_t deferred;
+} VSFeedStats;
+
+/*
+ ******************************************************************************
+ *                            FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           INITIALIZE DECODER
+ *
+ * Description : Sets the XRESET and DREQ pins, resets the decoder and sets
+ *               SCI_MODE, SCI_CLOCKF and the volume. The SCI and SDI SPI
+ *               profiles are then raised to the FAST clock divisors.
+ *
+ * Arguments   : void
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ *
+ * Notes       : spi_MasterInit must be called first.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_Init(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        HARDWARE / SOFT RESET
+ *
+ * Description : vs_HardReset pulses XRESET low. vs_SoftReset sets SM_RESET in
+ *               SCI_MODE. Both then wait for DREQ to go high.
+ *
+ * Arguments   : void
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ *
+ * Notes       : CLKI returns to XTALI after either reset, so the SCI and SDI
+ *               SPI profiles are set back to the slow clock divisors.
+ *               vs_SoftReset restores SCI_CLOCKF and the fast profiles after
+ *               the reset completes.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_HardReset(void);
+uint8_t vs_SoftReset(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        WAIT FOR DATA REQUEST
+ *
+ * Description : Waits until the decoder sets DREQ high.
+ *
+ * Arguments   : void
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_WaitDREQ(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    WRITE / READ SCI REGISTER
+ *
+ * Description : Writes val to, or reads the value of, the SCI register at
+ *               addr.
+ *
+ * Arguments   : addr   - SCI register address, VS_SCI_MODE to VS_SCI_AICTRL3.
+ *               val    - 16-bit value to write.
+ *
+ * Returns     : vs_WriteSCI returns void. vs_ReadSCI returns the register
+ *               value.
+ *
+ * Notes       : Both wait for DREQ before the command is sent.
+ * ----------------------------------------------------------------------------
+ */
+void vs_WriteSCI(uint8_t addr, uint16_t val);
+uint16_t vs_ReadSCI(uint8_t addr);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                               WRITE SDI DATA
+ *
+ * Description : Sends len bytes of audio data to the decoder's SDI. The data
+ *               is sent in chunks of up to VS_SDI_CHUNK_LEN bytes, waiting
+ *               for DREQ before each chunk.
+ *
+ * Arguments   : data   - pointer to the array of data to send.
+ *               len    - number of bytes to send.
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_WriteSDI(const uint8_t data[], uint16_t len);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                   SET VOLUME
+ *
+ * Description : Sets the left and right channel volume.
+ *
+ * Arguments   : left    - left channel attenuation. 0x00 is loudest and 0xFE
+ *                         is silent, in 0.5 dB steps.
+ *               right   - right channel attenuation.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void vs_SetVolume(uint8_t left, uint8_t right);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    PLAY FILE
+ *
+ * Description : Streams an open file to the decoder from its current
+ *               position until the end of the file, then sends the
+ *               endFillBytes needed for the decoder to finish the file.
+ *
+ * Arguments   : file   - pointer to a FatFile instance opened by fat_Open.
+ *               bpb    - pointer to the BPB struct instance.
+ *
+ * Returns     : VS_SUCCESS, or VS_DREQ_TIMEOUT or VS_FILE_READ_ERROR if the
+ *               file could not be played to the end.
+ *
+ * Notes       : Returns only when the whole file has been sent. This is 
+ *               vs_PlayStart followed by calls to vs_PlayRefill.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_PlayFile(FatFile *file, const BPB *bpb);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   START / REFILL / STOP PLAY
+ *
+ * Description : Non-blocking playback. vs_PlayStart fills the ring buffer 
+ *               from the file and enables the DREQ interrupt (INT1), which
+ *               sends a chunk from the ring buffer to the decoder each time
+ *               DREQ is high. vs_PlayRefill must then be called from the 
+ *               main loop to keep the ring buffer full. vs_PlayStop disables
+ *               the interrupt and empties the ring buffer.
+ *
+ * Arguments   : file   - pointer to a FatFile instance opened by fat_Open.
+ *                        It must remain open until playback is finished.
+ *               bpb    - pointer to the BPB struct instance.
+ *
+ * Returns     : vs_PlayStart and vs_PlayRefill return VS_PLAYING until the
+ *               file and the endFillBytes have all been sent to the decoder,
+ *               then VS_SUCCESS, or VS_FILE_READ_ERROR if the file could not
+ *               be read, which also stops playback. 
+ *
+ * Notes       : 1) Global interrupts must be enabled (sei) for the feeder
+ *                  to run from the interrupt. Each vs_PlayRefill also sends
+ *                  any chunks the decoder can take.
+ *               2) The ring buffer is a single-producer/single-consumer 
+ *                  queue: only vs_PlayRefill adds chunks and only the 
+ *                  feeder removes them, so no locking is needed.
+ *               3) If the SPI port is busy when DREQ goes high, e.g. during
+ *                  an SD card read, the feed runs as soon as the port is 
+ *                  free. See spi_SetIdleHook.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_PlayStart(FatFile *file, const BPB *bpb);
+uint8_t vs_PlayRefill(const BPB *bpb);
+void vs_PlayStop(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  GET / RESET FEED STATISTICS
+ *
+ * Description : vs_GetFeedStats copies the DREQ feeder's counters to stats.
+ *               vs_ResetFeedStats clears them.
+ *
+ * Arguments   : stats   - pointer to a VSFeedStats instance.
+ *
+ * Returns     : void
+ *
+ * Notes       : A lowWater that reaches 0, or any underruns, means the ring
+ *               buffer is too small (VS_RING_CHUNKS) for the SD card's 
+ *               worst-case read latency at the file's bitrate.
+ * ----------------------------------------------------------------------------
+ */
+void vs_GetFeedStats(VSFeedStats *stats);
+void vs_ResetFeedStats(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              CANCEL PLAYBACK
+ *
+ * Description : Stops decoding of the current stream following the
+ *               procedure in the VS1053 datasheet: SM_CANCEL is set and
+ *               endFillBytes are sent until the decoder clears it. If it is
+ *               not cleared, the decoder is soft reset.
+ *
+ * Arguments   : void
+ *
+ * Returns     : VS_SUCCESS, or VS_CANCEL_FAILED if a soft reset was needed.
+ *
+ * Notes       : Playback started by vs_PlayStart is stopped first.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_CancelPlayback(void);
 
-#endif // MP3_H
\ No newline at end of file
+#endif //MP3_H
@@ -78,15 +78,95 @@
  * 
  * Notes       : 1) Assert by setting CS low. De-Assert by setting CS high.
  *               2) SSO, defined in SPI.H, is used here as the CS pin.
- *               3) SPI.H also defines additional SS pins (SS1 and SS2) for 
- *                  connecting multiple devices to the SPI port of the AVR. 
- *                  Therefore, this MACRO must also ensure the other SS pins 
- *                  are de-asserted (set high) when SS0 is asserted (set low).
+ *               3) The chip selects are owned by the SPI bus functions in 
+ *                  SPI.H. Selecting the SD card loads its clock and mode 
+ *                  profile and de-asserts the other SS pins (SS1 and SS2).
  * ----------------------------------------------------------------------------
  */
-#define CS_SD_LOW       SPI_PORT = ((SPI_PORT & ~(1 << SS0)) | (1 << SS1)     \
-                                   | (1 << SS2));
-#define CS_SD_HIGH      SPI_PORT |=  (1 << SS0);
+#define CS_SD_LOW       spi_Select(SPI_DEV_SD);
+#define CS_SD_HIGH      spi_Deselect(SPI_DEV_SD);
+
+//
+// SPI clock divisors used for the SD card. The card must be clocked at 100 to
+// 400 KHz during initialization. Once initialized it can be clocked at up to
+// 25 MHz, so the fastest AVR rate, F_CPU / 2, is used.
+//
+#ifndef SD_INIT_CLK_DIV
+#define SD_INIT_CLK_DIV SPI_CLK_DIV_64
+#endif//SD_INIT_CLK_DIV
+
+#ifndef SD_CLK_DIV
+#define SD_CLK_DIV      SPI_CLK_DIV_2
+#endif//SD_CLK_DIV
+
+//
+// Limits of the waits for the card's start block token, the busy state that
+// follows STOP_TRANSMISSION, and the busy state while a block is written, as
+// a number of bytes clocked. The card may take up to 100 ms to send a start
+// token or end the STOP_TRANSMISSION busy state, and up to 250 ms to write a
+// block. The limits are sized for F_CPU / 2, at which a byte takes 16 CPU 
+// cycles, so they last at least as long at any slower divisor.
+//
+#define SD_BYTES_PER_MS        (F_CPU / 16 / 1000)
+#define SD_READ_TIMEOUT_BYTES  (100UL * SD_BYTES_PER_MS)
+#define SD_WRITE_TIMEOUT_BYTES (250UL * SD_BYTES_PER_MS)
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                            COMMAND WAIT MODE
+ * 
+ * Description : Sets what sd_SendCommand does before sending a command.
+ * 
+ * Modes       : SD_WAIT_READY   - poll the card until it returns DMY_TKN 
+ *                                 (0xFF), i.e. it is not busy, then send the
+ *                                 command at once. Gives up after 
+ *                                 SD_READY_TIMEOUT bytes and sends anyway.
+ *               SD_WAIT_DELAY   - always clock SD_CMD_DELAY_CLKS dummy clock
+ *                                 cycles first. This is the original 
+ *                                 behavior, kept for cards that are found to
+ *                                 be unstable without it.
+ * 
+ * Notes       : The mode can be changed at run time with sd_SetCmdWaitMode.
+ *               SD_CMD_WAIT_MODE sets the mode used at start up.
+ * ----------------------------------------------------------------------------
+ */
+#define SD_WAIT_READY          0
+#define SD_WAIT_DELAY          1
+
+#ifndef SD_CMD_WAIT_MODE
+#define SD_CMD_WAIT_MODE       SD_WAIT_READY
+#endif//SD_CMD_WAIT_MODE
+
+#define SD_CMD_DELAY_CLKS      80
+#define SD_READY_TIMEOUT       0x0FFF
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                     COMMAND LATENCY COUNTERS
+ * 
+ * Description : Commands are counted in the following groups by 
+ *               sd_SendCommand. The group numbers index the arrays of 
+ *               SDCmdStats.
+ * 
+ * Notes       : 1) Set SD_CMD_STATS to 1 to build the counters. MAKE.SH
+ *                  sets it for the AVR_FAT_TEST build, whose 'stats' 
+ *                  command prints them.
+ *               2) The counters are not updated atomically. sd_StopReadStream
+ *                  sends a command and can be called from the VS1053 DREQ 
+ *                  interrupt through the SPI release hook, so leave them out
+ *                  of builds that play audio.
+ * ----------------------------------------------------------------------------
+ */
+#ifndef SD_CMD_STATS
+#define SD_CMD_STATS           0
+#endif//SD_CMD_STATS
+
+#define SD_STAT_READ_SINGLE    0            // READ_SINGLE_BLOCK (CMD17)
+#define SD_STAT_READ_MULTIPLE  1            // READ_MULTIPLE_BLOCK (CMD18)
+#define SD_STAT_WRITE          2            // WRITE_BLOCK (CMD24)
+#define SD_STAT_STOP           3            // STOP_TRANSMISSION (CMD12)
+#define SD_STAT_OTHER          4            // all other commands
+#define SD_STAT_GROUP_CNT      5
 
 /* 
  * ----------------------------------------------------------------------------
@@ -149,6 +229,31 @@ typedef struct CardTypeVersion{
     uint8_t type;
 } CTV;
 
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                        COMMAND LATENCY STATS
+ * 
+ * Members  : 1) cmdCnt     - number of commands sent in each group.
+ *            2) waitBytes  - bytes clocked by sd_SendCommand before the 
+ *                            commands of each group were sent, i.e. the 
+ *                            ready poll or fixed delay.
+ *            3) r1Bytes    - bytes clocked by sd_GetR1 until the R1 response
+ *                            to the commands of each group was received.
+ *            4) readyTimeouts - number of ready polls that timed out.
+ * 
+ * Notes    : Arrays are indexed by the SD_STAT_ group numbers. Multiply a 
+ *            byte count by 8 for the number of SPI clock cycles.
+ * ----------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint32_t cmdCnt[SD_STAT_GROUP_CNT];
+  uint32_t waitBytes[SD_STAT_GROUP_CNT];
+  uint32_t r1Bytes[SD_STAT_GROUP_CNT];
+  uint32_t readyTimeouts;
+}
+SDCmdStats;
+
 /*
  ******************************************************************************
  *                           FUNCTION PROTOTYPES
@@ -186,8 +291,9 @@ uint32_t sd_InitModeSPI(CTV *ctv);
  * 
  * Notes       : 1) Call as many times as required to send the complete data 
  *                  packet, token, command, etc...
- *               2) This function and sd_ReceiveByteSPI(), are the only direct
- *                  SPI interfacing functions in the SD card module.
+ *               2) This function, sd_ReceiveByteSPI() and the block functions
+ *                  are the only direct SPI interfacing functions in the SD 
+ *                  card module.
  * ----------------------------------------------------------------------------
  */
 void sd_SendByteSPI(uint8_t byte);
@@ -204,12 +310,36 @@ void sd_SendByteSPI(uint8_t byte);
  * 
  * Notes       : 1) Call as many times as necessary to get the complete data
  *                  packet, token, error response, etc... from the SD card.
- *               2) This function and sd_SendByteSPI(), are the only direct
- *                  SPI interfacing functions in the SD card module.
+ *               2) This function, sd_SendByteSPI() and the block functions
+ *                  are the only direct SPI interfacing functions in the SD 
+ *                  card module.
  * ----------------------------------------------------------------------------
  */
 uint8_t sd_ReceiveByteSPI(void);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    RECEIVE / SEND DATA BLOCK
+ * 
+ * Description : Receives len bytes from the SD card into arr, or sends len 
+ *               bytes from arr to the SD card, via SPI.
+ * 
+ * Arguments   : arr   - pointer to the array to be loaded or sent.
+ *               len   - number of bytes. Normally BLOCK_LEN.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : 1) Used for the data bytes of block reads and writes. These
+ *                  use spi_ReceiveBlock and spi_TransmitBlock, which do not 
+ *                  make a function call for every byte.
+ *               2) These, sd_SendByteSPI() and sd_ReceiveByteSPI() are the 
+ *                  only direct SPI interfacing functions in the SD card 
+ *                  module.
+ * ----------------------------------------------------------------------------
+ */
+void sd_ReceiveBlockSPI(uint8_t arr[], uint16_t len);
+void sd_SendBlockSPI(const uint8_t arr[], uint16_t len);
+
 /*
  * ----------------------------------------------------------------------------
  *                                                                 SEND COMMAND
@@ -220,10 +350,57 @@ uint8_t sd_ReceiveByteSPI(void);
  *               arg   - 32-bit argument to be sent with the SD command.
  * 
  * Returns     : void
+ * 
+ * Notes       : Before the command is sent, the card is polled until it is
+ *               ready or a fixed delay is clocked, according to the command
+ *               wait mode. STOP_TRANSMISSION is sent without a ready poll as
+ *               the card is sending data when it is needed.
  * ----------------------------------------------------------------------------
  */
 void sd_SendCommand(uint8_t cmd, uint32_t arg);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        SET COMMAND WAIT MODE
+ * 
+ * Description : Sets what sd_SendCommand does before sending a command.
+ * 
+ * Arguments   : mode   - SD_WAIT_READY or SD_WAIT_DELAY.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sd_SetCmdWaitMode(uint8_t mode);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        GET COMMAND WAIT MODE
+ * 
+ * Description : Returns the current command wait mode.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : SD_WAIT_READY or SD_WAIT_DELAY.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t sd_GetCmdWaitMode(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                            GET / RESET COMMAND LATENCY STATS
+ * 
+ * Description : Copies the command latency counters into st, or clears them.
+ * 
+ * Arguments   : st   - Pointer to an SDCmdStats instance to be loaded.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : The counters are only updated if SD_CMD_STATS is set.
+ * ----------------------------------------------------------------------------
+ */
+void sd_GetCmdStats(SDCmdStats *st);
+void sd_ResetCmdStats(void);
+
 /*
  * ----------------------------------------------------------------------------
  *                                                              GET R1 RESPONSE
@@ -82,6 +82,7 @@
  */
 #define START_TOKEN_TIMEOUT            0x0200
 #define READ_SUCCESS                   0x0400
+#define READ_STREAM_CLOSED             0x0800
 
 /* 
  * ----------------------------------------------------------------------------
@@ -152,6 +153,104 @@
  */
 uint16_t sd_ReadSingleBlock(uint32_t blckAddr, uint8_t blckArr[]);
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         READ MULTIPLE BLOCKS
+ * 
+ * Description : Reads consecutive data blocks from the SD card into an array
+ *               using a single READ_MULTIPLE_BLOCK command.
+ * 
+ * Arguments   : startBlckAddr   - address of the first data block on the SD
+ *                                 card that will be read into the array.
+ *               blckCnt         - number of consecutive blocks to read.
+ *               blcksArr        - pointer to the array to be loaded with the
+ *                                 contents of the data blocks. Must be length
+ *                                 blckCnt * BLOCK_LEN.
+ * 
+ * Returns     : Read Block Error (upper byte) and R1 Response (lower byte).
+ * 
+ * Notes       : The transmission is ended with STOP_TRANSMISSION after the
+ *               last block, so only one command and one stop are sent for 
+ *               all of the blocks.
+ * ----------------------------------------------------------------------------
+ */
+uint16_t sd_ReadMultipleBlocks(uint32_t startBlckAddr, uint16_t blckCnt, 
+                               uint8_t blcksArr[]);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            START READ STREAM
+ * 
+ * Description : Sends READ_MULTIPLE_BLOCK and leaves the SD card selected and
+ *               sending data blocks, beginning at startBlckAddr, until 
+ *               sd_StopReadStream is called.
+ * 
+ * Arguments   : startBlckAddr   - address of the first data block that will
+ *                                 be read from the stream.
+ * 
+ * Returns     : Read Block Error (upper byte) and R1 Response (lower byte).
+ * 
+ * Notes       : 1) Any stream that is already open is stopped first.
+ *               2) The SD card's CS remains asserted while the stream is 
+ *                  open, but the card is parked (see spi_Park) between 
+ *                  reads. If another device on the SPI port is selected, 
+ *                  the stream is stopped by the SD card's release hook.
+ *                  sd_StopReadStream must be called before any other
+ *                  command is sent to the card.
+ * ----------------------------------------------------------------------------
+ */
+uint16_t sd_StartReadStream(uint32_t startBlckAddr);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      READ BLOCKS FROM STREAM
+ * 
+ * Description : Reads the next blckCnt data blocks from an open read stream
+ *               into an array.
+ * 
+ * Arguments   : blckCnt    - number of blocks to read.
+ *               blcksArr   - pointer to the array to be loaded with the
+ *                            contents of the data blocks. Must be length
+ *                            blckCnt * BLOCK_LEN.
+ * 
+ * Returns     : Read Block Error (upper byte) and R1 Response (lower byte).
+ *               READ_STREAM_CLOSED is returned if no stream is open.
+ * 
+ * Notes       : READ_STREAM_CLOSED is also returned if the stream was stopped
+ *               because another device used the SPI port since the last 
+ *               read. The caller should start the stream again.
+ * ----------------------------------------------------------------------------
+ */
+uint16_t sd_ReadStreamBlocks(uint16_t blckCnt, uint8_t blcksArr[]);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                             STOP READ STREAM
+ * 
+ * Description : Ends an open read stream and de-asserts the SD card's CS.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : void
+ * 
+ * Notes       : Does nothing if no stream is open. 
+ * ----------------------------------------------------------------------------
+ */
+void sd_StopReadStream(void);
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          IS READ STREAM OPEN
+ * 
+ * Description : Returns 1 if a read stream is open, else 0.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : 1 or 0
+ * ----------------------------------------------------------------------------
+ */
+uint8_t sd_IsReadStreamOpen(void);
+
 /*
  * ----------------------------------------------------------------------------
  *                                                           PRINT SINGLE BLOCK
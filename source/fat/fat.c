@@ -18,6 +18,9 @@
 #include "prints.h"
 #include "usart0.h"
 #include "fat_to_disk_if.h"
+#include "fat_cache.h"
+#include "fat_arena.h"
+#include "fat_index.h"
 
 /*
  ******************************************************************************
@@ -30,11 +33,40 @@ static void pvt_UpdateFatEntryMembers(FatEntry *ent, const char lnStr[],
                 uint8_t snEntSecNumInClus, uint32_t snEntClusIndx);
 static uint8_t pvt_CheckName(const char nameStr[]);
 static uint8_t pvt_SetDirToParent(FatDir *dir, const BPB *bpb);
-static void pvt_LoadLongName(int lnFirstEnt, int lnLastEnt, 
-                             const uint8_t secArr[], char lnStr[]);
-static uint32_t pvt_GetNextClusIndex(uint32_t clusIndex, const BPB *bpb);
+static void pvt_PrependLongName(const uint8_t lnEnt[], char lnStr[]);
+static uint8_t pvt_CursorScan(FatCursor *cur, FatEntryRef *ref, char lnStr[],
+                              uint8_t *secBudget, const BPB *bpb);
+static uint8_t pvt_GetRefEntry(uint32_t clusIndx, uint8_t secNumInClus, 
+                               uint16_t entPos, const uint8_t **entArr, 
+                               const BPB *bpb);
+static void pvt_LoadShortName(const uint8_t snEnt[], char snStr[]);
+static uint8_t pvt_GetShortNameChkSum(const uint8_t snEnt[]);
+static uint8_t pvt_LoadLongNameChars(const uint8_t lnEnt[], char entStr[]);
+static uint8_t pvt_GetLongNameLen(const FatEntryRef *ref, uint16_t *lnLen,
+                                  const BPB *bpb);
+static uint8_t pvt_NextRefEntPos(uint32_t *clusIndx, uint8_t *secNumInClus,
+                                 uint16_t *entPos, const BPB *bpb);
+static uint32_t pvt_GetEntFstClus(const uint8_t snEnt[]);
+static uint32_t pvt_GetEntFileSize(const uint8_t snEnt[]);
+static uint16_t pvt_GetEntNum(uint16_t clusNum, uint8_t secNumInClus, 
+                              uint16_t entPos, const BPB *bpb);
+static void pvt_AdvanceCursor(FatCursor *cur);
+static uint8_t pvt_LoadCursorSector(FatCursor *cur, const BPB *bpb);
+static uint8_t pvt_GetNextClusIndex(uint32_t *clusIndx, const BPB *bpb);
 static void pvt_PrintEntFields(const uint8_t *byte, uint8_t flags);
-static uint8_t pvt_PrintFile(const uint8_t snEnt[], const BPB *bpb);
+static uint8_t pvt_PrintFile(FatFile *file, const BPB *bpb);
+static uint8_t pvt_SetFileClus(FatFile *file, uint32_t clusNum, 
+                               const BPB *bpb);
+static uint8_t pvt_MapFileExtents(FatFile *file, const BPB *bpb);
+static const FatExtent *pvt_FindExtent(const FatFile *file, uint32_t clusNum);
+static uint16_t pvt_GetConsecSecCnt(const FatFile *file, uint8_t secNumInClus,
+                                    const BPB *bpb);
+
+// number of file bytes read at a time by pvt_PrintFile.
+#define PRINT_FILE_BUF_LEN     32
+
+// width of the file size printed by pvt_PrintEntFields, for sizes < GIGA.
+#define FS_WIDTH               (FS_UNIT == KILO ? 7 : FS_UNIT == MEGA ? 4 : 10)
 
 /*
  ******************************************************************************
@@ -110,188 +142,410 @@ void fat_InitEntry(FatEntry *ent, const BPB *bpb)
  *
  * Returns     : A FAT Error Flag. If any value other than SUCCESS is returned 
  *               then the function was unable to update the FatEntry.
+ * 
+ * Notes       : This function holds no state between calls, so the sector
+ *               containing the next entry is requested again every time it is
+ *               called. Use a FatCursor with fat_CursorNextEntry when 
+ *               iterating over the entries of a directory.
  * ----------------------------------------------------------------------------
  */
 uint8_t fat_SetNextEntry(FatEntry *currEnt, const BPB *bpb)
 {  
   //
-  // this section sets the initial values of the different nested loop
-  // counters for the first time they are entered during a single function 
-  // call. These are set according to the state of the currEnt members.
+  // Set a temporary cursor to the entry following the previous short name
+  // entry. If the previous short name entry occupied the last entry position
+  // of a sector, nextEntPos will be SECTOR_LEN, which the cursor handles when
+  // the sector is loaded.
   //
+  FatCursor *cur = fat_ArenaBorrow();
+  cur->clusIndx = currEnt->snEntClusIndx;
+  cur->clusNum = 0;                         // not known. Not used here.
+  cur->secNumInClus = currEnt->snEntSecNumInClus;
+  cur->entPos = currEnt->nextEntPos;
+  cur->secLoaded = 0;
+
+  uint8_t err = fat_CursorNextEntry(cur, currEnt, bpb);
+  fat_ArenaReturn(cur);
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  INITIALIZE DIRECTORY CURSOR
+ *                                      
+ * Description : Sets a FatCursor instance to the first entry of a directory.
+ * 
+ * Arguments   : cur   - Pointer to the FatCursor instance to be initialized.
+ *               dir   - Pointer to a FatDir instance. The cursor will iterate
+ *                       over the entries of this directory.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : No sector is read here. The first sector of the directory is
+ *               read by the first call to fat_CursorNextEntry.
+ * ----------------------------------------------------------------------------
+ */
+void fat_InitCursor(FatCursor *cur, const FatDir *dir)
+{
+  cur->clusIndx = dir->fstClusIndx;
+  cur->clusNum = 0;
+  cur->secNumInClus = FIRST_SEC_POS_IN_CLUS;
+  cur->entPos = FIRST_ENT_POS_IN_SEC;
+  cur->secLoaded = 0;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  SEEK CURSOR TO ENTRY NUMBER
+ *                                      
+ * Description : Sets a FatCursor instance to the 32-byte entry at position
+ *               entNum of a directory, e.g. the entNum of a FatEntryRef.
+ * 
+ * Arguments   : cur      - Pointer to the FatCursor instance to be set.
+ *               dir      - Pointer to a FatDir instance. The cursor will 
+ *                          iterate over the entries of this directory.
+ *               entNum   - Number of the entry in the directory, from 0.
+ *               bpb      - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS, END_OF_DIRECTORY if the directory's cluster chain
+ *               ends before entNum, or FAILED_READ_SECTOR if a FAT sector 
+ *               could not be read.
+ * 
+ * Notes       : The cluster holding the entry is found by following the 
+ *               directory's cluster chain. No directory sector is read.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_SeekCursor(FatCursor *cur, const FatDir *dir, uint16_t entNum,
+                       const BPB *bpb)
+{
+  uint16_t entsPerClus = bpb->secPerClus * ENTRIES_PER_SEC;
+  uint16_t clusNum = entNum / entsPerClus;
+
+  // follow the chain from the directory's first cluster to the entry's.
+  fat_InitCursor(cur, dir);
+  for (; cur->clusNum < clusNum; ++cur->clusNum)
+  {
+    if (pvt_GetNextClusIndex(&cur->clusIndx, bpb) != SUCCESS)
+      return FAILED_READ_SECTOR;
+    if (cur->clusIndx == END_CLUSTER)
+      return END_OF_DIRECTORY;
+  }
+  
+  entNum %= entsPerClus;
+  cur->secNumInClus = entNum / ENTRIES_PER_SEC;
+  cur->entPos = entNum % ENTRIES_PER_SEC * ENTRY_LEN;
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                       SEEK CURSOR TO ENTRY NUMBER IN CLUSTER
+ *                                      
+ * Description : Same as fat_SeekCursor, but the index of the cluster holding
+ *               the entry is given, so the chain is not followed.
+ * 
+ * Arguments   : cur        - Pointer to the FatCursor instance to be set.
+ *               clusIndx   - Index of the cluster holding the entry.
+ *               entNum     - Number of the entry in the directory, from 0.
+ *               bpb        - Pointer to the BPB struct instance.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_SeekCursorInClus(FatCursor *cur, uint32_t clusIndx, uint16_t entNum,
+                          const BPB *bpb)
+{
+  uint16_t entsPerClus = bpb->secPerClus * ENTRIES_PER_SEC;
+
+  cur->clusIndx = clusIndx;
+  cur->clusNum = entNum / entsPerClus;
+  entNum %= entsPerClus;
+  cur->secNumInClus = entNum / ENTRIES_PER_SEC;
+  cur->entPos = entNum % ENTRIES_PER_SEC * ENTRY_LEN;
+  cur->secLoaded = 0;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              HASH ENTRY NAME
+ *                                      
+ * Description : Returns a 16-bit hash (djb2) of an entry name, used as a key
+ *               for cached lookups of the entry.
+ * 
+ * Arguments   : nameStr   - The name string.
+ * 
+ * Returns     : The hash.
+ * ----------------------------------------------------------------------------
+ */
+uint16_t fat_HashName(const char nameStr[])
+{
+  uint16_t hash = 5381;
+  while (*nameStr)
+    hash = (hash << 5) + hash + (uint8_t)*nameStr++;
+  return hash;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                           SET FAT ENTRY TO NEXT CURSOR ENTRY
+ *                                      
+ * Description : Advances a FatCursor to the next short name entry in its
+ *               directory and updates a FatEntry instance to that entry.
+ * 
+ * Arguments   : cur   - Pointer to a FatCursor instance previously set by 
+ *                       fat_InitCursor. 
+ *               ent   - Pointer to a FatEntry instance. Its members will be
+ *                       updated to the next entry found by the cursor.
+ *               bpb   - Pointer to the BPB struct instance.
+ *
+ * Returns     : A FAT Error Flag. If any value other than SUCCESS is returned 
+ *               then the function was unable to update the FatEntry.
+ * 
+ * Notes       : The cursor keeps the sector it is scanning in its secArr
+ *               member. A sector is only read from the disk when the cursor
+ *               crosses a sector boundary. The FAT is only read when it 
+ *               crosses a cluster boundary.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CursorNextEntry(FatCursor *cur, FatEntry *ent, const BPB *bpb)
+{
+  return fat_CursorScanEntry(cur, ent, 0, bpb);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                         SCAN FOR NEXT CURSOR ENTRY (LIMITED)
+ *                                      
+ * Description : Same as fat_CursorNextEntry, but each sector read is taken 
+ *               from a budget, and the scan stops when the budget is used up,
+ *               so that a long scan can be resumed later.
+ * 
+ * Arguments   : cur         - Pointer to a FatCursor instance previously set
+ *                             by fat_InitCursor. 
+ *               ent         - Pointer to a FatEntry instance. Its members 
+ *                             will be updated to the next entry found by the
+ *                             cursor.
+ *               secBudget   - Pointer to the number of sectors that may be 
+ *                             read. Decremented for each sector read. If 0 
+ *                             (a null pointer) there is no limit.
+ *               bpb         - Pointer to the BPB struct instance.
+ *
+ * Returns     : A FAT Error Flag. SCAN_YIELD if the budget was used up before
+ *               an entry was found. 
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CursorScanEntry(FatCursor *cur, FatEntry *ent, 
+                            uint8_t *secBudget, const BPB *bpb)
+{
+  uint8_t     err;
+  FatEntryRef ref;
+  char        lnStr[LN_STR_LEN_MAX] = {'\0'};
+
+  if ((err = pvt_CursorScan(cur, &ref, lnStr, secBudget, bpb)) != SUCCESS)
+    return err;
+
+  pvt_UpdateFatEntryMembers(ent, lnStr, cur->secArr, cur->entPos,
+                            cur->secNumInClus, cur->clusIndx);
+
+  // point cursor to the entry following the short name. No disk access.
+  pvt_AdvanceCursor(cur);
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                        SET FAT ENTRY REFERENCE TO NEXT ENTRY
+ *                                      
+ * Description : Advances a FatCursor to the next entry in its directory whose
+ *               attribute byte matches, and sets a FatEntryRef to it. Long 
+ *               names are checked but not decoded, and entries that do not 
+ *               match are skipped without any name work.
+ * 
+ * Arguments   : cur        - Pointer to a FatCursor instance previously set 
+ *                            by fat_InitCursor. 
+ *               ref        - Pointer to a FatEntryRef instance. Set to the
+ *                            next matching entry.
+ *               attrMask   - Attribute bits to test.
+ *               attrVal    - Value the tested bits must have, e.g. 
+ *                            attrMask = DIR_ENTRY_ATTR | VOLUME_ID_ATTR and
+ *                            attrVal = DIR_ENTRY_ATTR for directories only,
+ *                            or attrMask = 0 and attrVal = 0 for any entry.
+ *               bpb        - Pointer to the BPB struct instance.
+ *
+ * Returns     : A FAT Error Flag. END_OF_DIRECTORY if there are no more 
+ *               matching entries.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CursorNextRef(FatCursor *cur, FatEntryRef *ref, uint8_t attrMask,
+                          uint8_t attrVal, const BPB *bpb)
+{
+  uint8_t err;
 
-  // index of the cluster where the previous short name entry was found
-  uint32_t clusIndx = currEnt->snEntClusIndx;
-  // sector num in the cluster where the previous short name entry was found
-  uint8_t  secNumInClus = currEnt->snEntSecNumInClus;
-  // position of entry following previous short name entry in the sector
-  uint16_t entPos = currEnt->nextEntPos;
+  for (;;)
+  {
+    if ((err = pvt_CursorScan(cur, ref, 0, 0, bpb)) != SUCCESS)
+      return err;
+    pvt_AdvanceCursor(cur);
+
+    if ((ref->attr & attrMask) == attrVal)
+      return SUCCESS;
+  }
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        GET NAME OF FAT ENTRY
+ *                                      
+ * Description : Decodes the name of the entry referenced by a FatEntryRef 
+ *               into a caller buffer. This is the long name, or the short 
+ *               name if the entry does not have a long name.
+ * 
+ * Arguments   : ref      - Pointer to a FatEntryRef set by fat_CursorNextRef.
+ *               nameStr  - Array of at least LN_STR_LEN_MAX chars. The name
+ *                          is copied here as a string.
+ *               bpb      - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY if the 
+ *               long name entries continue past the end of the directory's
+ *               cluster chain.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_GetEntryName(const FatEntryRef *ref, char nameStr[], 
+                         const BPB *bpb)
+{
+  const uint8_t *entArr;
+
+  nameStr[0] = '\0';
+
+  // no long name. Load the short name.
+  if (!ref->lnEntCnt)
+  {
+    if (pvt_GetRefEntry(ref->snClusIndx, ref->snSecNumInClus, ref->snEntPos,
+                        &entArr, bpb) != SUCCESS)
+      return FAILED_READ_SECTOR;
+    pvt_LoadShortName(entArr, nameStr);
+    return SUCCESS;
+  }
 
   //
-  // if previous short name entry occupied the last entry position of a sector
-  // then increment secNumInClus and set entPos to 0 so that the search for the
-  // next entry will begin on this function call at the first entry of the next
-  // sector. For the case when the the next sector is beyond the cluster limit 
-  // it will be handled in the nested loops.
+  // Prepend the chars of each long name entry, in the order they are stored,
+  // following the entries across sector and cluster boundaries. 
   //
-  if (entPos == SECTOR_LEN)
+  uint8_t  err;
+  uint32_t clusIndx = ref->lnClusIndx;
+  uint8_t  secNumInClus = ref->lnSecNumInClus;
+  uint16_t entPos = ref->lnEntPos;
+
+  for (uint8_t lnEnt = 0; lnEnt < ref->lnEntCnt; ++lnEnt)
   {
-    ++secNumInClus;
-    entPos = 0;
+    if (pvt_GetRefEntry(clusIndx, secNumInClus, entPos, &entArr, bpb) 
+        != SUCCESS)
+      return FAILED_READ_SECTOR;
+    pvt_PrependLongName(entArr, nameStr);
+
+    if ((err = pvt_NextRefEntPos(&clusIndx, &secNumInClus, &entPos, bpb))
+        != SUCCESS)
+      return err;
   }
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      MATCH NAME OF FAT ENTRY
+ *                                      
+ * Description : Compares a string to the name of the entry referenced by a
+ *               FatEntryRef, without decoding the whole name. The chars of 
+ *               each long name entry are compared in turn, and the 
+ *               comparison stops at the first entry that differs.
+ * 
+ * Arguments   : ref      - Pointer to a FatEntryRef set by fat_CursorNextRef.
+ *               nameStr  - The name to compare. Case-sensitive.
+ *               bpb      - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS if the entry's name is nameStr, FILE_NOT_FOUND if it
+ *               is not, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY as for 
+ *               fat_GetEntryName.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_MatchEntryName(const FatEntryRef *ref, const char nameStr[],
+                           const BPB *bpb)
+{
+  uint8_t  err;
+  const uint8_t *entArr;
+  uint16_t nameLen = strlen(nameStr);
 
-  // loop over clusters beginning at clusIndx to search for next entry.
-  do 
+  // no long name. Compare to the short name.
+  if (!ref->lnEntCnt)
   {
-    //
-    // loop over sectors in the cluster to find the next entry. If this loop is
-    // re-entered in a single function call then secNumInClus will be reset to
-    // 0 in the outer cluser loop. The first time it is entered it should be
-    // initialized to the value of the snEntSecNumInClus member of the currEnt
-    // instance of FatEntry.
-    //
-    for (; secNumInClus < bpb->secPerClus; ++secNumInClus)
-    {
-      // calculate location of sector on the disk
-      uint32_t secNumOnDisk = secNumInClus + bpb->dataRegionFirstSector
-                            + (clusIndx - bpb->rootClus) 
-                            * bpb->secPerClus;
-      
-      // create and load array with data bytes from the disk sector
-      uint8_t secArr[bpb->bytesPerSec];  
-      if (FATtoDisk_ReadSingleSector(secNumOnDisk, secArr) 
-          == FAILED_READ_SECTOR)
-        return FAILED_READ_SECTOR;
+    char snStr[SN_CHAR_LEN + 1];
+
+    if (nameLen > SN_CHAR_LEN)
+      return FILE_NOT_FOUND;
+    if (pvt_GetRefEntry(ref->snClusIndx, ref->snSecNumInClus, ref->snEntPos,
+                        &entArr, bpb) != SUCCESS)
+      return FAILED_READ_SECTOR;
+    pvt_LoadShortName(entArr, snStr);
+    return strcmp(snStr, nameStr) ? FILE_NOT_FOUND : SUCCESS;
+  }
 
-      //
-      // loop over entries in the sector to search for the next entry. If this 
-      // loop is re-entered in a single function call then entPos will be reset 
-      // to 0 in the sector loop. The first time it is entered entPos should be
-      // initialized to the value of the nextEntPos member of the currEnt
-      // instance of FatEntry.
-      //
-      for (; entPos < bpb->bytesPerSec; entPos += ENTRY_LEN)
-      {
-        // if first byte of an entry is 0, remaining entries should be empty
-        if (!secArr[entPos])                                                       
-          return END_OF_DIRECTORY;
-
-        if (secArr[entPos] == DELETED_ENTRY_TOKEN)
-          continue;
-
-        // check attribute byte to see if entPos points to a long name entry
-        if ((secArr[entPos + ATTR_BYTE_OFFSET] & LN_ATTR_MASK) == LN_ATTR_MASK)
-        {
-          // entPos must be pointing to the last entry of a long name here.
-          if (!(secArr[entPos] & LN_LAST_ENTRY_FLAG))
-            return CORRUPT_FAT_ENTRY;
-          
-          // initialize empty long name string 
-          char lnStr[LN_STR_LEN_MAX] = {'\0'};   
-
-          // calculate position of short name relative to first byte in sector
-          uint16_t snPos = entPos + ENTRY_LEN * (LN_ORD_MASK & secArr[entPos]);
-
-          // enter if short name is in the next sector
-          if (snPos >= bpb->bytesPerSec)
-          {              
-            uint8_t nextSecArr[bpb->bytesPerSec]; 
-
-            //
-            // locate next sector. Depending on the number of the sector in the 
-            // cluster, the next sector will either be in the next cluster or 
-            // it will be the next sector in the cluster and on the disk.
-            //
-            if (secNumInClus == bpb->secPerClus - 1)  // next sec in next clus
-            {
-              // calculate location of next sector in next clus on the disk
-              secNumOnDisk = bpb->dataRegionFirstSector 
-                           + (pvt_GetNextClusIndex(clusIndx, bpb)
-                           - bpb->rootClus)
-                           * bpb->secPerClus;
-              secNumInClus = 0;
-            }
-            else                  // next sector is the next physical sector 
-            {
-              ++secNumOnDisk;
-              ++secNumInClus;
-            }
-
-            // load next sector into nextSecArr[].
-            if (FATtoDisk_ReadSingleSector(secNumOnDisk, nextSecArr) 
-                == FAILED_READ_SECTOR)
-              return FAILED_READ_SECTOR;
-            
-            // snPos to point to sn entry relative to first byte of next sector
-            snPos -= bpb->bytesPerSec;
-            
-            // verify snPos does not point to long name
-            if ((nextSecArr[snPos + ATTR_BYTE_OFFSET] & LN_ATTR_MASK) 
-                 == LN_ATTR_MASK)
-              return CORRUPT_FAT_ENTRY;
-            
-            //
-            // check if a ln spans the sector boundary. At this point, sn is in
-            // next sector, but if sn is not first entry (i.e. snPos != 0) then 
-            // entries for ln are in the current sector and next sector.
-            //
-            if (snPos)
-            {
-              // Entry preceeding short name must be first entry of long name      
-              if ((nextSecArr[snPos - ENTRY_LEN] & LN_ORD_MASK) != 1)
-                return CORRUPT_FAT_ENTRY;
-
-              // Call twice for both current and next sector.
-              pvt_LoadLongName(snPos - ENTRY_LEN, FIRST_ENT_POS_IN_SEC,
-                               nextSecArr, lnStr);
-              pvt_LoadLongName(LAST_ENTRY_POS_IN_SEC, entPos, secArr, lnStr);
-            }
-            else   // full ln in current sec, but sn is first ent in next sec
-            {
-              // Entry preceeding short name must be first entry of long name
-              if ((secArr[LAST_ENTRY_POS_IN_SEC] & LN_ORD_MASK) != 1)
-                return CORRUPT_FAT_ENTRY;
-
-              pvt_LoadLongName(LAST_ENTRY_POS_IN_SEC, entPos, secArr, lnStr);
-            }
-            pvt_UpdateFatEntryMembers(currEnt, lnStr, nextSecArr, snPos,
-                                      secNumInClus, clusIndx);
-            return SUCCESS;
-          }
-          else          // Long and short name are in the current sector.
-          {   
-            // Verify snPos does not point to long name
-            if ((secArr[snPos + ATTR_BYTE_OFFSET] & LN_ATTR_MASK) 
-                 == LN_ATTR_MASK)
-              return CORRUPT_FAT_ENTRY;
-    
-            // entry preceeding short name must be first entry of long name
-            if ((secArr[snPos - ENTRY_LEN] & LN_ORD_MASK) != 1)
-              return CORRUPT_FAT_ENTRY;
-            
-            pvt_LoadLongName(snPos - ENTRY_LEN, entPos, secArr, lnStr);
-            pvt_UpdateFatEntryMembers(currEnt, lnStr, secArr, snPos, 
-                                      secNumInClus, clusIndx);
-            return SUCCESS;                          
-          }                   
-        }
-        else            // Long name does not exist. Use short name instead.
-        {
-          // passing empty string for long name
-          pvt_UpdateFatEntryMembers(currEnt, "", secArr, entPos,
-                                    secNumInClus, clusIndx);
-          return SUCCESS;  
-        }
-      }
-      entPos = FIRST_ENT_POS_IN_SEC;      // reset counter for entry loop
-    }
-    secNumInClus = FIRST_SEC_POS_IN_CLUS;// reset counter for sector loop
+  // 
+  // The long name is compared as fat_GetEntryName decodes it, i.e. only the
+  // chars kept by pvt_LoadLongNameChars count, and the name is cut at 
+  // LN_STR_LEN_MAX - 1 chars. An entry keeps at most 2 chars per UTF-16 char.
+  //
+  if (nameLen > LN_STR_LEN_MAX - 1
+      || nameLen > (uint16_t)ref->lnEntCnt * 2 * LN_CHARS_PER_ENTRY)
+    return FILE_NOT_FOUND;
+
+  //
+  // The entries are stored last first, so each one is compared with the 
+  // chars that end at namePos, the position in the long name of the chars 
+  // not yet compared. It starts at the end of the long name, which is 
+  // nameLen unless the long name may have been cut to nameLen chars.
+  //
+  uint16_t namePos = nameLen;
+  if (nameLen == LN_STR_LEN_MAX - 1)
+  {
+    if ((err = pvt_GetLongNameLen(ref, &namePos, bpb)) != SUCCESS)
+      return err;
+    if (namePos < nameLen)
+      return FILE_NOT_FOUND;
   }
-  // get index of next cluster and continue looping if not last cluster
-  while ((clusIndx = pvt_GetNextClusIndex(clusIndx, bpb)) != END_CLUSTER);
 
-  // return here if the end of the dir was reached without finding a next entry
-  return END_OF_DIRECTORY;
+  uint32_t clusIndx = ref->lnClusIndx;
+  uint8_t  secNumInClus = ref->lnSecNumInClus;
+  uint16_t entPos = ref->lnEntPos;
+
+  for (uint8_t lnEnt = 0; lnEnt < ref->lnEntCnt; ++lnEnt)
+  {
+    char    entStr[2 * LN_CHARS_PER_ENTRY];
+    uint8_t entLen;
+
+    if (pvt_GetRefEntry(clusIndx, secNumInClus, entPos, &entArr, bpb) 
+        != SUCCESS)
+      return FAILED_READ_SECTOR;
+
+    // entry belongs to a different short name.
+    if (entArr[LN_CHKSUM_BYTE_OFFSET] != ref->snChkSum)
+      return FILE_NOT_FOUND;
+
+    entLen = pvt_LoadLongNameChars(entArr, entStr);
+    if (entLen > namePos)
+      return FILE_NOT_FOUND;
+    namePos -= entLen;
+
+    // chars at or past nameLen are not in the decoded name.
+    for (uint8_t chNum = 0; chNum < entLen && namePos + chNum < nameLen;
+         ++chNum)
+      if (entStr[chNum] != nameStr[namePos + chNum])
+        return FILE_NOT_FOUND;
+
+    if ((err = pvt_NextRefEntPos(&clusIndx, &secNumInClus, &entPos, bpb))
+        != SUCCESS)
+      return err;
+  }
+  return namePos ? FILE_NOT_FOUND : SUCCESS;
 }
 
 /*
@@ -340,68 +594,120 @@ uint8_t fat_SetDir(FatDir *dir, const char newDirStr[], const BPB *bpb)
     return SUCCESS;
   }
 
-  // 
-  // Create and initialize a FatEntry instance. This will set the snEntClusIndx
-  // member to the root directory and all other members to 0 or null strings, 
-  // then update the snEntClusIndx to point to the first cluster index of the 
-  // FatDir instance (dir).
-  //
-  FatEntry ent;
-  fat_InitEntry(&ent, bpb);
-  ent.snEntClusIndx = dir->fstClusIndx;
-
   // 
   // Search FatDir directory to see if a child directory matches newDirStr.
-  // Done by repeatedly calling fat_SetNextEntry() to set a FatEntry instance
-  // to the next entry in the directory and then comparing the lnStr member of 
-  // the instance to newDirStr. Note that the lnStr member will be the same as
-  // the snStr if a lnStr does not exist for the entry, therefore, short names
-  // can only be used when a lnStr does not exist for the entry.
+  // The name is the short name if a long name does not exist for the entry,
+  // therefore, short names can only be used when a long name does not exist
+  // for the entry. If no matching entry is found, FatDir is unchanged.
   //
-  while ((err = fat_SetNextEntry(&ent, bpb)) == SUCCESS)
-  {
-    // if entry is not a directory entry, get next entry
-    if (!(ent.snEnt[ATTR_BYTE_OFFSET] & DIR_ENTRY_ATTR))
-      continue;
+  FatEntryRef ref;
+  if ((err = fat_FindEntry(dir, newDirStr, DIR_ENTRY_ATTR | VOLUME_ID_ATTR,
+                           DIR_ENTRY_ATTR, &ref, bpb)) != SUCCESS)
+    return err;
 
-    // if entry matches newDirStr 
-    if (!strcmp(ent.lnStr, newDirStr))
-    {
-      //
-      // bytes 20, 21, 26 and 27 of a short name entry give the value of the
-      // first cluster index in the FAT for that entry.
-      //
-      dir->fstClusIndx = ent.snEnt[FST_CLUS_INDX_BYTE_OFFSET_3];
-      dir->fstClusIndx <<= 8;
-      dir->fstClusIndx |= ent.snEnt[FST_CLUS_INDX_BYTE_OFFSET_2];
-      dir->fstClusIndx <<= 8;
-      dir->fstClusIndx |= ent.snEnt[FST_CLUS_INDX_BYTE_OFFSET_1];
-      dir->fstClusIndx <<= 8;
-      dir->fstClusIndx |= ent.snEnt[FST_CLUS_INDX_BYTE_OFFSET_0];
-      
-      // fill short name array with its characters from the entry
-      char snStr[SN_NAME_CHAR_LEN + 1] = {'\0'};      
-      for (uint8_t strPos = 0; strPos < SN_NAME_CHAR_LEN; ++strPos)
-        snStr[strPos] = ent.snEnt[strPos];
-
-      // Append current directory name to the short and long name paths
-      strcat (dir->lnPathStr, dir->lnStr);
-      strcat (dir->snPathStr, dir->snStr);
-
-      // Update dir to new dir name. If current dir != root dir append '/'
-      if (strcmp(dir->lnStr, "/"))
-        strcat(dir->lnPathStr, "/"); 
-      strcpy(dir->lnStr, newDirStr);
-      
-      if (strcmp(dir->snStr, "/"))
-        strcat(dir->snPathStr, "/");
-      strcpy(dir->snStr, snStr);
+  return fat_SetDirToEntry(dir, &ref, newDirStr, bpb);
+}
 
-      return SUCCESS;
-    }
+/*
+ * ----------------------------------------------------------------------------
+ *                                                 SET FAT DIRECTORY TO A CHILD
+ *                                       
+ * Description : Sets a FatDir instance to the child directory referenced by a
+ *               FatEntryRef.
+ * 
+ * Arguments   : dir         - Pointer to the FatDir instance to be set to the
+ *                             child directory.
+ *               ref         - Pointer to a FatEntryRef referencing a 
+ *                             directory entry in dir.
+ *               newDirStr   - The name of the child directory.
+ *               bpb         - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS or FAILED_READ_SECTOR. If FAILED_READ_SECTOR, dir is
+ *               unchanged.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_SetDirToEntry(FatDir *dir, const FatEntryRef *ref, 
+                          const char newDirStr[], const BPB *bpb)
+{
+  // fill short name array with its characters from the entry
+  const uint8_t *snEnt;
+  if (pvt_GetRefEntry(ref->snClusIndx, ref->snSecNumInClus, ref->snEntPos,
+                      &snEnt, bpb) != SUCCESS)
+    return FAILED_READ_SECTOR;
+  char snStr[SN_NAME_CHAR_LEN + 1] = {'\0'};      
+  for (uint8_t strPos = 0; strPos < SN_NAME_CHAR_LEN; ++strPos)
+    snStr[strPos] = snEnt[strPos];
+
+  dir->fstClusIndx = ref->fstClusIndx;
+
+  // Append current directory name to the short and long name paths
+  strcat (dir->lnPathStr, dir->lnStr);
+  strcat (dir->snPathStr, dir->snStr);
+
+  // Update dir to new dir name. If current dir != root dir append '/'
+  if (strcmp(dir->lnStr, "/"))
+    strcat(dir->lnPathStr, "/"); 
+  strcpy(dir->lnStr, newDirStr);
+  
+  if (strcmp(dir->snStr, "/"))
+    strcat(dir->snPathStr, "/");
+  strcpy(dir->snStr, snStr);
+
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           FIND ENTRY BY NAME
+ *                                       
+ * Description : Searches a directory for an entry whose name matches nameStr
+ *               and whose attribute byte matches, and sets a FatEntryRef to 
+ *               it.
+ * 
+ * Arguments   : dir        - Pointer to the FatDir instance to search.
+ *               nameStr    - The name of the entry. Case-sensitive.
+ *               attrMask   - Attribute bits to test, as for fat_CursorNextRef.
+ *               attrVal    - Value the tested bits must have.
+ *               ref        - Pointer to a FatEntryRef instance. This will be
+ *                            set to the matching entry if it is found.
+ *               bpb        - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS if found, END_OF_DIRECTORY if not, or the error 
+ *               returned by fat_CursorNextRef or fat_MatchEntryName.
+ * 
+ * Notes       : 1) The cursor used for the search is borrowed from the 
+ *                  arena until this function returns.
+ *               2) If a name index of dir is in use (FAT_INDEX.H) it is
+ *                  searched first, so only the sector(s) of the entry are read.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_FindEntry(const FatDir *dir, const char nameStr[], 
+                      uint8_t attrMask, uint8_t attrVal, FatEntryRef *ref,
+                      const BPB *bpb)
+{
+  uint8_t err;
+
+  // search the directory's name index first, if one is in use.
+  if (fat_IndexLookup(dir, nameStr, attrMask, attrVal, ref, &err, bpb))
+    return err;
+
+  FatCursor *cur = fat_ArenaBorrow();
+  fat_InitCursor(cur, dir);
+
+  // 
+  // Entries whose attributes do not match are skipped, and the names of the
+  // others are compared to nameStr in place. The name is the short name if
+  // a long name does not exist for the entry.
+  //
+  while ((err = fat_CursorNextRef(cur, ref, attrMask, attrVal, bpb)) 
+         == SUCCESS) 
+  { 
+    err = fat_MatchEntryName(ref, nameStr, bpb);
+    if (err != FILE_NOT_FOUND)
+      break;
   }
-  // No matching entry found. FatDir is unchanged.
-  return err;
+  fat_ArenaReturn(cur);
+  return err;                               // SUCCESS if an entry was found.
 }
 
 /*
@@ -438,21 +744,19 @@ uint8_t fat_PrintDir(const FatDir *dir, uint8_t entFlds, const BPB *bpb)
   uint8_t err;
 
   // 
-  // Create and initialize a FatEntry instance. This will set the snEntClusIndx
-  // member to the root directory and all other members to 0 or null strings, 
-  // then update the snEntClusIndx to point to the first cluster index of the 
-  // FatDir instance (dir).
+  // Create a FatEntry instance and borrow a FatCursor from the arena. The 
+  // cursor is set to the first entry of the FatDir instance (dir).
   //
   FatEntry ent;
-  fat_InitEntry(&ent, bpb);
-  ent.snEntClusIndx = dir->fstClusIndx;
+  FatCursor *cur = fat_ArenaBorrow();
+  fat_InitCursor(cur, dir);
 
   // 
   // set the ent FatEntry instance to the next entry in the directory, then 
   // print the entry and fields according to entFlds. After all entries in the
-  // dir have been loaded, fat_SetNextEntry will return END_OF_DIRECTORY.
+  // dir have been loaded, fat_CursorNextEntry will return END_OF_DIRECTORY.
   //
-  while ((err = fat_SetNextEntry(&ent, bpb)) == SUCCESS)
+  while ((err = fat_CursorNextEntry(cur, &ent, bpb)) == SUCCESS)
   { 
     // Do not print entry if it is hidden and hidden filter flag is not set
     if (ent.snEnt[ATTR_BYTE_OFFSET] & HIDDEN_ATTR && !(entFlds & HIDDEN))
@@ -476,6 +780,8 @@ uint8_t fat_PrintDir(const FatDir *dir, uint8_t entFlds, const BPB *bpb)
       print_Str(ent.lnStr);
     }
   }
+  fat_ArenaReturn(cur);
+
   // return END_OF_DIRECTORY if successful. Any other value returned is error.
   return err;
 }
@@ -501,88 +807,272 @@ uint8_t fat_PrintDir(const FatDir *dir, uint8_t entFlds, const BPB *bpb)
  */
 uint8_t fat_PrintFile(const FatDir *dir, const char fileStr[], const BPB *bpb)
 {
-  // for function return errors. This is the loop cond. and the return value.
+  // for function return errors.
   uint8_t err;
-    
-  if (pvt_CheckName(fileStr) == INVALID_NAME)
-    return INVALID_NAME;
-
+  
   // 
-  // Create and initialize a FatEntry instance. This will set the snEntClusIndx
-  // member to the root directory and all other members to 0 or null strings, 
-  // then, update the snEntClusIndx to point to the first cluster index of the 
-  // FatDir instance (dir).
+  // open the file matching fileStr in the directory, then print its contents.
+  // The FatFile instance is borrowed from the arena.
   //
-  FatEntry ent;
-  fat_InitEntry(&ent, bpb);
-  ent.snEntClusIndx = dir->fstClusIndx;
+  FatFile *file = fat_ArenaBorrow();
+  if ((err = fat_Open(file, dir, fileStr, bpb)) == SUCCESS)
+  {
+    print_StrP(PSTR("\n\n\r"));
+    err = pvt_PrintFile(file, bpb);         //END_OF_FILE or read error
+  }
+  fat_ArenaReturn(file);
+  return err;
+}
 
-  // 
-  // Search for a file matching fileStr in the current directory. Do this
-  // by calling fat_SetNextEntry() to set the FatEntry instance to the next
-  // entry in the directory. This is repeated until a file name is returned
-  // that matches fileStr. Once a match is found then the "private"
-  // function, pvt_PrintFile() is called to print this file. If no matching 
-  // file is found, then the loop will exit once END_OF_DIRECTORY is returned.
-  //
-  while ((err = fat_SetNextEntry(&ent, bpb)) == SUCCESS) 
-  { 
-    // if entry is a directory, continue
-    if (ent.snEnt[ATTR_BYTE_OFFSET] & DIR_ENTRY_ATTR)
-      continue;
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    OPEN FILE
+ *                                       
+ * Description : Sets a FatFile instance to the start of a file in a directory.
+ * 
+ * Arguments   : file       - Pointer to the FatFile instance to be set.
+ *               dir        - Pointer to a FatDir instance. This directory must
+ *                            contain the entry for the file to be opened.
+ *               fileStr    - Pointer to a string. This is the name of the file
+ *                            to be opened.
+ *               bpb        - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, INVALID_NAME, FILE_NOT_FOUND, or another FAT Error 
+ *               Flag if the directory could not be searched.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_Open(FatFile *file, const FatDir *dir, const char fileStr[], 
+                 const BPB *bpb)
+{
+  uint8_t err;
 
-    // if matching file is found print its contents
-    if (!strcmp(ent.lnStr, fileStr))
-    {
-      print_Str("\n\n\r");
-      err = pvt_PrintFile(ent.snEnt, bpb);  //END_OF_FILE or FAILED_READ_SECTOR
-      return err;
-    }
-  }
-  return err;                               // no matching file was found.
+  if (pvt_CheckName(fileStr) == INVALID_NAME)
+    return INVALID_NAME;
+
+  // search the directory for a file entry matching fileStr.
+  FatEntryRef ref;
+  if ((err = fat_FindEntry(dir, fileStr, DIR_ENTRY_ATTR | VOLUME_ID_ATTR, 0,
+                           &ref, bpb)) != SUCCESS)
+    return (err == END_OF_DIRECTORY) ? FILE_NOT_FOUND : err;
+
+  return fat_OpenAtClus(file, ref.fstClusIndx, ref.fileSize, bpb);
 }
 
 /*
- *-----------------------------------------------------------------------------
- *                                                         PRINT FAT ERROR FLAG
+ * ----------------------------------------------------------------------------
+ *                                               OPEN FILE AT ITS FIRST CLUSTER
+ *                                       
+ * Description : Sets a FatFile instance to the start of the file whose first
+ *               cluster and size are given, without searching a directory.
  * 
- * Description : Prints the FAT Error Flag passed as the arguement. 
+ * Arguments   : file          - Pointer to the FatFile instance to be set.
+ *               fstClusIndx   - Index of the file's first cluster.
+ *               fileSize      - File size in bytes.
+ *               bpb           - Pointer to the BPB struct instance.
  *
- * Arguments   : err   - An error flag returned by one of the FAT functions.
+ * Returns     : SUCCESS, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY if the 
+ *               cluster chain is shorter than the file size.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_OpenAtClus(FatFile *file, uint32_t fstClusIndx, uint32_t fileSize,
+                       const BPB *bpb)
+{
+  file->fstClusIndx = fstClusIndx;
+  file->fileSize = fileSize;
+
+  // position the file at its first byte.
+  file->pos = 0;
+  file->clusIndx = file->fstClusIndx;
+  file->clusNum = 0;
+  file->secLoaded = 0;
+
+  // follow the cluster chain once to build the file's extent map.
+  return pvt_MapFileExtents(file, bpb);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    READ FILE
+ *                                       
+ * Description : Reads up to len bytes from the current position of an open
+ *               file into buf and advances the position by the number read.
  * 
- * Returns     : void
+ * Arguments   : file        - Pointer to a FatFile instance set by fat_Open.
+ *               buf         - Pointer to the array to be loaded.
+ *               len         - Number of bytes requested.
+ *               bytesRead   - Pointer to an integer that will be set to the 
+ *                             number of bytes loaded into buf.
+ *               bpb         - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS if len bytes were read, END_OF_FILE if the end of the
+ *               file was reached first, or FAILED_READ_SECTOR or 
+ *               CORRUPT_FAT_ENTRY if the file could not be read.
  * ----------------------------------------------------------------------------
  */
-void fat_PrintError (uint8_t err)
-{  
-  switch(err)
+uint8_t fat_Read(FatFile *file, uint8_t buf[], uint16_t len, 
+                 uint16_t *bytesRead, const BPB *bpb)
+{
+  uint8_t  err;
+  uint32_t bytesPerClus = (uint32_t)bpb->secPerClus * bpb->bytesPerSec;
+
+  *bytesRead = 0;
+  while (*bytesRead < len)
+  {
+    if (file->pos >= file->fileSize)
+      return END_OF_FILE;
+
+    // move to the cluster holding pos.
+    if ((err = pvt_SetFileClus(file, file->pos / bytesPerClus, bpb)) 
+        != SUCCESS)
+      return err;
+
+    // locate the sector holding pos and the position of pos in the sector.
+    uint32_t posInClus = file->pos % bytesPerClus;
+    uint16_t posInSec = posInClus % bpb->bytesPerSec;
+    uint32_t secNumOnDisk = posInClus / bpb->bytesPerSec 
+                          + bpb->dataRegionFirstSector
+                          + (file->clusIndx - bpb->rootClus) * bpb->secPerClus;
+
+    // number of bytes to take from this sector.
+    uint16_t cnt = bpb->bytesPerSec - posInSec;
+    if (cnt > len - *bytesRead)
+      cnt = len - *bytesRead;
+    if (cnt > file->fileSize - file->pos)
+      cnt = file->fileSize - file->pos;
+
+    //
+    // File data is read directly from the disk, not through the cache, so
+    // that it does not replace the directory and FAT sectors held there. If
+    // whole sectors are requested, load as many as are consecutive on the 
+    // disk straight into buf with a single disk read. Partial sectors are
+    // also read with FATtoDisk_ReadSectors so that the disk can continue a
+    // sequential transfer between calls.
+    //
+    if (cnt == bpb->bytesPerSec)
+    {
+      uint16_t secCnt = pvt_GetConsecSecCnt(file, 
+                                   posInClus / bpb->bytesPerSec, bpb);
+      if (secCnt > (len - *bytesRead) / bpb->bytesPerSec)
+        secCnt = (len - *bytesRead) / bpb->bytesPerSec;
+      if (secCnt > (file->fileSize - file->pos) / bpb->bytesPerSec)
+        secCnt = (file->fileSize - file->pos) / bpb->bytesPerSec;
+
+      if (FATtoDisk_ReadSectors(secNumOnDisk, secCnt, buf + *bytesRead) 
+          == FAILED_READ_SECTOR)
+        return FAILED_READ_SECTOR;
+      cnt = secCnt * bpb->bytesPerSec;
+    }
+    else
+    {
+      if (!file->secLoaded || file->secNumOnDisk != secNumOnDisk)
+      {
+        file->secLoaded = 0;
+        if (FATtoDisk_ReadSectors(secNumOnDisk, 1, file->secArr) 
+            == FAILED_READ_SECTOR)
+          return FAILED_READ_SECTOR;
+        file->secNumOnDisk = secNumOnDisk;
+        file->secLoaded = 1;
+      }
+      memcpy(buf + *bytesRead, file->secArr + posInSec, cnt);
+    }
+
+    file->pos += cnt;
+    *bytesRead += cnt;
+  }
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    SEEK FILE
+ *                                       
+ * Description : Sets the current byte position of an open file.
+ * 
+ * Arguments   : file   - Pointer to a FatFile instance set by fat_Open.
+ *               pos    - Byte position from the start of the file.
+ *
+ * Returns     : SUCCESS, or END_OF_FILE if pos is beyond the end of the file,
+ *               in which case the position is set to the end of the file.
+ *  
+ * Notes       : No disk access occurs here. The cluster holding the new 
+ *               position is located by the next call to fat_Read.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_Seek(FatFile *file, uint32_t pos)
+{
+  if (pos > file->fileSize)
+  {
+    file->pos = file->fileSize;
+    return END_OF_FILE;
+  }
+  file->pos = pos;
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                   CLOSE FILE
+ *                                       
+ * Description : Closes an open file. Any further call to fat_Read with this
+ *               FatFile instance will return END_OF_FILE.
+ * 
+ * Arguments   : file   - Pointer to a FatFile instance set by fat_Open.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_Close(FatFile *file)
+{
+  file->fileSize = 0;
+  file->pos = 0;
+  file->secLoaded = 0;
+  file->extCnt = 0;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *                                                         PRINT FAT ERROR FLAG
+ * 
+ * Description : Prints the FAT Error Flag passed as the arguement. 
+ *
+ * Arguments   : err   - An error flag returned by one of the FAT functions.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_PrintError (uint8_t err)
+{  
+  switch(err)
   {
     case SUCCESS: 
-      print_Str("\n\rSUCCESS");
+      print_StrP(PSTR("\n\rSUCCESS"));
       break;
     case END_OF_DIRECTORY:
-      print_Str("\n\rEND_OF_DIRECTORY");
+      print_StrP(PSTR("\n\rEND_OF_DIRECTORY"));
+      break;
+    case SCAN_YIELD:
+      print_StrP(PSTR("\n\rSCAN_YIELD"));
       break;
     case INVALID_NAME:
-      print_Str("\n\rINVALID_NAME");
+      print_StrP(PSTR("\n\rINVALID_NAME"));
       break;
     case FILE_NOT_FOUND:
-      print_Str("\n\rFILE_NOT_FOUND");
+      print_StrP(PSTR("\n\rFILE_NOT_FOUND"));
       break;
     case DIR_NOT_FOUND:
-      print_Str("\n\rDIR_NOT_FOUND");
+      print_StrP(PSTR("\n\rDIR_NOT_FOUND"));
       break;
     case CORRUPT_FAT_ENTRY:
-      print_Str("\n\rCORRUPT_FAT_ENTRY");
+      print_StrP(PSTR("\n\rCORRUPT_FAT_ENTRY"));
       break;
     case END_OF_FILE:
-      print_Str("\n\rEND_OF_FILE");
+      print_StrP(PSTR("\n\rEND_OF_FILE"));
       break;
     case FAILED_READ_SECTOR:
-      print_Str("\n\rFAILED_READ_SECTOR");
+      print_StrP(PSTR("\n\rFAILED_READ_SECTOR"));
       break;
     default:
-      print_Str("\n\rUNKNOWN_ERROR");
+      print_StrP(PSTR("\n\rUNKNOWN_ERROR"));
   }
 }
 
@@ -624,32 +1114,8 @@ static void pvt_UpdateFatEntryMembers(FatEntry *ent, const char lnStr[],
   for (uint8_t byteNum = 0; byteNum < ENTRY_LEN; ++byteNum)
     ent->snEnt[byteNum] = secArr[snPos + byteNum];
   
-  //
-  // The section parses the short name name + ext chars in the short name 
-  // entry of the sector and then loads them into the snStr FatEntry member as
-  // a string.
-  //
-
-  // vars to assist loading short name
-  char sn[SN_CHAR_LEN + 1] = {'\0'};        // for sn string. Add 1 for null
-  char *snPtr = sn;
-
-  // load short name characters into array. skip spaces.
-  for (uint8_t byteNum = 0; byteNum < SN_NAME_CHAR_LEN; ++byteNum)
-    if (ent->snEnt[byteNum] != ' ')
-      *snPtr++ = ent->snEnt[byteNum];
-
-  // if there is an extension add it to sn string here
-  if (ent->snEnt[SN_NAME_CHAR_LEN] != ' ')
-  {
-    *snPtr++ = '.';
-    // load extension chars into array. Skip spaces stop at end of ext chars.
-    for (uint8_t byteNum = SN_NAME_CHAR_LEN; 
-         byteNum < SN_CHAR_LEN - 1; ++byteNum)
-      if (ent->snEnt[byteNum] != ' ')
-        *snPtr++ = ent->snEnt[byteNum];
-  }
-  strcpy(ent->snStr, sn);                   // load snStr FatEntry member.
+  // load the short name name + ext chars into the snStr FatEntry member.
+  pvt_LoadShortName(ent->snEnt, ent->snStr);
 
   // 
   // load lnStr FatEntry member. If the lnStr function parameter is a non-empty
@@ -719,15 +1185,15 @@ static uint8_t pvt_CheckName(const char nameStr[])
 static uint8_t pvt_SetDirToParent(FatDir *dir, const BPB *bpb)
 {
   uint32_t parentDirFirstClus, secNumOnDisk;
-  uint8_t  secArr[bpb->bytesPerSec];
+  const uint8_t *secArr;
 
   // sector number/address on disk
   secNumOnDisk = bpb->dataRegionFirstSector 
                + (dir->fstClusIndx - bpb->rootClus) 
                * bpb->secPerClus;
                 
-  // load secArr with disk sector at secNumOnDisk
-  if (FATtoDisk_ReadSingleSector(secNumOnDisk, secArr) == FAILED_READ_SECTOR)
+  // point secArr to the cached disk sector at secNumOnDisk
+  if (fat_CacheGetSector(secNumOnDisk, &secArr) == FAILED_READ_SECTOR)
    return FAILED_READ_SECTOR;
 
   // load first cluster index of the parent directory.
@@ -775,91 +1241,574 @@ static uint8_t pvt_SetDirToParent(FatDir *dir, const BPB *bpb)
 
 /*
  * ----------------------------------------------------------------------------
- *                               (PRIVATE) LOAD A LONG NAME ENTRY INTO A STRING 
+ *                                (PRIVATE) PREPEND LONG NAME ENTRY TO A STRING
  * 
- * Description : Loads characters of a long name into a C-string array.  
+ * Description : Loads the characters of a single long name entry into the
+ *               front of a C-string holding the characters of the long name
+ *               entries with higher ordinals.
  * 
- * Arguments   : lnFirstEnt   - Position of the lowest order entry of the long 
- *                              name in secArr.
- *               lnLastEnt    - Position of the highest order entry of the long 
- *                              name in secArr.
- *               secArr       - Pointer to array holding contents of a single
- *                              sector of a dir from a FAT-formatted disk.
- *               lnStr        - Pointer to a string array that will be loaded
- *                              with the characters from a long name entry.
+ * Arguments   : lnEnt   - Pointer to the 32 byte long name entry.
+ *               lnStr   - Pointer to a string array holding the characters 
+ *                         from the previously loaded long name entries. The
+ *                         characters of lnEnt will be inserted before them.
  * 
  * Returns     : void 
  * 
- * Notes       : Must be called twice if long name crosses sector boundary.
+ * Notes       : 1) Long name entries are stored in a directory in descending
+ *                  order of their ordinal, therefore the characters of each 
+ *                  one precede those of the entry that was loaded before it.
+ *               2) The chars are loaded by pvt_LoadLongNameChars.
+ *               3) The string is truncated at LN_STR_LEN_MAX - 1 characters.
  * ----------------------------------------------------------------------------
  */
-static void pvt_LoadLongName(int lnFirstEnt, int lnLastEnt,
-                             const uint8_t secArr[], char lnStr[])
+static void pvt_PrependLongName(const uint8_t lnEnt[], char lnStr[])
 {
+  // load the chars of this entry into entStr.
+  char    entStr[2 * LN_CHARS_PER_ENTRY];
+  uint8_t entLen = pvt_LoadLongNameChars(lnEnt, entStr);
+
+  // shift previously loaded chars to make room. Drop any beyond the max len.
+  uint8_t strLen = strlen(lnStr);
+  if (entLen + strLen > LN_STR_LEN_MAX - 1)
+    strLen = LN_STR_LEN_MAX - 1 - entLen;
+  memmove(lnStr + entLen, lnStr, strLen);
+  lnStr[entLen + strLen] = '\0';
+  memcpy(lnStr, entStr, entLen);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  (PRIVATE) SCAN CURSOR ENTRY
+ * 
+ * Description : Moves a cursor to the next short name entry in its directory,
+ *               checking the long name entries before it, and sets a 
+ *               FatEntryRef to it. The cursor is left on the short name entry
+ *               with its sector in secArr.
+ * 
+ * Arguments   : cur         - Pointer to the FatCursor instance.
+ *               ref         - Pointer to the FatEntryRef instance to set.
+ *               lnStr       - Array of LN_STR_LEN_MAX chars holding an empty
+ *                             string, which the long name is decoded into. If
+ *                             0 (a null pointer) the long name is not decoded.
+ *               secBudget   - As for fat_CursorScanEntry.
+ *               bpb         - Pointer to the BPB struct instance.
+ * 
+ * Returns     : A FAT Error Flag, as for fat_CursorScanEntry.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_CursorScan(FatCursor *cur, FatEntryRef *ref, char lnStr[],
+                              uint8_t *secBudget, const BPB *bpb)
+{
+  uint8_t err;
+
   //
-  // set lnStr to point to first null char in array. This will be position 0 
-  // except when function is called twice to load a long name that crosses 
-  // sector boundaries.
+  // Long name entries precede their short name entry in descending order of
+  // their ordinal (LN_ORD_MASK). lnOrd is the ordinal expected of the next
+  // long name entry. It is 0 when not inside a long name, or once the entry
+  // with ordinal 1 has been loaded, in which case inLn will still be set and
+  // the next entry must be the short name entry. 
   //
-  for (; *lnStr; ++lnStr)
-    ;
-  
-  // loop over the entries in the sector containing the long name
-  for (int entPos = lnFirstEnt; entPos >= lnLastEnt; entPos -= ENTRY_LEN)
-  {                                              
+  uint8_t lnOrd = 0;
+  uint8_t inLn = 0;
+
+  //
+  // Position of the first entry of the long name being read, and whether it
+  // is in a sector read by this call. Used to restart the long name if the
+  // sector budget runs out part way through it.
+  //
+  uint32_t lnClusIndx = 0;
+  uint16_t lnClusNum = 0;
+  uint8_t  lnSecNumInClus = 0;
+  uint16_t lnEntPos = 0;
+  uint8_t  lnInReadSec = 0;
+  uint8_t  secRead = 0;
+  uint8_t  lnEntCnt = 0;
+
+  // loop over the entries following the cursor until a short name is found.
+  for (;; pvt_AdvanceCursor(cur))
+  {
     //
-    // loops to load long name chars from a single entry. Skips any nulls and 
-    // any characters outside of the standard ascii range.
-    // 
-    for (uint16_t byteNum = entPos + LN_CHAR_RANGE_1_BEGIN; 
-         byteNum < entPos + LN_CHAR_RANGE_1_END; byteNum++)
-      if (secArr[byteNum] && secArr[byteNum] <= LAST_STD_ASCII_CHAR)
-        *lnStr++ = secArr[byteNum];
-
-    for (uint16_t byteNum = entPos + LN_CHAR_RANGE_2_BEGIN; 
-         byteNum < entPos + LN_CHAR_RANGE_2_END; byteNum++)
-      if (secArr[byteNum] && secArr[byteNum] <= LAST_STD_ASCII_CHAR)
-        *lnStr++ = secArr[byteNum];
-    
-    for (uint16_t byteNum = entPos + LN_CHAR_RANGE_3_BEGIN;
-         byteNum < entPos + LN_CHAR_RANGE_3_END; byteNum++)
-      if (secArr[byteNum] && secArr[byteNum] <= LAST_STD_ASCII_CHAR)
-        *lnStr++ = secArr[byteNum];    
+    // stop before reading another sector if the budget is used up. If this
+    // is part way through a long name, the cursor is moved back to its first
+    // entry, unless that is in a sector read by this call. The long name is
+    // then finished, so that every call makes progress.
+    //
+    if (!cur->secLoaded && secBudget)
+    {
+      if (*secBudget)
+        --*secBudget;
+      else if (!inLn)
+        return SCAN_YIELD;
+      else if (!lnInReadSec)
+      {
+        cur->clusIndx = lnClusIndx;
+        cur->clusNum = lnClusNum;
+        cur->secNumInClus = lnSecNumInClus;
+        cur->entPos = lnEntPos;
+        return SCAN_YIELD;
+      }
+    }
+
+    // load the sector holding the cursor's entry if not already loaded. 
+    if (!cur->secLoaded)
+      secRead = 1;
+    if ((err = pvt_LoadCursorSector(cur, bpb)) != SUCCESS)
+      return err;
+
+    const uint8_t *entArr = cur->secArr + cur->entPos;
+
+    // if first byte of an entry is 0, remaining entries should be empty
+    if (!entArr[0])
+      return inLn ? CORRUPT_FAT_ENTRY : END_OF_DIRECTORY;
+
+    if (entArr[0] == DELETED_ENTRY_TOKEN)
+    {
+      if (inLn)                             // entries of a ln can't be deleted
+        return CORRUPT_FAT_ENTRY;
+      continue;
+    }
+
+    // check attribute byte to see if entry is a long name entry
+    if ((entArr[ATTR_BYTE_OFFSET] & LN_ATTR_MASK) == LN_ATTR_MASK)
+    {
+      //
+      // The first long name entry found must be flagged as the last entry of
+      // the long name. Its ordinal gives the number of long name entries.
+      //
+      if (!inLn)
+      {
+        if (!(entArr[0] & LN_LAST_ENTRY_FLAG))
+          return CORRUPT_FAT_ENTRY;
+        lnOrd = entArr[0] & LN_ORD_MASK;
+        lnEntCnt = lnOrd;
+        inLn = 1;
+        lnClusIndx = cur->clusIndx;
+        lnClusNum = cur->clusNum;
+        lnSecNumInClus = cur->secNumInClus;
+        lnEntPos = cur->entPos;
+        lnInReadSec = secRead;
+      }
+
+      // entry must have the next ordinal. lnOrd is 0 if sn entry is expected.
+      if (!lnOrd || (entArr[0] & LN_ORD_MASK) != lnOrd)
+        return CORRUPT_FAT_ENTRY;
+      --lnOrd;
+
+      // the long name is only decoded if a string was passed.
+      if (lnStr)
+        pvt_PrependLongName(entArr, lnStr);
+    }
+    else                                    // short name entry
+    {
+      // all entries of a long name must have been found before its sn entry.
+      if (lnOrd)
+        return CORRUPT_FAT_ENTRY;
+
+      // reference the first ln entry, if any, and the sn entry.
+      ref->lnEntCnt = 0;
+      ref->entNum = pvt_GetEntNum(cur->clusNum, cur->secNumInClus, 
+                                  cur->entPos, bpb);
+      if (inLn)
+      {
+        ref->lnClusIndx = lnClusIndx;
+        ref->lnSecNumInClus = lnSecNumInClus;
+        ref->lnEntPos = lnEntPos;
+        ref->lnEntCnt = lnEntCnt;
+        ref->entNum = pvt_GetEntNum(lnClusNum, lnSecNumInClus, lnEntPos, bpb);
+      }
+      ref->snClusIndx = cur->clusIndx;
+      ref->snSecNumInClus = cur->secNumInClus;
+      ref->snEntPos = cur->entPos;
+      ref->attr = entArr[ATTR_BYTE_OFFSET];
+      ref->snChkSum = inLn ? pvt_GetShortNameChkSum(entArr) : 0;
+      ref->fstClusIndx = pvt_GetEntFstClus(entArr);
+      ref->fileSize = pvt_GetEntFileSize(entArr);
+      return SUCCESS;
+    }
+  }
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    (PRIVATE) LOAD SHORT NAME
+ * 
+ * Description : Parses the name + ext chars of a short name entry and loads 
+ *               them into a string, as "NAME.EXT".
+ * 
+ * Arguments   : snEnt   - Pointer to the 32 bytes of the short name entry.
+ *               snStr   - Array of at least SN_CHAR_LEN + 1 chars. The short
+ *                         name is loaded here as a string.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_LoadShortName(const uint8_t snEnt[], char snStr[])
+{
+  // load short name characters into array. skip spaces.
+  for (uint8_t byteNum = 0; byteNum < SN_NAME_CHAR_LEN; ++byteNum)
+    if (snEnt[byteNum] != ' ')
+      *snStr++ = snEnt[byteNum];
+
+  // if there is an extension add it to sn string here
+  if (snEnt[SN_NAME_CHAR_LEN] != ' ')
+  {
+    *snStr++ = '.';
+    // load extension chars into array. Skip spaces stop at end of ext chars.
+    for (uint8_t byteNum = SN_NAME_CHAR_LEN; 
+         byteNum < SN_CHAR_LEN - 1; ++byteNum)
+      if (snEnt[byteNum] != ' ')
+        *snStr++ = snEnt[byteNum];
+  }
+  *snStr = '\0';
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                      (PRIVATE) GET FIRST CLUSTER / FILE SIZE
+ * 
+ * Description : Returns the FAT index of the first cluster, or the file size,
+ *               held by a short name entry.
+ * 
+ * Arguments   : snEnt   - Pointer to the 32 bytes of the short name entry.
+ * 
+ * Returns     : The first cluster index or the file size.
+ * ----------------------------------------------------------------------------
+ */
+static uint32_t pvt_GetEntFstClus(const uint8_t snEnt[])
+{
+  //
+  // bytes 20, 21, 26 and 27 of a short name entry give the value of the
+  // first cluster index in the FAT for that entry.
+  //
+  uint32_t fstClusIndx;
+  fstClusIndx = snEnt[FST_CLUS_INDX_BYTE_OFFSET_3];
+  fstClusIndx <<= 8;
+  fstClusIndx |= snEnt[FST_CLUS_INDX_BYTE_OFFSET_2];
+  fstClusIndx <<= 8;
+  fstClusIndx |= snEnt[FST_CLUS_INDX_BYTE_OFFSET_1];
+  fstClusIndx <<= 8;
+  fstClusIndx |= snEnt[FST_CLUS_INDX_BYTE_OFFSET_0];
+  return fstClusIndx;
+}
+
+static uint32_t pvt_GetEntFileSize(const uint8_t snEnt[])
+{
+  uint32_t fileSize;
+  fileSize = snEnt[FILE_SIZE_BYTE_OFFSET_3];
+  fileSize <<= 8;
+  fileSize |= snEnt[FILE_SIZE_BYTE_OFFSET_2];
+  fileSize <<= 8;
+  fileSize |= snEnt[FILE_SIZE_BYTE_OFFSET_1];
+  fileSize <<= 8;
+  fileSize |= snEnt[FILE_SIZE_BYTE_OFFSET_0];
+  return fileSize;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                            (PRIVATE) GET SHORT NAME CHECKSUM
+ * 
+ * Description : Calculates the checksum of the 11 name + ext chars of a short
+ *               name entry. Each long name entry of the short name holds it.
+ * 
+ * Arguments   : snEnt   - Pointer to the 32 bytes of the short name entry.
+ * 
+ * Returns     : The checksum.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_GetShortNameChkSum(const uint8_t snEnt[])
+{
+  uint8_t chkSum = 0;
+
+  // rotate the sum right one bit then add the next char.
+  for (uint8_t byteNum = 0; byteNum < SN_CHAR_LEN - 1; ++byteNum)
+    chkSum = ((chkSum & 1) << 7) + (chkSum >> 1) + snEnt[byteNum];
+  return chkSum;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                          (PRIVATE) LOAD LONG NAME ENTRY CHARS
+ * 
+ * Description : Loads the chars of a single long name entry into an array, in
+ *               the form they take in a decoded long name.
+ * 
+ * Arguments   : lnEnt    - Pointer to the 32 byte long name entry.
+ *               entStr   - Array of at least 2 * LN_CHARS_PER_ENTRY chars. 
+ *                          The chars are loaded here. Not null terminated.
+ * 
+ * Returns     : Number of chars loaded.
+ * 
+ * Notes       : Each byte of the entry's UTF-16 chars is taken as a char. 
+ *               Nulls and any bytes outside of the standard ascii range are
+ *               skipped, so non-ascii chars, the null after the last char 
+ *               and the 0xFFFF padding after it are not loaded.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_LoadLongNameChars(const uint8_t lnEnt[], char entStr[])
+{
+  // the char ranges of a single long name entry.
+  const uint8_t rangeBegin[] = {LN_CHAR_RANGE_1_BEGIN, LN_CHAR_RANGE_2_BEGIN,
+                                LN_CHAR_RANGE_3_BEGIN};
+  const uint8_t rangeEnd[]   = {LN_CHAR_RANGE_1_END, LN_CHAR_RANGE_2_END,
+                                LN_CHAR_RANGE_3_END};
+  uint8_t entLen = 0;
+
+  for (uint8_t range = 0; range < sizeof(rangeBegin); ++range)
+    for (uint8_t byteNum = rangeBegin[range]; byteNum < rangeEnd[range]; 
+         ++byteNum)
+      if (lnEnt[byteNum] && lnEnt[byteNum] <= LAST_STD_ASCII_CHAR)
+        entStr[entLen++] = lnEnt[byteNum];
+  return entLen;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                (PRIVATE) GET LONG NAME LENGTH
+ * 
+ * Description : Finds the length of the long name of the entry referenced by
+ *               a FatEntryRef, as loaded by pvt_LoadLongNameChars and before
+ *               it is truncated to LN_STR_LEN_MAX - 1 chars.
+ * 
+ * Arguments   : ref     - Pointer to a FatEntryRef with a long name.
+ *               lnLen   - Pointer to the integer to be set to the length.
+ *               bpb     - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS, FAILED_READ_SECTOR or CORRUPT_FAT_ENTRY, as for
+ *               fat_GetEntryName.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_GetLongNameLen(const FatEntryRef *ref, uint16_t *lnLen,
+                                  const BPB *bpb)
+{
+  uint8_t  err;
+  const uint8_t *entArr;
+  char     entStr[2 * LN_CHARS_PER_ENTRY];
+  uint32_t clusIndx = ref->lnClusIndx;
+  uint8_t  secNumInClus = ref->lnSecNumInClus;
+  uint16_t entPos = ref->lnEntPos;
+
+  *lnLen = 0;
+  for (uint8_t lnEnt = 0; lnEnt < ref->lnEntCnt; ++lnEnt)
+  {
+    if (pvt_GetRefEntry(clusIndx, secNumInClus, entPos, &entArr, bpb) 
+        != SUCCESS)
+      return FAILED_READ_SECTOR;
+    *lnLen += pvt_LoadLongNameChars(entArr, entStr);
+
+    if ((err = pvt_NextRefEntPos(&clusIndx, &secNumInClus, &entPos, bpb))
+        != SUCCESS)
+      return err;
   }
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                      (PRIVATE) NEXT REFERENCED ENTRY POSITION
+ * 
+ * Description : Moves the location of a 32-byte entry to the entry after it,
+ *               following the directory's cluster chain.
+ * 
+ * Arguments   : clusIndx       - Pointer to the FAT index of the cluster
+ *                                holding the entry.
+ *               secNumInClus   - Pointer to the sector number of the entry in
+ *                                the cluster.
+ *               entPos         - Pointer to the position of the entry in the
+ *                                sector.
+ *               bpb            - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY if the 
+ *               entry is the last of the directory's cluster chain. This is
+ *               only used for long name entries, which are always followed 
+ *               by their short name entry.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_NextRefEntPos(uint32_t *clusIndx, uint8_t *secNumInClus,
+                                 uint16_t *entPos, const BPB *bpb)
+{
+  *entPos += ENTRY_LEN;
+  if (*entPos < SECTOR_LEN)
+    return SUCCESS;
+
+  *entPos = FIRST_ENT_POS_IN_SEC;
+  if (++*secNumInClus < bpb->secPerClus)
+    return SUCCESS;
+
+  *secNumInClus = FIRST_SEC_POS_IN_CLUS;
+  if (pvt_GetNextClusIndex(clusIndx, bpb) != SUCCESS)
+    return FAILED_READ_SECTOR;
+  return (*clusIndx == END_CLUSTER) ? CORRUPT_FAT_ENTRY : SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                               (PRIVATE) GET REFERENCED ENTRY
+ * 
+ * Description : Points to a directory entry, given its location, in the 
+ *               cached copy of the sector holding it.
+ * 
+ * Arguments   : clusIndx       - FAT index of the cluster holding the entry.
+ *               secNumInClus   - Sector number of the entry in the cluster.
+ *               entPos         - Position of the entry in the sector.
+ *               entArr         - Set to point to the first byte of the entry.
+ *               bpb            - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS or FAILED_READ_SECTOR.
+ * 
+ * Notes       : The pointer is only valid until the next cache access.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_GetRefEntry(uint32_t clusIndx, uint8_t secNumInClus, 
+                               uint16_t entPos, const uint8_t **entArr, 
+                               const BPB *bpb)
+{
+  const uint8_t *secArr;
+  uint32_t secNumOnDisk = secNumInClus + bpb->dataRegionFirstSector
+                        + (clusIndx - bpb->rootClus) * bpb->secPerClus;
+
+  if (fat_CacheGetSector(secNumOnDisk, &secArr) == FAILED_READ_SECTOR)
+    return FAILED_READ_SECTOR;
+  *entArr = secArr + entPos;
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   (PRIVATE) GET ENTRY NUMBER
+ * 
+ * Description : Returns the number of a 32-byte entry in its directory, 
+ *               counting from 0, given its position.
+ * 
+ * Arguments   : clusNum        - Position of the entry's cluster in the 
+ *                                directory's cluster chain.
+ *               secNumInClus   - Sector number of the entry in the cluster.
+ *               entPos         - Position of the entry in the sector.
+ *               bpb            - Pointer to the BPB struct instance.
+ * 
+ * Returns     : The entry number.
+ * ----------------------------------------------------------------------------
+ */
+static uint16_t pvt_GetEntNum(uint16_t clusNum, uint8_t secNumInClus, 
+                              uint16_t entPos, const BPB *bpb)
+{
+  return ((uint16_t)clusNum * bpb->secPerClus + secNumInClus) 
+         * ENTRIES_PER_SEC + entPos / ENTRY_LEN;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                     (PRIVATE) ADVANCE CURSOR
+ * 
+ * Description : Moves a cursor to the next entry position in its directory.
+ * 
+ * Arguments   : cur   - Pointer to the FatCursor instance.
+ * 
+ * Returns     : void 
+ * 
+ * Notes       : No disk access occurs here. If the cursor crosses a sector 
+ *               boundary, it is marked as not loaded and the next sector (and
+ *               cluster, if needed) is located by pvt_LoadCursorSector.
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_AdvanceCursor(FatCursor *cur)
+{
+  cur->entPos += ENTRY_LEN;
+  if (cur->entPos >= SECTOR_LEN)
+  {
+    cur->entPos = FIRST_ENT_POS_IN_SEC;
+    ++cur->secNumInClus;
+    cur->secLoaded = 0;
+  }
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                 (PRIVATE) LOAD CURSOR SECTOR
+ * 
+ * Description : Ensures the secArr member of a cursor holds the directory 
+ *               sector containing the cursor's entry position. 
+ * 
+ * Arguments   : cur   - Pointer to the FatCursor instance.
+ *               bpb   - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS, END_OF_DIRECTORY if the end of the cluster chain was
+ *               reached, or FAILED_READ_SECTOR.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_LoadCursorSector(FatCursor *cur, const BPB *bpb)
+{
+  if (cur->secLoaded)
+    return SUCCESS;
+
+  // entry position may be at the end of a sector if set from a FatEntry. 
+  if (cur->entPos >= SECTOR_LEN)
+  {
+    cur->entPos = FIRST_ENT_POS_IN_SEC;
+    ++cur->secNumInClus;
+  }
+
+  if (cur->clusIndx == END_CLUSTER)
+    return END_OF_DIRECTORY;
+
+  // if past the last sector of the cluster, move to the next cluster.
+  if (cur->secNumInClus >= bpb->secPerClus)
+  {
+    if (pvt_GetNextClusIndex(&cur->clusIndx, bpb) != SUCCESS)
+      return FAILED_READ_SECTOR;
+    ++cur->clusNum;
+    cur->secNumInClus = FIRST_SEC_POS_IN_CLUS;
+    if (cur->clusIndx == END_CLUSTER)
+      return END_OF_DIRECTORY;
+  }
+
+  // calculate location of sector on the disk and load it.
+  uint32_t secNumOnDisk = cur->secNumInClus + bpb->dataRegionFirstSector
+                        + (cur->clusIndx - bpb->rootClus) * bpb->secPerClus;
+  if (fat_CacheReadSector(secNumOnDisk, cur->secArr) == FAILED_READ_SECTOR)
+    return FAILED_READ_SECTOR;
+
+  cur->secLoaded = 1;
+  return SUCCESS;
 }
 
 /*
  * ----------------------------------------------------------------------------
  *                              (PRIVATE) GET THE FAT INDEX OF THE NEXT CLUSTER
  * 
- * Description : Finds and returns the next FAT cluster index.
+ * Description : Finds the next FAT cluster index of a file or dir.
  * 
- * Arguments   : clusIndex   - The current cluster's FAT index.
- *               bpb         - Pointer to the BPB struct instance.
+ * Arguments   : clusIndx   - Pointer to the current cluster's FAT index. It
+ *                            is updated to the index of the next cluster, or
+ *                            to END_CLUSTER if the current cluster is the 
+ *                            last of the file or dir. It is not changed if
+ *                            FAILED_READ_SECTOR is returned.
+ *               bpb        - Pointer to the BPB struct instance.
  * 
- * Returns     : A file or dir's next FAT cluster index. If END_CLUSTER is 
- *               returned, the current cluster is the last of the file or dir.
+ * Returns     : SUCCESS or FAILED_READ_SECTOR if the FAT sector could not be
+ *               read.
  * 
- * Notes       : The returned value locates the index in the FAT. The index is
+ * Notes       : The index locates the index in the FAT. The index is
  *               offset (typically by -2) from the actual cluster number in the
  *               data region. The root cluster is always cluster 0 in the data
  *               region, but its FAT index is 2 or higher.
  * ----------------------------------------------------------------------------
  */
-static uint32_t pvt_GetNextClusIndex(uint32_t clusIndx, const BPB *bpb)
+static uint8_t pvt_GetNextClusIndex(uint32_t *clusIndx, const BPB *bpb)
 {
   // calculate address of sector containing the current cluster index
   uint16_t fatIndxsPerSec = bpb->bytesPerSec / BYTES_PER_INDEX;
-  uint32_t fatSectorToRead = (clusIndx / fatIndxsPerSec) + bpb->rsvdSecCnt;
+  uint32_t fatSectorToRead = (*clusIndx / fatIndxsPerSec) + bpb->rsvdSecCnt;
 
-  // load current cluster's index sector into secArr
-  uint8_t secArr[bpb->bytesPerSec];
-  FATtoDisk_ReadSingleSector(fatSectorToRead, secArr);
+  // point secArr to the cached FAT sector holding the current cluster index
+  const uint8_t *secArr;
+  if (fat_CacheGetSector(fatSectorToRead, &secArr) == FAILED_READ_SECTOR)
+    return FAILED_READ_SECTOR;
 
   // Value at the current cluster index is the index of the next cluster.
   uint32_t nextClusIndx = 0;
   uint16_t posNextClusIndxInSec = BYTES_PER_INDEX 
-                                  * (clusIndx % fatIndxsPerSec);
+                                  * (*clusIndx % fatIndxsPerSec);
  
   // load the index of the next cluster.
   for (uint8_t offset = BYTES_PER_INDEX - 1; offset > 0; --offset)
@@ -869,7 +1818,8 @@ static uint32_t pvt_GetNextClusIndex(uint32_t clusIndx, const BPB *bpb)
   }
   nextClusIndx |= secArr[posNextClusIndxInSec];
 
-  return nextClusIndx;
+  *clusIndx = nextClusIndx;
+  return SUCCESS;
 }
 
 /*
@@ -887,7 +1837,13 @@ static uint32_t pvt_GetNextClusIndex(uint32_t clusIndx, const BPB *bpb)
  */
 static void pvt_PrintEntFields(const uint8_t secArr[], uint8_t flags)
 {
-  print_Str ("\n\r");
+  //
+  // The fields are formatted into a line buffer and sent in one call. Each
+  // 2-digit field is zero padded.
+  //
+  PrintBuf line;
+  print_BufInit(&line);
+  print_BufStrP(&line, PSTR("\n\r"));
 
   // Print creation date and time 
   if (CREATION & flags)
@@ -903,44 +1859,21 @@ static void pvt_PrintEntFields(const uint8_t secArr[], uint8_t flags)
     createTime <<= 8;
     createTime |= secArr[CREATION_TIME_BYTE_OFFSET_0];
 
-    // print month
-    print_Str("    ");
-    uint8_t month = MONTH_CALC(createDate);
-    if (month < 10)
-      print_Str("0");    
-    print_Dec(month);
-    print_Str("/");
-
-    // print day
-    uint8_t day = DAY_CALC(createDate);
-    if (day < 10)
-      print_Str("0");
-    print_Dec(day);
-    print_Str("/");
-
-    // print year
-    print_Dec((uint16_t)YEAR_CALC(createDate));
-    print_Str("  ");
-
-    // print hours
-    uint8_t hour = HOUR_CALC(createTime);
-    if (hour < 10) 
-      print_Str("0");
-    print_Dec(hour);
-    print_Str(":");
-
-    // print minutes
-    uint8_t min = MIN_CALC(createTime);
-    if (min < 10)
-      print_Str("0");
-    print_Dec(min);
-    print_Str(":");
-
-    // print seconds (resolution is 2 seconds).
-    uint8_t sec = SEC_CALC(createTime);
-    if (sec < 10) 
-      print_Str("0");
-    print_Dec(sec);
+    // print month / day / year
+    print_BufStrP(&line, PSTR("    "));
+    print_BufDec(&line, MONTH_CALC(createDate), 2, '0');
+    print_BufChar(&line, '/');
+    print_BufDec(&line, DAY_CALC(createDate), 2, '0');
+    print_BufChar(&line, '/');
+    print_BufDec(&line, YEAR_CALC(createDate), 0, ' ');
+    print_BufStrP(&line, PSTR("  "));
+
+    // print hours : minutes : seconds (resolution is 2 seconds).
+    print_BufDec(&line, HOUR_CALC(createTime), 2, '0');
+    print_BufChar(&line, ':');
+    print_BufDec(&line, MIN_CALC(createTime), 2, '0');
+    print_BufChar(&line, ':');
+    print_BufDec(&line, SEC_CALC(createTime), 2, '0');
   }
 
   // Print last access date
@@ -953,23 +1886,13 @@ static void pvt_PrintEntFields(const uint8_t secArr[], uint8_t flags)
     lastAccDate <<= 8;
     lastAccDate |= secArr[LAST_ACCESS_DATE_BYTE_OFFSET_0];
 
-    // print month
-    print_Str("     ");
-    uint8_t month = MONTH_CALC(lastAccDate);
-    if (month < 10)
-      print_Str("0");
-    print_Dec(month);
-    print_Str("/");
-
-    // print day
-    uint8_t day = DAY_CALC(lastAccDate);
-    if (day < 10)
-      print_Str("0");
-    print_Dec(day);
-    print_Str("/");
-
-    // print year
-    print_Dec((uint16_t)YEAR_CALC(lastAccDate));
+    // print month / day / year
+    print_BufStrP(&line, PSTR("     "));
+    print_BufDec(&line, MONTH_CALC(lastAccDate), 2, '0');
+    print_BufChar(&line, '/');
+    print_BufDec(&line, DAY_CALC(lastAccDate), 2, '0');
+    print_BufChar(&line, '/');
+    print_BufDec(&line, YEAR_CALC(lastAccDate), 0, ' ');
   }
 
   // Print last modified date / time
@@ -987,46 +1910,23 @@ static void pvt_PrintEntFields(const uint8_t secArr[], uint8_t flags)
     writeTime <<= 8;
     writeTime |= secArr[WRITE_TIME_BYTE_OFFSET_0];
   
-    // print month
-    print_Str("     ");
-    uint8_t month = MONTH_CALC(writeDate);
-    if (month < 10) 
-      print_Str("0");
-    print_Dec(month);
-    print_Str("/");
-    
-    // print day
-    uint8_t day = DAY_CALC(writeDate);
-    if (day < 10) 
-      print_Str("0");
-    print_Dec(day);
-    print_Str("/");
-
-    // print year
-    print_Dec((uint16_t)YEAR_CALC(writeDate));
-    print_Str("  ");
-
-    // print hour
-    uint8_t hour = HOUR_CALC(writeTime);
-    if (hour < 10)
-      print_Str("0");
-    print_Dec(hour);
-    print_Str(":");
-
-    // print minute
-    uint8_t min = MIN_CALC(writeTime);   
-    if (min < 10) 
-      print_Str("0");
-    print_Dec(min);
-    print_Str(":");
-
-    // print second
-    uint8_t sec = SEC_CALC(writeTime);
-    if (sec < 10) 
-      print_Str("0");
-    print_Dec(sec);
+    // print month / day / year
+    print_BufStrP(&line, PSTR("     "));
+    print_BufDec(&line, MONTH_CALC(writeDate), 2, '0');
+    print_BufChar(&line, '/');
+    print_BufDec(&line, DAY_CALC(writeDate), 2, '0');
+    print_BufChar(&line, '/');
+    print_BufDec(&line, YEAR_CALC(writeDate), 0, ' ');
+    print_BufStrP(&line, PSTR("  "));
+
+    // print hour : minute : second
+    print_BufDec(&line, HOUR_CALC(writeTime), 2, '0');
+    print_BufChar(&line, ':');
+    print_BufDec(&line, MIN_CALC(writeTime), 2, '0');
+    print_BufChar(&line, ':');
+    print_BufDec(&line, SEC_CALC(writeTime), 2, '0');
   }
-  print_Str("     ");
+  print_BufStrP(&line, PSTR("     "));
 
   // Print file size in bytes
   if (FILE_SIZE & flags)
@@ -1042,26 +1942,23 @@ static void pvt_PrintEntFields(const uint8_t secArr[], uint8_t flags)
     fileSize <<= 8;
     fileSize |= secArr[FILE_SIZE_BYTE_OFFSET_0];
 
-    // Print spaces for formatting output. Add 1 to prevent starting at 0.
-    for (uint64_t sp = 1 + fileSize / FS_UNIT; sp < GIGA / FS_UNIT; sp *= 10)
-      print_Str(" ");
-
-    // print file size and selected units
-    print_Dec(fileSize / FS_UNIT);
+    // print file size, right aligned, and selected units
+    print_BufDec(&line, fileSize / FS_UNIT, FS_WIDTH, ' ');
     if (FS_UNIT == KILO)                               
-      print_Str("KB  ");
+      print_BufStrP(&line, PSTR("KB  "));
     else  
-      print_Str("B  ");
+      print_BufStrP(&line, PSTR("B  "));
   }
 
   // print entry type
   if (TYPE & flags)
   {
     if (secArr[ATTR_BYTE_OFFSET] & DIR_ENTRY_ATTR) 
-      print_Str(" <DIR>   ");
+      print_BufStrP(&line, PSTR(" <DIR>   "));
     else 
-      print_Str(" <FILE>  ");
+      print_BufStrP(&line, PSTR(" <FILE>  "));
   }
+  print_BufFlush(&line);
 }
 
 /*
@@ -1071,82 +1968,270 @@ static void pvt_PrintEntFields(const uint8_t secArr[], uint8_t flags)
  * Description : Performs 'print file' operation. This will output the contents
  *               of any file to the screen.
  * 
- * Arguments   : snEnt   - Pointer to 32 byte array holding the sn entry.
+ * Arguments   : file    - Pointer to a FatFile instance set by fat_Open.
  *               bpb     - Pointer to the BPB struct instance.
  * 
- * Returns     : END_OF_FILE (success) or FAILED_READ_SECTOR fat error flag.
+ * Returns     : END_OF_FILE (success) or the error returned by fat_Read.
  * ----------------------------------------------------------------------------
  */
-static uint8_t pvt_PrintFile(const uint8_t snEnt[], const BPB *bpb)
+static uint8_t pvt_PrintFile(FatFile *file, const BPB *bpb)
 {
-  //get FAT index for file's first cluster
-  uint32_t clus; 
-  clus = snEnt[FST_CLUS_INDX_BYTE_OFFSET_3];
-  clus <<= 8;
-  clus |= snEnt[FST_CLUS_INDX_BYTE_OFFSET_2];
-  clus <<= 8;
-  clus |= snEnt[FST_CLUS_INDX_BYTE_OFFSET_1];
-  clus <<= 8;
-  clus |= snEnt[FST_CLUS_INDX_BYTE_OFFSET_0];
-
-  // loop over clusters to read in and print file
+  uint8_t  err;
+  uint8_t  buf[PRINT_FILE_BUF_LEN];
+  uint16_t cnt;
+
+  // read the file in PRINT_FILE_BUF_LEN byte pieces until the end is reached.
   do
   {
-    // loop over sectors in the cluster to read in and print file
-    for (uint32_t secNumInClus = 0; secNumInClus < bpb->secPerClus; 
-         ++secNumInClus)
+    err = fat_Read(file, buf, PRINT_FILE_BUF_LEN, &cnt, bpb);
+    for (uint16_t byteNum = 0; byteNum < cnt; ++byteNum)
+    {
+      // 
+      // for output formatting. Currently using terminal that requires "\n\r"
+      // to go to the start of the next line. Therefore if '\n' is detected
+      // need to print "\n\r".
+      //
+      if (buf[byteNum] == '\n') 
+        print_StrP (PSTR("\n\r"));
+        
+      // else if not 0, just print the character directly to the screen.
+      else if (buf[byteNum])
+        usart_Transmit(buf[byteNum]);
+    }
+  }
+  while (err == SUCCESS);
+  
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                          (PRIVATE) SET FILE CLUSTER POSITION
+ * 
+ * Description : Sets the clusIndx member of a FatFile instance to the cluster
+ *               at position clusNum in the file's cluster chain.
+ * 
+ * Arguments   : file      - Pointer to a FatFile instance set by fat_Open.
+ *               clusNum   - Position of the cluster in the chain. The first
+ *                           cluster of the file is at position 0.
+ *               bpb       - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY if the 
+ *               chain ends before clusNum.
+ * 
+ * Notes       : The extent starting at or before clusNum is found by a binary
+ *               search of the file's extent map. If clusNum is in that extent
+ *               no disk access occurs. Otherwise (sparse map) the chain is 
+ *               followed from the end of that extent, or from the current 
+ *               cluster if it is closer.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_SetFileClus(FatFile *file, uint32_t clusNum, 
+                               const BPB *bpb)
+{
+  if (clusNum == file->clusNum)
+    return SUCCESS;
+
+  if (file->extCnt)
+  {
+    const FatExtent *ext = pvt_FindExtent(file, clusNum);
+    uint32_t extLastClus = ext->fileClus + ext->clusCnt - 1;
+
+    // clusNum is inside the extent. 
+    if (clusNum <= extLastClus)
     {
-      // calculate address of the sector on the physical disk
-      uint32_t secNumOnDisk = secNumInClus + bpb->dataRegionFirstSector
-                          + (clus - bpb->rootClus) * bpb->secPerClus;
+      file->clusIndx = ext->clusIndx + (clusNum - ext->fileClus);
+      file->clusNum = clusNum;
+      return SUCCESS;
+    }
 
-      // read disk sector into the sector array
-      uint8_t secArr[bpb->bytesPerSec];
-      if (FATtoDisk_ReadSingleSector(secNumOnDisk, secArr) 
-          == FAILED_READ_SECTOR)
-        return FAILED_READ_SECTOR;
+    // start from the end of the extent unless current cluster is closer.
+    if (file->clusNum < extLastClus || file->clusNum > clusNum)
+    {
+      file->clusIndx = ext->clusIndx + ext->clusCnt - 1;
+      file->clusNum = extLastClus;
+    }
+  }
+  else if (clusNum < file->clusNum)
+  {
+    file->clusIndx = file->fstClusIndx;
+    file->clusNum = 0;
+  }
 
-      for (uint16_t byteNum = 0; byteNum < bpb->bytesPerSec; ++byteNum)
+  for (; file->clusNum < clusNum; ++file->clusNum)
+  {
+    uint8_t err = pvt_GetNextClusIndex(&file->clusIndx, bpb);
+    if (err == SUCCESS && file->clusIndx == END_CLUSTER)
+      err = CORRUPT_FAT_ENTRY;
+    if (err != SUCCESS)
+    {
+      // return to the first cluster so the handle stays valid.
+      file->clusIndx = file->fstClusIndx;
+      file->clusNum = 0;
+      return err;
+    }
+  }
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        (PRIVATE) FIND EXTENT
+ * 
+ * Description : Binary search of a file's extent map for the last extent that
+ *               starts at or before clusNum.
+ * 
+ * Arguments   : file      - Pointer to a FatFile instance set by fat_Open. Its
+ *                           extCnt member must not be 0.
+ *               clusNum   - Position of a cluster in the file's chain.
+ * 
+ * Returns     : Pointer to the extent. clusNum is only inside the extent if
+ *               it is less than the extent's fileClus + clusCnt.
+ * ----------------------------------------------------------------------------
+ */
+static const FatExtent *pvt_FindExtent(const FatFile *file, uint32_t clusNum)
+{
+  // ext[0] always starts at cluster 0 of the file.
+  uint8_t lo = 0;
+  uint8_t hi = file->extCnt - 1;
+  while (lo < hi)
+  {
+    uint8_t mid = (lo + hi + 1) / 2;
+    if (file->ext[mid].fileClus <= clusNum)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  return &file->ext[lo];
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                  (PRIVATE) GET NUMBER OF CONSECUTIVE SECTORS
+ * 
+ * Description : Returns the number of sectors that are consecutive on the disk
+ *               beginning at a sector of a file's current cluster. 
+ * 
+ * Arguments   : file           - Pointer to a FatFile instance set by fat_Open.
+ *               secNumInClus   - Number of the sector in the current cluster.
+ *               bpb            - Pointer to the BPB struct instance.
+ * 
+ * Returns     : Number of consecutive sectors, limited to 0xFFFF.
+ * 
+ * Notes       : These are the remaining sectors of the current cluster plus
+ *               those of any following clusters in the same extent.
+ * ----------------------------------------------------------------------------
+ */
+static uint16_t pvt_GetConsecSecCnt(const FatFile *file, uint8_t secNumInClus,
+                                    const BPB *bpb)
+{
+  uint32_t clusCnt = 1;
+
+  if (file->extCnt)
+  {
+    const FatExtent *ext = pvt_FindExtent(file, file->clusNum);
+    if (file->clusNum < ext->fileClus + ext->clusCnt)
+      clusCnt = ext->fileClus + ext->clusCnt - file->clusNum;
+  }
+
+  uint32_t secCnt = clusCnt * bpb->secPerClus - secNumInClus;
+  return (secCnt > 0xFFFF) ? 0xFFFF : secCnt;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   (PRIVATE) MAP FILE EXTENTS
+ * 
+ * Description : Follows a file's cluster chain once and stores it in the ext
+ *               member of the FatFile instance as a list of extents, i.e. runs
+ *               of consecutive clusters.
+ * 
+ * Arguments   : file   - Pointer to a FatFile instance. The fstClusIndx and
+ *                        fileSize members must already be set.
+ *               bpb    - Pointer to the BPB struct instance.
+ * 
+ * Returns     : SUCCESS, FAILED_READ_SECTOR, or CORRUPT_FAT_ENTRY if the 
+ *               chain ends before the number of clusters required by the 
+ *               file size.
+ * 
+ * Notes       : 1) Each FAT sector is only requested once while the chain 
+ *                  stays in it. All links in the sector are followed from a
+ *                  pointer to the cached sector.
+ *               2) Only every stride'th run is stored. stride begins at 1. If
+ *                  the map is full when a run is to be stored, every other 
+ *                  extent is removed and stride is doubled, so the extents
+ *                  kept are spread evenly over the file as checkpoints.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_MapFileExtents(FatFile *file, const BPB *bpb)
+{
+  uint16_t fatIndxsPerSec = bpb->bytesPerSec / BYTES_PER_INDEX;
+  uint32_t bytesPerClus = (uint32_t)bpb->secPerClus * bpb->bytesPerSec;
+  uint32_t fileClusCnt = (file->fileSize + bytesPerClus - 1) / bytesPerClus;
+
+  uint32_t clusIndx = file->fstClusIndx;
+  uint32_t prevClusIndx = 0;
+  uint32_t fatSecNum = 0;                   // 0 is never a FAT sector
+  const uint8_t *fatSecArr = NULL;
+  uint32_t runNum = 0;                      // number of runs found so far
+  uint32_t stride = 1;                      // store every stride'th run
+  uint8_t  storing = 0;                     // 1 if current run is stored
+
+  file->extCnt = 0;
+  for (uint32_t clusNum = 0; clusNum < fileClusCnt; ++clusNum)
+  {
+    // follow the link from the previous cluster to this cluster.
+    if (clusNum)
+    {
+      uint32_t secNum = clusIndx / fatIndxsPerSec + bpb->rsvdSecCnt;
+      if (secNum != fatSecNum)
       {
-        // end of file flag. Set to 1 if eof is detected.
-        uint8_t eof = 0;
-
-        // 
-        // for output formatting. Currently using terminal that requires "\n\r"
-        // to go to the start of the next line. Therefore if '\n' is detected
-        // need to print "\n\r".
-        //
-        if (secArr[byteNum] == '\n') 
-          print_Str ("\n\r");
-        
-        // else if not 0, just print the character directly to the screen.
-        else if (secArr[byteNum])
-          usart_Transmit(secArr[byteNum]);
-       
-        // else character is zero. Possible indicatin of eof.
-        else 
-        {
-          // assume eof and set flag
-          eof = 1;
-          
-          // confirm rest of bytes in the current sector are 0
-          for (++byteNum; byteNum < bpb->bytesPerSec; ++byteNum)
-          {
-            // if any byte is not 0 then not at eof. Reset eof to 0
-            if (secArr[byteNum]) 
-            { 
-              --byteNum;
-              eof = 0;
-              break;
-            }
-          }
-        }
-        if (eof)
-          return END_OF_FILE;
+        if (fat_CacheGetSector(secNum, &fatSecArr) == FAILED_READ_SECTOR)
+          return FAILED_READ_SECTOR;
+        fatSecNum = secNum;
       }
+
+      const uint8_t *link = fatSecArr 
+                          + BYTES_PER_INDEX * (clusIndx % fatIndxsPerSec);
+      prevClusIndx = clusIndx;
+      clusIndx = link[3];
+      clusIndx <<= 8;
+      clusIndx |= link[2];
+      clusIndx <<= 8;
+      clusIndx |= link[1];
+      clusIndx <<= 8;
+      clusIndx |= link[0];
     }
-  } 
-  while ((clus = pvt_GetNextClusIndex(clus, bpb)) != END_CLUSTER);
-  
-  return END_OF_FILE;
+
+    if (clusIndx == END_CLUSTER || clusIndx < bpb->rootClus)
+      return CORRUPT_FAT_ENTRY;
+
+    // extend the current run if this cluster follows the previous one.
+    if (clusNum && clusIndx == prevClusIndx + 1)
+    {
+      if (storing)
+        ++file->ext[file->extCnt - 1].clusCnt;
+      continue;
+    }
+
+    // this cluster begins a new run. Remove every other extent if full. 
+    if (!(runNum % stride) && file->extCnt == FAT_FILE_EXTENTS)
+    {
+      for (uint8_t extNum = 1; extNum < FAT_FILE_EXTENTS / 2; ++extNum)
+        file->ext[extNum] = file->ext[2 * extNum];
+      file->extCnt = FAT_FILE_EXTENTS / 2;
+      stride *= 2;
+    }
+
+    storing = !(runNum % stride);
+    if (storing)
+    {
+      file->ext[file->extCnt].fileClus = clusNum;
+      file->ext[file->extCnt].clusIndx = clusIndx;
+      file->ext[file->extCnt].clusCnt = 1;
+      ++file->extCnt;
+    }
+    ++runNum;
+  }
+  return SUCCESS;
 }
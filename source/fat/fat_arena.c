@@ -0,0 +1,120 @@
+/*
+ * File       : FAT_ARENA.C
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of FAT_ARENA.H
+ */
+
+#include <stddef.h>
+#include <avr/io.h>
+#include "fat_bpb.h"
+#include "fat.h"
+#include "fat_arena.h"
+
+/*
+ ******************************************************************************
+ *                                "PRIVATE" DATA
+ ******************************************************************************
+ */
+
+// a slot holds any one of the objects borrowed by the FAT module.
+typedef union
+{
+  uint8_t   secArr[SECTOR_LEN];
+  FatCursor cur;
+  FatFile   file;
+  FatDir    dir;
+}
+ArenaSlot;
+
+static ArenaSlot slots[FAT_ARENA_SLOTS];
+
+// bit n is set while slots[n] is borrowed.
+static uint8_t inUse;
+static uint8_t peak;
+
+/*
+ ******************************************************************************
+ *                                  FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            BORROW ARENA SLOT
+ *                                       
+ * Description : Returns a free slot of the arena and marks it in use.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : Pointer to the slot, or a null pointer if none are free.
+ * ----------------------------------------------------------------------------
+ */
+void *fat_ArenaBorrow(void)
+{
+  uint8_t cnt = 0;
+  void   *slot = NULL;
+
+  for (uint8_t n = 0; n < FAT_ARENA_SLOTS; ++n)
+  {
+    if (inUse & 1 << n)
+      ++cnt;
+    else if (!slot)
+    {
+      inUse |= 1 << n;
+      slot = &slots[n];
+      ++cnt;
+    }
+  }
+
+  if (cnt > peak)
+    peak = cnt;
+  return slot;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            RETURN ARENA SLOT
+ *                                       
+ * Description : Marks a slot returned by fat_ArenaBorrow as free.
+ * 
+ * Arguments   : slot     - Pointer returned by fat_ArenaBorrow.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_ArenaReturn(void *slot)
+{
+  uint8_t n = (ArenaSlot *)slot - slots;
+  if (n < FAT_ARENA_SLOTS)
+    inUse &= ~(1 << n);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       ARENA SLOT SIZE / PEAK
+ *                                       
+ * Description : fat_ArenaSlotSize returns the size of each slot in bytes. 
+ *               fat_ArenaPeak returns the most slots that have been in use 
+ *               at once.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : size in bytes, or number of slots.
+ * ----------------------------------------------------------------------------
+ */
+uint16_t fat_ArenaSlotSize(void)
+{
+  return sizeof(ArenaSlot);
+}
+
+uint8_t fat_ArenaPeak(void)
+{
+  return peak;
+}
@@ -17,6 +17,16 @@
 #include "usart0.h"
 #include "fat_bpb.h"
 #include "fat_to_disk_if.h"
+#include "fat.h"
+#include "fat_arena.h"
+
+/*
+ ******************************************************************************
+ *                        "PRIVATE" FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+static uint8_t pvt_LoadBPB(BPB *bpb, uint8_t bootSecArr[]);
 
 /*
  ******************************************************************************
@@ -49,7 +59,78 @@
  */
 uint8_t fat_SetBPB(BPB *bpb)
 {
-  uint8_t bootSecArr[SECTOR_LEN], err; 
+  // the boot sector is read into a slot borrowed from the arena.
+  uint8_t *bootSecArr = fat_ArenaBorrow();
+  uint8_t  err = pvt_LoadBPB(bpb, bootSecArr);
+
+  fat_ArenaReturn(bootSecArr);
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                       PRINT BIOS PARAMETER BLOCK ERROR FLAGS 
+ * 
+ * Description : Print the Bios Parameter Block Error Flag. 
+ * 
+ * Arguments   : err     BPB error flag(s).
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_PrintErrorBPB(uint8_t err)
+{  
+  switch(err)
+  {
+    case BPB_VALID:
+      print_StrP(PSTR("BPB_VALID "));
+      break;
+    case CORRUPT_BPB:
+      print_StrP(PSTR("CORRUPT_BPB "));
+      break;
+    case NOT_BPB:
+      print_StrP(PSTR("NOT_BPB "));
+      break;
+    case INVALID_BYTES_PER_SECTOR:
+      print_StrP(PSTR("INVALID_BYTES_PER_SECTOR"));
+      break;
+    case INVALID_SECTORS_PER_CLUSTER:
+      print_StrP(PSTR("INVALID_SECTORS_PER_CLUSTER"));
+      break;
+    case BPB_NOT_FOUND:
+      print_StrP(PSTR("BPB_NOT_FOUND"));
+      break;
+    case FAILED_READ_BPB:
+      print_StrP(PSTR("FAILED_READ_BPB"));
+      break;
+    default:
+      print_StrP(PSTR("UNKNOWN_ERROR"));
+      break;
+  }
+}
+
+/*
+ ******************************************************************************
+ *                           "PRIVATE" FUNCTIONS    
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    (PRIVATE) LOAD BPB STRUCT
+ *                                         
+ * Description : Reads the boot sector into bootSecArr and sets the members of
+ *               a BPB struct instance from it. 
+ * 
+ * Arguments   : bpb          - Pointer to the BPB struct instance.
+ *               bootSecArr   - Sector array the boot sector is read into.
+ * 
+ * Returns     : Boot Sector Error Flag, as returned by fat_SetBPB.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_LoadBPB(BPB *bpb, uint8_t bootSecArr[])
+{
+  uint8_t err;
 
   // Locate boot sector address on the disk. 
   uint32_t bootSecAddr = FATtoDisk_FindBootSector();
@@ -111,6 +192,21 @@ uint8_t fat_SetBPB(BPB *bpb)
     bpb->rootClus <<= 8;
     bpb->rootClus |= bootSecArr[ROOT_CLUS_POS1];
 
+    // Volume serial number
+    bpb->volId =  bootSecArr[VOL_ID_POS4];
+    bpb->volId <<= 8;
+    bpb->volId |= bootSecArr[VOL_ID_POS3];
+    bpb->volId <<= 8;
+    bpb->volId |= bootSecArr[VOL_ID_POS2];
+    bpb->volId <<= 8;
+    bpb->volId |= bootSecArr[VOL_ID_POS1];
+
+    // FSInfo sector. Its BPB field is the sector number in the volume.
+    bpb->fsInfoSector = bootSecArr[FS_INFO_POS_MSB];
+    bpb->fsInfoSector <<= 8;
+    bpb->fsInfoSector |= bootSecArr[FS_INFO_POS_LSB];
+    bpb->fsInfoSector += bootSecAddr;
+
     //
     // The disk's sector address corresponding to the first sector of the FAT32
     // volume's Data Region. Since the first cluster of the Data Region is the 
@@ -123,45 +219,3 @@ uint8_t fat_SetBPB(BPB *bpb)
   else 
     return NOT_BPB;
 }
-
-/*
- * ----------------------------------------------------------------------------
- *                                       PRINT BIOS PARAMETER BLOCK ERROR FLAGS 
- * 
- * Description : Print the Bios Parameter Block Error Flag. 
- * 
- * Arguments   : err     BPB error flag(s).
- * 
- * Returns     : void
- * ----------------------------------------------------------------------------
- */
-void fat_PrintErrorBPB(uint8_t err)
-{  
-  switch(err)
-  {
-    case BPB_VALID:
-      print_Str("BPB_VALID ");
-      break;
-    case CORRUPT_BPB:
-      print_Str("CORRUPT_BPB ");
-      break;
-    case NOT_BPB:
-      print_Str("NOT_BPB ");
-      break;
-    case INVALID_BYTES_PER_SECTOR:
-      print_Str("INVALID_BYTES_PER_SECTOR");
-      break;
-    case INVALID_SECTORS_PER_CLUSTER:
-      print_Str("INVALID_SECTORS_PER_CLUSTER");
-      break;
-    case BPB_NOT_FOUND:
-      print_Str("BPB_NOT_FOUND");
-      break;
-    case FAILED_READ_BPB:
-      print_Str("FAILED_READ_BPB");
-      break;
-    default:
-      print_Str("UNKNOWN_ERROR");
-      break;
-  }
-}
@@ -0,0 +1,226 @@
+/*
+ * File       : FAT_CACHE.C
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of FAT_CACHE.H
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include "fat_bpb.h"
+#include "fat.h"
+#include "fat_to_disk_if.h"
+#include "fat_cache.h"
+
+/*
+ ******************************************************************************
+ *                      "PRIVATE" FUNCTION PROTOTYPES (and MACROS)
+ ******************************************************************************
+ */
+
+static void pvt_SetMostRecent(uint8_t orderPos);
+
+//
+// Cache slots. secNums[n] holds the disk address of the sector in secArrs[n],
+// or CACHE_EMPTY_SLOT. order[] holds the slot numbers from most recently used
+// (order[0]) to least recently used (order[FAT_CACHE_SECTORS - 1]).
+//
+static uint32_t secNums[FAT_CACHE_SECTORS];
+static uint8_t  secArrs[FAT_CACHE_SECTORS][SECTOR_LEN];
+static uint8_t  order[FAT_CACHE_SECTORS];
+static uint8_t  initialized = 0;
+
+// hit/miss counters returned by fat_CacheGetStats.
+static FatCacheStats stats;
+
+/*
+ ******************************************************************************
+ *                                 FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        GET SECTOR FROM CACHE
+ *
+ * Description : Sets secPtr to point to the cached copy of the sector at
+ *               secNum. If the sector is not in the cache it is read from the
+ *               disk into the least recently used cache slot.
+ *
+ * Arguments   : secNum   - Address of the sector on the disk.
+ *               secPtr   - Pointer to the pointer that will be set to the
+ *                          cached sector.
+ *
+ * Returns     : READ_SECTOR_SUCCESS or FAILED_READ_SECTOR.
+ *
+ * Notes       : The sector pointed to is only valid until the next call to a
+ *               cache function, after which it may have been replaced.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CacheGetSector(uint32_t secNum, const uint8_t **secPtr)
+{
+  if (!initialized)
+    fat_CacheInvalidate();
+
+  // search slots from most to least recently used.
+  for (uint8_t orderPos = 0; orderPos < FAT_CACHE_SECTORS; ++orderPos)
+    if (secNums[order[orderPos]] == secNum)
+    {
+      ++stats.hits;
+      pvt_SetMostRecent(orderPos);
+      *secPtr = secArrs[order[0]];
+      return READ_SECTOR_SUCCESS;
+    }
+
+  // miss. Replace the least recently used slot.
+  ++stats.misses;
+  pvt_SetMostRecent(FAT_CACHE_SECTORS - 1);
+  uint8_t slot = order[0];
+  if (FATtoDisk_ReadSingleSector(secNum, secArrs[slot]) == FAILED_READ_SECTOR)
+  {
+    secNums[slot] = CACHE_EMPTY_SLOT;
+    return FAILED_READ_SECTOR;
+  }
+  secNums[slot] = secNum;
+  *secPtr = secArrs[slot];
+  return READ_SECTOR_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        READ SECTOR VIA CACHE
+ *
+ * Description : Same as fat_CacheGetSector, but the sector is copied into
+ *               secArr. Can be used in place of FATtoDisk_ReadSingleSector.
+ *
+ * Arguments   : secNum   - Address of the sector on the disk.
+ *               secArr   - Pointer to a SECTOR_LEN array to be loaded.
+ *
+ * Returns     : READ_SECTOR_SUCCESS or FAILED_READ_SECTOR.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CacheReadSector(uint32_t secNum, uint8_t secArr[])
+{
+  const uint8_t *secPtr;
+
+  if (fat_CacheGetSector(secNum, &secPtr) == FAILED_READ_SECTOR)
+    return FAILED_READ_SECTOR;
+  memcpy(secArr, secPtr, SECTOR_LEN);
+  return READ_SECTOR_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       WRITE SECTOR VIA CACHE
+ *
+ * Description : Writes secArr to the sector at secNum on the disk, and 
+ *               updates the cached copy of the sector if there is one.
+ *
+ * Arguments   : secNum   - Address of the sector on the disk.
+ *               secArr   - Pointer to the SECTOR_LEN array to be written.
+ *
+ * Returns     : WRITE_SECTOR_SUCCESS or FAILED_WRITE_SECTOR.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_CacheWriteSector(uint32_t secNum, const uint8_t secArr[])
+{
+  if (!initialized)
+    fat_CacheInvalidate();
+
+  //
+  // the cached copy is dropped before writing, so that it cannot be used if
+  // the write fails part way, and replaced once the write has succeeded.
+  //
+  uint8_t slot;
+  for (slot = 0; slot < FAT_CACHE_SECTORS; ++slot)
+    if (secNums[slot] == secNum)
+    {
+      secNums[slot] = CACHE_EMPTY_SLOT;
+      break;
+    }
+
+  if (FATtoDisk_WriteSingleSector(secNum, secArr) == FAILED_WRITE_SECTOR)
+    return FAILED_WRITE_SECTOR;
+
+  if (slot < FAT_CACHE_SECTORS)
+  {
+    memcpy(secArrs[slot], secArr, SECTOR_LEN);
+    secNums[slot] = secNum;
+  }
+  return WRITE_SECTOR_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                             INVALIDATE CACHE
+ *
+ * Description : Empties all of the cache slots.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_CacheInvalidate(void)
+{
+  for (uint8_t slot = 0; slot < FAT_CACHE_SECTORS; ++slot)
+  {
+    secNums[slot] = CACHE_EMPTY_SLOT;
+    order[slot] = slot;
+  }
+  initialized = 1;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       GET / RESET STATISTICS
+ *
+ * Description : Copies the cache counters into st, or clears them.
+ *
+ * Arguments   : st   - Pointer to a FatCacheStats instance to be loaded.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_CacheGetStats(FatCacheStats *st)
+{
+  *st = stats;
+}
+
+void fat_CacheResetStats(void)
+{
+  stats.hits = 0;
+  stats.misses = 0;
+}
+
+/*
+ ******************************************************************************
+ *                            "PRIVATE" FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                        (PRIVATE) SET MOST RECENTLY USED SLOT
+ *
+ * Description : Moves the slot at position orderPos of the LRU order to the
+ *               front, shifting the more recently used slots back by one.
+ *
+ * Arguments   : orderPos   - position in order[] of the slot being used.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_SetMostRecent(uint8_t orderPos)
+{
+  uint8_t slot = order[orderPos];
+  for (; orderPos > 0; --orderPos)
+    order[orderPos] = order[orderPos - 1];
+  order[0] = slot;
+}
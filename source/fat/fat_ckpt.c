@@ -0,0 +1,298 @@
+/*
+ * File       : FAT_CKPT.C
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of FAT_CKPT.H
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include "fat_bpb.h"
+#include "fat.h"
+#include "fat_ckpt.h"
+
+/*
+ ******************************************************************************
+ *                                   MACROS
+ ******************************************************************************
+ */
+
+// nxtEntNum when the cursor's position is not known.
+#define CKPT_NO_ENTRY             0xFFFF
+
+/*
+ ******************************************************************************
+ *                      "PRIVATE" FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+static uint8_t pvt_NextEntry(const FatCkptTable *tbl, FatCursor *cur,
+                             FatEntryRef *ref, const BPB *bpb);
+static void pvt_AddCkpt(FatCkptTable *tbl, uint16_t entNum,
+                        const FatEntryRef *ref);
+static void pvt_AddRecent(FatCkptTable *tbl, uint16_t entNum,
+                          const FatEntryRef *ref);
+static void pvt_SetCkpt(FatCkpt *ckpt, const FatEntryRef *ref);
+
+/*
+ ******************************************************************************
+ *                                 FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  INITIALIZE CHECKPOINT TABLE
+ *
+ * Description : Sets a FatCkptTable instance to an empty table for a
+ *               directory.
+ *
+ * Arguments   : tbl        - Pointer to the FatCkptTable instance.
+ *               dir        - Pointer to the FatDir instance of the directory.
+ *               ckpts      - Array of ckptsMax FatCkpt elements.
+ *               ckptsMax   - Number of elements in ckpts. At least 1.
+ *               interval   - Entries between checkpoints, at least 1.
+ *               attrMask   - Attribute bits to test.
+ *               attrVal    - Value the tested bits must have.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_CkptInit(FatCkptTable *tbl, const FatDir *dir, FatCkpt ckpts[],
+                  uint8_t ckptsMax, uint16_t interval, uint8_t attrMask,
+                  uint8_t attrVal)
+{
+  tbl->dir = dir;
+  tbl->ckpts = ckpts;
+  tbl->ckptsMax = ckptsMax;
+  tbl->ckptCnt = 0;
+  tbl->interval = interval;
+  tbl->attrMask = attrMask;
+  tbl->attrVal = attrVal;
+  tbl->entCnt = 0;
+  tbl->complete = 0;
+  tbl->nxtEntNum = CKPT_NO_ENTRY;
+  tbl->recentCnt = 0;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            SEEK ENTRY NUMBER
+ *
+ * Description : Sets a FatEntryRef to the entry of the directory with a given
+ *               number, in the order the entries are in the directory.
+ *
+ * Arguments   : tbl      - Pointer to a FatCkptTable set by fat_CkptInit.
+ *               cur      - Pointer to a FatCursor instance.
+ *               entNum   - Number of the entry, from 0.
+ *               ref      - Pointer to the FatEntryRef instance to be set.
+ *               bpb      - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, END_OF_DIRECTORY or FAILED_READ_SECTOR.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_SeekEntry(FatCkptTable *tbl, FatCursor *cur, uint16_t entNum,
+                      FatEntryRef *ref, const BPB *bpb)
+{
+  uint8_t  err;
+  uint16_t pos;                        // number of the entry cur is at
+
+  if (tbl->complete && entNum >= tbl->entCnt)
+    return END_OF_DIRECTORY;
+
+  //
+  // continue from the cursor if it is at, or just before, the entry, or go
+  // to the entry if it is a recent one. Else go to the nearest checkpoint
+  // before the entry, or to the start of the directory if there are none.
+  //
+  if (tbl->nxtEntNum != CKPT_NO_ENTRY && tbl->nxtEntNum <= entNum
+      && entNum - tbl->nxtEntNum < tbl->interval)
+    pos = tbl->nxtEntNum;
+  else if (entNum >= tbl->recentFst 
+           && entNum - tbl->recentFst < tbl->recentCnt)
+  {
+    const FatCkpt *ckpt = &tbl->recent[entNum - tbl->recentFst];
+    fat_SeekCursorInClus(cur, ckpt->clusIndx, ckpt->entNum, bpb);
+    pos = entNum;
+  }
+  else if (tbl->ckptCnt)
+  {
+    uint16_t ckptNum = entNum / tbl->interval;
+    if (ckptNum >= tbl->ckptCnt)
+      ckptNum = tbl->ckptCnt - 1;
+
+    fat_SeekCursorInClus(cur, tbl->ckpts[ckptNum].clusIndx,
+                         tbl->ckpts[ckptNum].entNum, bpb);
+    pos = ckptNum * tbl->interval;
+  }
+  else
+  {
+    fat_InitCursor(cur, tbl->dir);
+    pos = 0;
+  }
+  tbl->nxtEntNum = CKPT_NO_ENTRY;
+
+  for (;; ++pos)
+  {
+    if ((err = pvt_NextEntry(tbl, cur, ref, bpb)) != SUCCESS)
+    {
+      if (err == END_OF_DIRECTORY)
+        tbl->complete = 1;
+      return err;
+    }
+
+    if (pos >= tbl->entCnt)
+    {
+      tbl->entCnt = pos + 1;
+      pvt_AddCkpt(tbl, pos, ref);
+    }
+    pvt_AddRecent(tbl, pos, ref);
+    if (pos == entNum)
+    {
+      tbl->nxtEntNum = pos + 1;
+      return SUCCESS;
+    }
+  }
+}
+
+/*
+ ******************************************************************************
+ *                           "PRIVATE" FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         (PRIVATE) NEXT ENTRY
+ *
+ * Description : Advances a cursor to the next entry of the table's directory
+ *               that is numbered, i.e. whose attributes match and that is not
+ *               the "." or ".." entry.
+ *
+ * Arguments   : tbl   - Pointer to the FatCkptTable instance.
+ *               cur   - Pointer to the FatCursor instance.
+ *               ref   - Pointer to the FatEntryRef instance to be set.
+ *               bpb   - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, END_OF_DIRECTORY or FAILED_READ_SECTOR.
+ *
+ * Notes       : "." and ".." are the first two entries of every directory
+ *               other than the root, so they are known by their entNum
+ *               without reading their names.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_NextEntry(const FatCkptTable *tbl, FatCursor *cur,
+                             FatEntryRef *ref, const BPB *bpb)
+{
+  uint8_t err;
+
+  while ((err = fat_CursorNextRef(cur, ref, tbl->attrMask, tbl->attrVal,
+                                  bpb)) == SUCCESS)
+  {
+    if (tbl->dir->fstClusIndx == bpb->rootClus || ref->entNum > 1)
+      break;
+  }
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                     (PRIVATE) ADD CHECKPOINT
+ *
+ * Description : Adds the position of an entry to the table if it is the
+ *               next checkpoint. If the table is full, every other
+ *               checkpoint is dropped and the interval doubled first.
+ *
+ * Arguments   : tbl      - Pointer to the FatCkptTable instance.
+ *               entNum   - Number of the entry. Must be tbl->entCnt - 1.
+ *               ref      - Pointer to the entry's FatEntryRef.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_AddCkpt(FatCkptTable *tbl, uint16_t entNum,
+                        const FatEntryRef *ref)
+{
+  if (entNum % tbl->interval)
+    return;
+
+  if (tbl->ckptCnt == tbl->ckptsMax)
+  {
+    // interval cannot be doubled. Entries past the last are found from it.
+    if (tbl->interval > UINT16_MAX / 2)
+      return;
+
+    for (uint8_t ckptNum = 0; 2 * ckptNum < tbl->ckptCnt; ++ckptNum)
+      tbl->ckpts[ckptNum] = tbl->ckpts[2 * ckptNum];
+    tbl->ckptCnt = (tbl->ckptCnt + 1) / 2;
+    tbl->interval *= 2;
+    if (entNum % tbl->interval)
+      return;
+  }
+
+  pvt_SetCkpt(&tbl->ckpts[tbl->ckptCnt++], ref);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   (PRIVATE) ADD RECENT ENTRY
+ *
+ * Description : Adds the position of an entry to the recent entries, if it
+ *               is not one of them. If it follows the last of them it is 
+ *               added after it, dropping the first if recent is full. Else 
+ *               the recent entries are replaced by it.
+ *
+ * Arguments   : tbl      - Pointer to the FatCkptTable instance.
+ *               entNum   - Number of the entry.
+ *               ref      - Pointer to the entry's FatEntryRef.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_AddRecent(FatCkptTable *tbl, uint16_t entNum,
+                          const FatEntryRef *ref)
+{
+  if (entNum >= tbl->recentFst && entNum - tbl->recentFst < tbl->recentCnt)
+    return;
+
+  if (tbl->recentCnt && entNum == tbl->recentFst + tbl->recentCnt)
+  {
+    if (tbl->recentCnt == FAT_CKPT_RECENT)
+    {
+      memmove(tbl->recent, tbl->recent + 1, 
+              (FAT_CKPT_RECENT - 1) * sizeof(FatCkpt));
+      ++tbl->recentFst;
+      --tbl->recentCnt;
+    }
+  }
+  else
+  {
+    tbl->recentFst = entNum;
+    tbl->recentCnt = 0;
+  }
+  pvt_SetCkpt(&tbl->recent[tbl->recentCnt++], ref);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                            (PRIVATE) SET CHECKPOINT TO ENTRY
+ *
+ * Description : Sets a FatCkpt to the position of an entry.
+ *
+ * Arguments   : ckpt   - Pointer to the FatCkpt instance.
+ *               ref    - Pointer to the entry's FatEntryRef.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_SetCkpt(FatCkpt *ckpt, const FatEntryRef *ref)
+{
+  ckpt->clusIndx = ref->lnEntCnt ? ref->lnClusIndx : ref->snClusIndx;
+  ckpt->entNum = ref->entNum;
+}
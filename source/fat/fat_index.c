@@ -0,0 +1,189 @@
+/*
+ * File       : FAT_INDEX.C
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of FAT_INDEX.H
+ */
+
+#include <stddef.h>
+#include <avr/io.h>
+#include "fat_bpb.h"
+#include "fat.h"
+#include "fat_arena.h"
+#include "fat_index.h"
+
+/*
+ ******************************************************************************
+ *                                "PRIVATE" DATA
+ ******************************************************************************
+ */
+
+// the index used by fat_IndexLookup. Null if none.
+static FatNameIndex *currIndex = NULL;
+
+/*
+ ******************************************************************************
+ *                                 FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        INITIALIZE NAME INDEX
+ *
+ * Description : Sets a FatNameIndex instance to an empty index using an 
+ *               array supplied by the caller, and makes it the index used by
+ *               fat_FindEntry.
+ *
+ * Arguments   : idx       - Pointer to the FatNameIndex instance.
+ *               ents      - Array of entsMax FatIndexEnt elements.
+ *               entsMax   - Number of elements in ents.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_IndexInit(FatNameIndex *idx, FatIndexEnt ents[], uint16_t entsMax)
+{
+  currIndex = idx;
+  if (!idx)
+    return;
+
+  idx->ents = ents;
+  idx->entsMax = entsMax;
+  idx->entCnt = 0;
+  idx->state = INDEX_EMPTY;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                             BUILD NAME INDEX
+ *
+ * Description : Scans a directory and sets the index in use to its entries.
+ *
+ * Arguments   : dir    - Pointer to the FatDir instance to index.
+ *               bpb    - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, or the error that stopped the scan, in which case 
+ *               the index is left empty.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_IndexBuild(const FatDir *dir, const BPB *bpb)
+{
+  uint8_t     err;
+  FatEntryRef ref;
+  char        nameStr[LN_STR_LEN_MAX];
+
+  if (!currIndex)
+    return SUCCESS;
+
+  currIndex->entCnt = 0;
+  currIndex->state = INDEX_COMPLETE;
+
+  // 
+  // add each entry, except the volume ID, to the index until it is full. The
+  // cursor is borrowed from the arena. The names are decoded from the 
+  // cursor's sectors, which are still cached.
+  //
+  FatCursor *cur = fat_ArenaBorrow();
+  fat_InitCursor(cur, dir);
+  while ((err = fat_CursorNextRef(cur, &ref, VOLUME_ID_ATTR, 0, bpb)) 
+         == SUCCESS)
+  {
+    if (currIndex->entCnt == currIndex->entsMax)
+    {
+      currIndex->state = INDEX_PARTIAL;
+      break;
+    }
+    if ((err = fat_GetEntryName(&ref, nameStr, bpb)) != SUCCESS)
+      break;
+
+    FatIndexEnt *ent = &currIndex->ents[currIndex->entCnt++];
+    ent->nameHash = fat_HashName(nameStr);
+    ent->entNum = ref.entNum;
+  }
+  fat_ArenaReturn(cur);
+
+  if (err != SUCCESS && err != END_OF_DIRECTORY)
+  {
+    currIndex->state = INDEX_EMPTY;
+    return err;
+  }
+  currIndex->dirClusIndx = dir->fstClusIndx;
+  currIndex->volId = bpb->volId;
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         LOOK UP INDEXED NAME
+ *
+ * Description : Finds an entry of a directory by name using the index in 
+ *               use, if the index is of dir.
+ *
+ * Arguments   : dir        - Pointer to the FatDir instance to search.
+ *               nameStr    - The name of the entry.
+ *               attrMask   - Attribute bits to test, as for fat_FindEntry.
+ *               attrVal    - Value the tested bits must have.
+ *               ref        - Set to the entry if it is found.
+ *               err        - Set to SUCCESS if found, END_OF_DIRECTORY if 
+ *                            not, or to a read error.
+ *               bpb        - Pointer to the BPB struct instance.
+ *
+ * Returns     : 1 if err was set, or 0 if the directory must be searched.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_IndexLookup(const FatDir *dir, const char nameStr[], 
+                        uint8_t attrMask, uint8_t attrVal, FatEntryRef *ref,
+                        uint8_t *err, const BPB *bpb)
+{
+  //
+  // the index is of the last directory indexed on the volume it was on. It
+  // is not rebuilt for another directory, which is searched instead, so
+  // that lookups in several directories do not each scan a whole one.
+  //
+  if (!currIndex 
+      || currIndex->state == INDEX_EMPTY 
+      || currIndex->dirClusIndx != dir->fstClusIndx
+      || currIndex->volId != bpb->volId)
+    return 0;
+
+  //
+  // read each entry whose name has the same hash, and compare its name and
+  // attributes. The cursor is borrowed from the arena.
+  //
+  uint16_t   nameHash = fat_HashName(nameStr);
+  FatCursor *cur = fat_ArenaBorrow();
+
+  *err = END_OF_DIRECTORY;
+  for (uint16_t n = 0; n < currIndex->entCnt; ++n)
+  {
+    if (currIndex->ents[n].nameHash != nameHash)
+      continue;
+
+    if ((*err = fat_SeekCursor(cur, dir, currIndex->ents[n].entNum, bpb)) 
+        == SUCCESS
+        && (*err = fat_CursorNextRef(cur, ref, 0, 0, bpb)) == SUCCESS)
+    {
+      // an entry whose attributes do not match is never the one found.
+      if ((ref->attr & attrMask) != attrVal)
+        *err = FILE_NOT_FOUND;
+      else
+        *err = fat_MatchEntryName(ref, nameStr, bpb);
+    }
+
+    // stop at the entry found, or at an error reading the directory.
+    if (*err != FILE_NOT_FOUND && *err != END_OF_DIRECTORY)
+      break;
+    *err = END_OF_DIRECTORY;
+  }
+  fat_ArenaReturn(cur);
+
+  // a partial index cannot tell that the name does not exist.
+  return *err != END_OF_DIRECTORY || currIndex->state == INDEX_COMPLETE;
+}
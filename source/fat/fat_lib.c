@@ -0,0 +1,782 @@
+/*
+ * File       : FAT_LIB.C
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of FAT_LIB.H
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include "prints.h"
+#include "fat_bpb.h"
+#include "fat.h"
+#include "fat_to_disk_if.h"
+#include "fat_cache.h"
+#include "fat_arena.h"
+#include "fat_sort.h"
+#include "fat_lib.h"
+
+#if FAT_SORT_KEY_LEN < LIB_NAME_LEN
+#error "FAT_SORT_KEY_LEN must be at least LIB_NAME_LEN"
+#endif
+
+/*
+ ******************************************************************************
+ *                      "PRIVATE" FUNCTION PROTOTYPES (and MACROS)
+ ******************************************************************************
+ */
+
+// directory levels of the library.
+#define LIB_ARTIST     0
+#define LIB_ALBUM      1
+#define LIB_TRACK      2
+
+// attributes of the entries added at each level.
+#define LIB_ATTR_MASK  (DIR_ENTRY_ATTR | HIDDEN_ATTR | VOLUME_ID_ATTR)
+#define LIB_ATTR_VAL(level)  ((level) == LIB_TRACK ? 0 : DIR_ENTRY_ATTR)
+
+//
+// State of fat_LibBuild. secRecs holds the sector of records being written,
+// which is the sector of record recNum. childNum is the record number of the
+// next album or track that will be given to an artist or album. dir is the
+// directory being sorted with keys.
+//
+typedef struct
+{
+  FatLib     *lib;
+  FatLibRec  *secRecs;
+  FatSortKey *keys;
+  uint8_t     keysMax;
+  uint16_t    recNum;
+  uint16_t    childNum;
+  FatDir     *dir;
+  const BPB  *bpb;
+}
+LibBuildState;
+
+static uint8_t pvt_BuildLevels(LibBuildState *st);
+static uint8_t pvt_AddDirRecs(LibBuildState *st, uint32_t dirClus,
+                              uint8_t level);
+static uint8_t pvt_CountEntries(LibBuildState *st, uint32_t dirClus,
+                                uint8_t level, uint16_t *cnt);
+static uint8_t pvt_IsLibEntry(const char nameStr[], uint8_t attr);
+static uint8_t pvt_PutRec(LibBuildState *st, const FatLibRec *rec);
+static uint8_t pvt_WriteRecSec(LibBuildState *st);
+static uint8_t pvt_GetBuildRec(const LibBuildState *st, uint16_t recNum,
+                               FatLibRec *rec);
+static uint8_t pvt_ReadRec(const FatLib *lib, uint16_t recNum,
+                           FatLibRec *rec);
+static uint8_t pvt_GetFingerprint(FatLibFp *fp, uint32_t libClus,
+                                  const BPB *bpb);
+static uint8_t pvt_GetDirHash(uint32_t *hash, const BPB *bpb);
+static uint8_t pvt_HashEntry(uint32_t *hash, const FatEntryRef *ref,
+                             char nameStr[], const BPB *bpb);
+static uint32_t pvt_HashBytes(uint32_t hash, const void *byteArr,
+                              size_t len);
+static uint32_t pvt_GetU32(const uint8_t byteArr[]);
+
+/*
+ ******************************************************************************
+ *                                 FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            OPEN LIBRARY FILE
+ *
+ * Description : Finds the library file in the root directory and sets a
+ *               FatLib instance to it, and checks that the library was built
+ *               for the volume as it is now.
+ *
+ * Arguments   : lib    - Pointer to the FatLib instance to be set.
+ *               bpb    - Pointer to the BPB struct instance.
+ *
+ * Returns     : LIB_SUCCESS if the library can be used, LIB_STALE if it must
+ *               be built first by fat_LibBuild, or LIB_NOT_FOUND,
+ *               LIB_FRAGMENTED, LIB_TOO_SMALL or LIB_READ_FAILED if the file
+ *               cannot be used.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_LibOpen(FatLib *lib, const BPB *bpb)
+{
+  uint8_t     err;
+  FatEntryRef ref;
+
+  lib->artistCnt = 0;
+  lib->albumCnt = 0;
+  lib->trackCnt = 0;
+
+  // find the file's entry. The root FatDir is borrowed from the arena.
+  FatDir *root = fat_ArenaBorrow();
+  fat_SetDirToRoot(root, bpb);
+  err = fat_FindEntry(root, FAT_LIB_FILE_NAME,
+                      DIR_ENTRY_ATTR | VOLUME_ID_ATTR, 0, &ref, bpb);
+  fat_ArenaReturn(root);
+  if (err == END_OF_DIRECTORY)
+    return LIB_NOT_FOUND;
+  if (err != SUCCESS)
+    return LIB_READ_FAILED;
+
+  //
+  // The records are read and written by their sector numbers on the disk,
+  // so the file's clusters must be consecutive, i.e. its extent map must
+  // have a single extent. The FatFile is borrowed from the arena.
+  //
+  FatFile *file = fat_ArenaBorrow();
+  err = fat_OpenAtClus(file, ref.fstClusIndx, ref.fileSize, bpb);
+  uint8_t extCnt = file->extCnt;
+  fat_ArenaReturn(file);
+  if (err != SUCCESS)
+    return LIB_READ_FAILED;
+  if (extCnt > 1)
+    return LIB_FRAGMENTED;
+
+  uint32_t secCnt = ref.fileSize / SECTOR_LEN;
+  if (secCnt < 2)
+    return LIB_TOO_SMALL;
+  uint32_t recsMax = (secCnt - 1) * LIB_RECS_PER_SEC;
+
+  lib->fstSec = bpb->dataRegionFirstSector
+              + (ref.fstClusIndx - bpb->rootClus) * bpb->secPerClus;
+  lib->recsMax = (recsMax > 0xFFFF) ? 0xFFFF : recsMax;
+  if (pvt_GetFingerprint(&lib->fp, ref.fstClusIndx, bpb) != SUCCESS)
+    return LIB_READ_FAILED;
+
+  // the library can be used if its header holds the current fingerprint.
+  const uint8_t *secArr;
+  FatLibHdr      hdr;
+
+  if (fat_CacheGetSector(lib->fstSec, &secArr) == FAILED_READ_SECTOR)
+    return LIB_READ_FAILED;
+  memcpy(&hdr, secArr, sizeof(hdr));
+
+  if (memcmp(hdr.magic, LIB_MAGIC, LIB_MAGIC_LEN)
+      || memcmp(&hdr.fp, &lib->fp, sizeof(FatLibFp))
+      || (uint32_t)hdr.artistCnt + hdr.albumCnt + hdr.trackCnt > lib->recsMax)
+    return LIB_STALE;
+
+  lib->artistCnt = hdr.artistCnt;
+  lib->albumCnt = hdr.albumCnt;
+  lib->trackCnt = hdr.trackCnt;
+  return LIB_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                BUILD LIBRARY
+ *
+ * Description : Walks the artist and album directories of the volume and
+ *               writes the library's records to the library file.
+ *
+ * Arguments   : lib       - Pointer to a FatLib instance set by fat_LibOpen.
+ *               secRecs   - Array of LIB_RECS_PER_SEC records holding the
+ *                           sector being written.
+ *               keys      - Array of keysMax keys used to sort each
+ *                           directory.
+ *               keysMax   - Number of elements in keys. At least 1.
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : LIB_SUCCESS, LIB_TOO_SMALL if the file cannot hold the
+ *               records, or LIB_READ_FAILED or LIB_WRITE_FAILED. If it
+ *               fails, the library is left stale.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_LibBuild(FatLib *lib, FatLibRec secRecs[], FatSortKey keys[],
+                     uint8_t keysMax, const BPB *bpb)
+{
+  uint8_t err;
+
+  if (!keysMax)
+    return LIB_TOO_SMALL;
+
+  lib->artistCnt = 0;
+  lib->albumCnt = 0;
+  lib->trackCnt = 0;
+
+  //
+  // clear the header first, so that the library is stale until every record
+  // has been written, even if building is interrupted.
+  //
+  memset(secRecs, 0, SECTOR_LEN);
+  if (fat_CacheWriteSector(lib->fstSec, (uint8_t *)secRecs)
+      == FAILED_WRITE_SECTOR)
+    return LIB_WRITE_FAILED;
+
+  //
+  // write the records. The FatDir being sorted is borrowed from the arena
+  // for the whole build. The sort, and the count of each directory's
+  // children, each borrow a cursor while they scan.
+  //
+  LibBuildState st;
+  st.lib = lib;
+  st.secRecs = secRecs;
+  st.keys = keys;
+  st.keysMax = keysMax;
+  st.recNum = 0;
+  st.bpb = bpb;
+  st.dir = fat_ArenaBorrow();
+
+  err = pvt_BuildLevels(&st);
+
+  fat_ArenaReturn(st.dir);
+  if (err != LIB_SUCCESS)
+    return err;
+
+  // write the header.
+  FatLibHdr *hdr = (FatLibHdr *)secRecs;
+
+  memset(secRecs, 0, SECTOR_LEN);
+  memcpy(hdr->magic, LIB_MAGIC, LIB_MAGIC_LEN);
+  hdr->fp = lib->fp;
+  hdr->artistCnt = lib->artistCnt;
+  hdr->albumCnt = lib->albumCnt;
+  hdr->trackCnt = lib->trackCnt;
+  if (fat_CacheWriteSector(lib->fstSec, (uint8_t *)secRecs)
+      == FAILED_WRITE_SECTOR)
+  {
+    lib->artistCnt = 0;
+    return LIB_WRITE_FAILED;
+  }
+  return LIB_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           GET LIBRARY RECORD
+ *
+ * Description : Loads a record of the library.
+ *
+ * Arguments   : lib      - Pointer to a FatLib instance for which fat_LibOpen
+ *                          or fat_LibBuild returned LIB_SUCCESS.
+ *               recNum   - Record number.
+ *               rec      - Pointer to the FatLibRec instance to be loaded.
+ *
+ * Returns     : LIB_SUCCESS, LIB_NO_RECORD or LIB_READ_FAILED.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_LibGetRec(const FatLib *lib, uint16_t recNum, FatLibRec *rec)
+{
+  if ((uint32_t)recNum >= (uint32_t)lib->artistCnt + lib->albumCnt
+                          + lib->trackCnt)
+    return LIB_NO_RECORD;
+  return pvt_ReadRec(lib, recNum, rec);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         PRINT LIB ERROR FLAG
+ *
+ * Description : Prints the name of a LIB error flag.
+ *
+ * Arguments   : err   - LIB error flag.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_LibPrintError(uint8_t err)
+{
+  switch(err)
+  {
+    case LIB_SUCCESS:
+      print_StrP(PSTR("LIB_SUCCESS"));
+      break;
+    case LIB_NOT_FOUND:
+      print_StrP(PSTR("LIB_NOT_FOUND"));
+      break;
+    case LIB_FRAGMENTED:
+      print_StrP(PSTR("LIB_FRAGMENTED"));
+      break;
+    case LIB_STALE:
+      print_StrP(PSTR("LIB_STALE"));
+      break;
+    case LIB_TOO_SMALL:
+      print_StrP(PSTR("LIB_TOO_SMALL"));
+      break;
+    case LIB_READ_FAILED:
+      print_StrP(PSTR("LIB_READ_FAILED"));
+      break;
+    case LIB_WRITE_FAILED:
+      print_StrP(PSTR("LIB_WRITE_FAILED"));
+      break;
+    case LIB_NO_RECORD:
+      print_StrP(PSTR("LIB_NO_RECORD"));
+      break;
+    default:
+      print_StrP(PSTR("UNKNOWN_ERROR"));
+      break;
+  }
+}
+
+/*
+ ******************************************************************************
+ *                            "PRIVATE" FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                               (PRIVATE) BUILD LIBRARY LEVELS
+ *
+ * Description : Writes the records of the artists, then of the albums of
+ *               each artist, then of the tracks of each album, and sets the
+ *               counts of the FatLib instance.
+ *
+ * Arguments   : st    - Pointer to the state of fat_LibBuild.
+ *
+ * Returns     : LIB_SUCCESS or a LIB error flag.
+ *
+ * Notes       : The number of children of each artist and album is counted
+ *               when its record is written, so the record numbers of the
+ *               next level are known before it is written.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_BuildLevels(LibBuildState *st)
+{
+  uint8_t   err;
+  uint16_t  artistCnt;
+  FatLibRec rec;
+
+  if ((err = pvt_CountEntries(st, st->bpb->rootClus, LIB_ARTIST, &artistCnt))
+      != LIB_SUCCESS)
+    return err;
+  if (artistCnt > st->lib->recsMax)
+    return LIB_TOO_SMALL;
+
+  st->childNum = artistCnt;
+  if ((err = pvt_AddDirRecs(st, st->bpb->rootClus, LIB_ARTIST))
+      != LIB_SUCCESS)
+    return err;
+
+  // the parents of the albums are the artists, and of the tracks the albums.
+  uint16_t parentNum = 0;
+  uint16_t parentEnd = artistCnt;
+  for (uint8_t level = LIB_ALBUM; level <= LIB_TRACK; ++level)
+  {
+    for (; parentNum < parentEnd; ++parentNum)
+    {
+      if ((err = pvt_GetBuildRec(st, parentNum, &rec)) != LIB_SUCCESS
+          || (err = pvt_AddDirRecs(st, rec.fstClus, level)) != LIB_SUCCESS)
+        return err;
+    }
+    parentEnd = st->recNum;
+    if (level == LIB_ALBUM)
+      st->lib->albumCnt = st->recNum - artistCnt;
+  }
+
+  // write the last sector if it is not full.
+  if (st->recNum % LIB_RECS_PER_SEC
+      && (err = pvt_WriteRecSec(st)) != LIB_SUCCESS)
+    return err;
+
+  st->lib->artistCnt = artistCnt;
+  st->lib->trackCnt = st->recNum - artistCnt - st->lib->albumCnt;
+  return LIB_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                            (PRIVATE) ADD DIRECTORY'S RECORDS
+ *
+ * Description : Writes the records of the entries of a directory that belong
+ *               to the level, in the name order of fat_SortNext.
+ *
+ * Arguments   : st        - Pointer to the state of fat_LibBuild.
+ *               dirClus   - first cluster of the directory.
+ *               level     - LIB_ARTIST, LIB_ALBUM or LIB_TRACK.
+ *
+ * Returns     : LIB_SUCCESS or a LIB error flag.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_AddDirRecs(LibBuildState *st, uint32_t dirClus,
+                              uint8_t level)
+{
+  uint8_t     err;
+  FatSort     srt;
+  FatEntryRef ref;
+  FatLibRec   rec;
+
+  st->dir->fstClusIndx = dirClus;
+  fat_SortInit(&srt, st->dir, st->keys, st->keysMax, LIB_ATTR_MASK,
+               LIB_ATTR_VAL(level));
+  fat_SortSetFilter(&srt, pvt_IsLibEntry);
+  while ((err = fat_SortNext(&srt, &ref, st->bpb)) == SUCCESS)
+  {
+    // the key of the entry returned holds the first chars of its name.
+    memcpy(rec.name, srt.last.key, LIB_NAME_LEN);
+    rec.fstClus = ref.fstClusIndx;
+    rec.fileSize = ref.fileSize;
+    rec.fstChild = 0;
+    rec.childCnt = 0;
+    if (level != LIB_TRACK)
+    {
+      if ((err = pvt_CountEntries(st, rec.fstClus, level + 1,
+                                  &rec.childCnt)) != LIB_SUCCESS)
+        return err;
+      if ((uint32_t)st->childNum + rec.childCnt > st->lib->recsMax)
+        return LIB_TOO_SMALL;
+      rec.fstChild = st->childNum;
+      st->childNum += rec.childCnt;
+    }
+    if ((err = pvt_PutRec(st, &rec)) != LIB_SUCCESS)
+      return err;
+  }
+  return (err == END_OF_DIRECTORY) ? LIB_SUCCESS : LIB_READ_FAILED;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  (PRIVATE) COUNT LIB ENTRIES
+ *
+ * Description : Counts the entries of a directory that belong to the level.
+ *
+ * Arguments   : st        - Pointer to the state of fat_LibBuild.
+ *               dirClus   - first cluster of the directory.
+ *               level     - LIB_ARTIST, LIB_ALBUM or LIB_TRACK.
+ *               cnt       - Set to the number of entries.
+ *
+ * Returns     : LIB_SUCCESS or LIB_READ_FAILED.
+ *
+ * Notes       : st->dir is set to the directory while it is scanned, and
+ *               then back to the directory being sorted.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_CountEntries(LibBuildState *st, uint32_t dirClus,
+                                uint8_t level, uint16_t *cnt)
+{
+  uint8_t     err;
+  FatEntryRef ref;
+  char        nameStr[LN_STR_LEN_MAX];
+  uint32_t    sortClus = st->dir->fstClusIndx;
+
+  *cnt = 0;
+  st->dir->fstClusIndx = dirClus;
+  FatCursor *cur = fat_ArenaBorrow();
+  fat_InitCursor(cur, st->dir);
+  while ((err = fat_CursorNextRef(cur, &ref, LIB_ATTR_MASK,
+                                  LIB_ATTR_VAL(level), st->bpb)) == SUCCESS)
+  {
+    if ((err = fat_GetEntryName(&ref, nameStr, st->bpb)) != SUCCESS)
+      break;
+    if (pvt_IsLibEntry(nameStr, ref.attr))
+      ++*cnt;
+  }
+  fat_ArenaReturn(cur);
+  st->dir->fstClusIndx = sortClus;
+  return (err == END_OF_DIRECTORY) ? LIB_SUCCESS : LIB_READ_FAILED;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                (PRIVATE) IS ENTRY IN LIBRARY
+ *
+ * Description : Tests whether an entry, whose attributes are those of a
+ *               level, is added to the library by its name. Also the filter
+ *               of the FatSort that orders each directory.
+ *
+ * Arguments   : nameStr   - the entry's name.
+ *               attr      - the entry's attribute byte.
+ *
+ * Returns     : 1 if the entry is added, else 0.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_IsLibEntry(const char nameStr[], uint8_t attr)
+{
+  const uint8_t extLen = sizeof(FAT_LIB_TRACK_EXT) - 1;
+
+  // ".", ".." and dot files, e.g. those written by MacOS.
+  if (nameStr[0] == '.')
+    return 0;
+
+  // artists and albums are directories, and tracks are files.
+  if (attr & DIR_ENTRY_ATTR)
+    return 1;
+
+  size_t len = strlen(nameStr);
+  return len > extLen
+         && !strcasecmp_P(nameStr + len - extLen, PSTR(FAT_LIB_TRACK_EXT));
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         (PRIVATE) PUT RECORD
+ *
+ * Description : Adds a record after those already written, and writes its
+ *               sector once the sector is full.
+ *
+ * Arguments   : st    - Pointer to the state of fat_LibBuild.
+ *               rec   - Pointer to the record.
+ *
+ * Returns     : LIB_SUCCESS, LIB_TOO_SMALL or LIB_WRITE_FAILED.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_PutRec(LibBuildState *st, const FatLibRec *rec)
+{
+  if (st->recNum >= st->lib->recsMax)
+    return LIB_TOO_SMALL;
+
+  uint8_t pos = st->recNum % LIB_RECS_PER_SEC;
+  if (pos == 0)
+    memset(st->secRecs, 0, SECTOR_LEN);
+  st->secRecs[pos] = *rec;
+  ++st->recNum;
+
+  if (pos == LIB_RECS_PER_SEC - 1)
+    return pvt_WriteRecSec(st);
+  return LIB_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                (PRIVATE) WRITE RECORD SECTOR
+ *
+ * Description : Writes st->secRecs to the sector of the last record put.
+ *
+ * Arguments   : st    - Pointer to the state of fat_LibBuild.
+ *
+ * Returns     : LIB_SUCCESS or LIB_WRITE_FAILED.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_WriteRecSec(LibBuildState *st)
+{
+  uint32_t secNum = st->lib->fstSec + 1
+                  + (st->recNum - 1) / LIB_RECS_PER_SEC;
+
+  if (fat_CacheWriteSector(secNum, (const uint8_t *)st->secRecs)
+      == FAILED_WRITE_SECTOR)
+    return LIB_WRITE_FAILED;
+  return LIB_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   (PRIVATE) GET BUILT RECORD
+ *
+ * Description : Loads a record that has already been put, from st->secRecs
+ *               if its sector has not been written yet, or from the disk.
+ *
+ * Arguments   : st       - Pointer to the state of fat_LibBuild.
+ *               recNum   - Record number. Must be less than st->recNum.
+ *               rec      - Pointer to the FatLibRec instance to be loaded.
+ *
+ * Returns     : LIB_SUCCESS or LIB_READ_FAILED.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_GetBuildRec(const LibBuildState *st, uint16_t recNum,
+                               FatLibRec *rec)
+{
+  if (st->recNum % LIB_RECS_PER_SEC
+      && recNum / LIB_RECS_PER_SEC == st->recNum / LIB_RECS_PER_SEC)
+  {
+    *rec = st->secRecs[recNum % LIB_RECS_PER_SEC];
+    return LIB_SUCCESS;
+  }
+  return pvt_ReadRec(st->lib, recNum, rec);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        (PRIVATE) READ RECORD
+ *
+ * Description : Loads a record from its sector of the library file.
+ *
+ * Arguments   : lib      - Pointer to the FatLib instance.
+ *               recNum   - Record number.
+ *               rec      - Pointer to the FatLibRec instance to be loaded.
+ *
+ * Returns     : LIB_SUCCESS or LIB_READ_FAILED.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_ReadRec(const FatLib *lib, uint16_t recNum,
+                           FatLibRec *rec)
+{
+  const uint8_t *secArr;
+
+  if (fat_CacheGetSector(lib->fstSec + 1 + recNum / LIB_RECS_PER_SEC,
+                         &secArr) == FAILED_READ_SECTOR)
+    return LIB_READ_FAILED;
+  memcpy(rec, secArr + (recNum % LIB_RECS_PER_SEC) * LIB_REC_LEN,
+         LIB_REC_LEN);
+  return LIB_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                             (PRIVATE) GET VOLUME FINGERPRINT
+ *
+ * Description : Sets a fingerprint to the current state of the volume.
+ *
+ * Arguments   : fp        - Pointer to the FatLibFp instance to be set.
+ *               libClus   - first cluster of the library file.
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS or FAILED_READ_SECTOR.
+ *
+ * Notes       : If the FSInfo sector is not valid, its values are set to
+ *               0xFFFFFFFF, i.e. unknown, so only the volume ID, file and
+ *               directory hash are checked.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_GetFingerprint(FatLibFp *fp, uint32_t libClus,
+                                  const BPB *bpb)
+{
+  const uint8_t *secArr;
+
+  fp->volId = bpb->volId;
+  fp->libClus = libClus;
+  fp->freeClusCnt = 0xFFFFFFFF;
+  fp->nxtFreeClus = 0xFFFFFFFF;
+
+  if (fat_CacheGetSector(bpb->fsInfoSector, &secArr) == FAILED_READ_SECTOR)
+    return FAILED_READ_SECTOR;
+  if (pvt_GetU32(secArr + FSI_LEAD_SIG_POS) == FSI_LEAD_SIG
+      && pvt_GetU32(secArr + FSI_STRUC_SIG_POS) == FSI_STRUC_SIG)
+  {
+    fp->freeClusCnt = pvt_GetU32(secArr + FSI_FREE_COUNT_POS);
+    fp->nxtFreeClus = pvt_GetU32(secArr + FSI_NXT_FREE_POS);
+  }
+  return pvt_GetDirHash(&fp->dirHash, bpb);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                 (PRIVATE) GET DIRECTORY HASH
+ *
+ * Description : Hashes the entries of the root directory and of each artist
+ *               directory, i.e. the entries the artist and album records are
+ *               made from.
+ *
+ * Arguments   : hash   - Set to the hash.
+ *               bpb    - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS or FAILED_READ_SECTOR.
+ *
+ * Notes       : One cursor walks both levels. After an artist directory is
+ *               hashed, the cursor is returned to the artist's entry in the
+ *               root directory by fat_SeekCursorInClus, so only the FatDir
+ *               and FatCursor are borrowed from the arena.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_GetDirHash(uint32_t *hash, const BPB *bpb)
+{
+  uint8_t     err;
+  FatEntryRef ref;
+  FatEntryRef artistRef;
+  char        nameStr[LN_STR_LEN_MAX];
+
+  *hash = 5381;
+  FatDir    *dir = fat_ArenaBorrow();
+  FatCursor *cur = fat_ArenaBorrow();
+  fat_SetDirToRoot(dir, bpb);
+  fat_InitCursor(cur, dir);
+  while ((err = fat_CursorNextRef(cur, &artistRef, VOLUME_ID_ATTR, 0, bpb))
+         == SUCCESS)
+  {
+    if ((err = pvt_HashEntry(hash, &artistRef, nameStr, bpb)) != SUCCESS)
+      break;
+    if ((artistRef.attr & LIB_ATTR_MASK) != LIB_ATTR_VAL(LIB_ARTIST)
+        || !pvt_IsLibEntry(nameStr, artistRef.attr))
+      continue;
+
+    dir->fstClusIndx = artistRef.fstClusIndx;
+    fat_InitCursor(cur, dir);
+    while ((err = fat_CursorNextRef(cur, &ref, VOLUME_ID_ATTR, 0, bpb))
+           == SUCCESS
+           && (err = pvt_HashEntry(hash, &ref, nameStr, bpb)) == SUCCESS)
+      ;
+    if (err != END_OF_DIRECTORY)
+      break;
+
+    // step past the artist's entry again.
+    fat_SeekCursorInClus(cur, artistRef.lnEntCnt ? artistRef.lnClusIndx
+                                                 : artistRef.snClusIndx,
+                         artistRef.entNum, bpb);
+    if ((err = fat_CursorNextRef(cur, &ref, VOLUME_ID_ATTR, 0, bpb))
+        != SUCCESS)
+      break;
+  }
+  fat_ArenaReturn(cur);
+  fat_ArenaReturn(dir);
+  return (err == END_OF_DIRECTORY) ? SUCCESS : FAILED_READ_SECTOR;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         (PRIVATE) HASH ENTRY
+ *
+ * Description : Adds an entry's name, attributes, first cluster and size to
+ *               a hash.
+ *
+ * Arguments   : hash      - Pointer to the hash to be updated.
+ *               ref       - Pointer to the entry's FatEntryRef.
+ *               nameStr   - Array of LN_STR_LEN_MAX chars. Set to the name.
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS or the error of fat_GetEntryName.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_HashEntry(uint32_t *hash, const FatEntryRef *ref,
+                             char nameStr[], const BPB *bpb)
+{
+  uint8_t err;
+
+  if ((err = fat_GetEntryName(ref, nameStr, bpb)) != SUCCESS)
+    return err;
+  *hash = pvt_HashBytes(*hash, nameStr, strlen(nameStr) + 1);
+  *hash = pvt_HashBytes(*hash, &ref->attr, sizeof(ref->attr));
+  *hash = pvt_HashBytes(*hash, &ref->fstClusIndx, sizeof(ref->fstClusIndx));
+  *hash = pvt_HashBytes(*hash, &ref->fileSize, sizeof(ref->fileSize));
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         (PRIVATE) HASH BYTES
+ *
+ * Description : Adds bytes to a 32-bit djb2 hash, as fat_HashName does for
+ *               a name.
+ *
+ * Arguments   : hash      - The hash so far.
+ *               byteArr   - Pointer to the bytes.
+ *               len       - Number of bytes.
+ *
+ * Returns     : The updated hash.
+ * ----------------------------------------------------------------------------
+ */
+static uint32_t pvt_HashBytes(uint32_t hash, const void *byteArr, size_t len)
+{
+  const uint8_t *byte = byteArr;
+
+  while (len--)
+    hash = (hash << 5) + hash + *byte++;
+  return hash;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                               (PRIVATE) GET 32-BIT FAT VALUE
+ *
+ * Description : Returns the little-endian 32-bit value at byteArr.
+ *
+ * Arguments   : byteArr   - Pointer to the first (least significant) byte.
+ *
+ * Returns     : The value.
+ * ----------------------------------------------------------------------------
+ */
+static uint32_t pvt_GetU32(const uint8_t byteArr[])
+{
+  uint32_t val = byteArr[3];
+  val <<= 8;
+  val |= byteArr[2];
+  val <<= 8;
+  val |= byteArr[1];
+  val <<= 8;
+  val |= byteArr[0];
+  return val;
+}
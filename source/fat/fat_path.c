@@ -0,0 +1,331 @@
+/*
+ * File       : FAT_PATH.C
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of FAT_PATH.H
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include "fat_bpb.h"
+#include "fat.h"
+#include "fat_arena.h"
+#include "fat_path.h"
+
+/*
+ ******************************************************************************
+ *                      "PRIVATE" FUNCTION PROTOTYPES (and MACROS)
+ ******************************************************************************
+ */
+
+static uint8_t pvt_ResolveDir(FatDir *dir, const char pathStr[], 
+                              uint8_t pathLen, const BPB *bpb);
+static uint8_t pvt_SetDirToChild(FatDir *dir, const char nameStr[], 
+                                 const BPB *bpb);
+static void pvt_SetMostRecent(uint8_t orderPos);
+
+// parent cluster index used to mark an empty cache slot. Never a valid index.
+#define PATH_CACHE_EMPTY_SLOT     0
+
+//
+// A cached directory. parentClusIndx and nameHash locate it, and ref is the
+// entry it was found at in its parent.
+//
+typedef struct
+{
+  uint32_t    parentClusIndx;
+  uint16_t    nameHash;
+  FatEntryRef ref;
+}
+PathCacheDir;
+
+//
+// Cache slots. order[] holds the slot numbers from most recently used 
+// (order[0]) to least recently used (order[FAT_PATH_CACHE_DIRS - 1]).
+//
+static PathCacheDir dirs[FAT_PATH_CACHE_DIRS];
+static uint8_t      order[FAT_PATH_CACHE_DIRS];
+static uint8_t      initialized = 0;
+
+// hit/miss counters returned by fat_PathCacheGetStats.
+static FatPathCacheStats stats;
+
+/*
+ ******************************************************************************
+ *                                 FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          RESOLVE PATH TO DIR
+ *
+ * Description : Sets a FatDir instance to the directory given by a path.
+ *
+ * Arguments   : dir       - Pointer to a FatDir instance. A relative path 
+ *                           starts from this directory. It is set to the 
+ *                           directory at the end of the path.
+ *               pathStr   - The path, e.g. "/Artist/Album" or "../Album".
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, INVALID_NAME if a name in the path is too long, 
+ *               DIR_NOT_FOUND if a directory in the path does not exist, or 
+ *               FAILED_READ_SECTOR / CORRUPT_FAT_ENTRY. If not SUCCESS, dir
+ *               is unchanged.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_ResolvePath(FatDir *dir, const char pathStr[], const BPB *bpb)
+{
+  uint8_t err;
+  size_t  pathLen = strlen(pathStr);
+
+  if (pathLen >= PATH_STR_LEN_MAX)
+    return INVALID_NAME;
+
+  // resolve the path in a copy of dir borrowed from the arena.
+  FatDir *workDir = fat_ArenaBorrow();
+  *workDir = *dir;
+  if ((err = pvt_ResolveDir(workDir, pathStr, pathLen, bpb)) == SUCCESS)
+    *dir = *workDir;
+  fat_ArenaReturn(workDir);
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          OPEN FILE FROM PATH
+ *
+ * Description : Opens the file given by a path, as fat_Open does.
+ *
+ * Arguments   : file      - Pointer to the FatFile instance to be set.
+ *               dir       - Pointer to a FatDir instance. A relative path 
+ *                           starts from this directory. It is not changed.
+ *               pathStr   - The path of the file, e.g. 
+ *                           "/Artist/Album/Track.mp3".
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : An error returned by fat_ResolvePath for the directories of 
+ *               the path, INVALID_NAME if the path ends in '/', or a value
+ *               returned by fat_Open for the file.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_OpenPath(FatFile *file, const FatDir *dir, const char pathStr[],
+                     const BPB *bpb)
+{
+  uint8_t err;
+  size_t  pathLen = strlen(pathStr);
+
+  if (pathLen >= PATH_STR_LEN_MAX)
+    return INVALID_NAME;
+
+  // the file name follows the last separator, if there is one.
+  const char *fileStr = strrchr(pathStr, PATH_SEPARATOR);
+  fileStr = fileStr ? fileStr + 1 : pathStr;
+  if (!*fileStr)
+    return INVALID_NAME;
+
+  // 
+  // resolve the directories of the path in a copy of dir borrowed from the 
+  // arena, then open the file in the last one.
+  //
+  FatDir *workDir = fat_ArenaBorrow();
+  *workDir = *dir;
+  if ((err = pvt_ResolveDir(workDir, pathStr, fileStr - pathStr, bpb)) 
+      == SUCCESS)
+    err = fat_Open(file, workDir, fileStr, bpb);
+  fat_ArenaReturn(workDir);
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        INVALIDATE PATH CACHE
+ *
+ * Description : Empties the path cache.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_PathCacheInvalidate(void)
+{
+  for (uint8_t slot = 0; slot < FAT_PATH_CACHE_DIRS; ++slot)
+  {
+    dirs[slot].parentClusIndx = PATH_CACHE_EMPTY_SLOT;
+    order[slot] = slot;
+  }
+  initialized = 1;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       GET / RESET STATISTICS
+ *
+ * Description : Copies the path cache counters into st, or clears them.
+ *
+ * Arguments   : st   - Pointer to a FatPathCacheStats instance to be loaded.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_PathCacheGetStats(FatPathCacheStats *st)
+{
+  *st = stats;
+}
+
+void fat_PathCacheResetStats(void)
+{
+  stats.hits = 0;
+  stats.misses = 0;
+}
+
+/*
+ ******************************************************************************
+ *                            "PRIVATE" FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  (PRIVATE) RESOLVE DIRECTORY
+ *
+ * Description : Moves a FatDir instance through each directory name of a 
+ *               path in turn.
+ *
+ * Arguments   : dir       - Pointer to the FatDir instance to be moved.
+ *               pathStr   - Pointer to the path.
+ *               pathLen   - Number of chars of pathStr to resolve.
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : As for fat_ResolvePath, but dir may have been moved part way
+ *               along the path if not SUCCESS.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_ResolveDir(FatDir *dir, const char pathStr[], 
+                              uint8_t pathLen, const BPB *bpb)
+{
+  uint8_t err;
+  char    nameStr[LN_STR_LEN_MAX];
+
+  // absolute path
+  if (pathLen && pathStr[0] == PATH_SEPARATOR)
+    fat_SetDirToRoot(dir, bpb);
+
+  for (uint8_t pos = 0; pos < pathLen; ++pos)
+  {
+    // find the next name in the path, skipping separators.
+    if (pathStr[pos] == PATH_SEPARATOR)
+      continue;
+    uint8_t nameLen = 0;
+    while (pos + nameLen < pathLen && pathStr[pos + nameLen] != PATH_SEPARATOR)
+      ++nameLen;
+    if (nameLen >= LN_STR_LEN_MAX)
+      return INVALID_NAME;
+    memcpy(nameStr, pathStr + pos, nameLen);
+    nameStr[nameLen] = '\0';
+    pos += nameLen;
+
+    // ".", ".." and "~" do not need a search. 
+    if (!strcmp(nameStr, ".") || !strcmp(nameStr, "..") 
+        || !strcmp(nameStr, "~"))
+      err = fat_SetDir(dir, nameStr, bpb);
+    else
+      err = pvt_SetDirToChild(dir, nameStr, bpb);
+    if (err != SUCCESS)
+      return err;
+  }
+  return SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                           (PRIVATE) SET DIRECTORY TO A CHILD
+ *
+ * Description : Sets a FatDir instance to its child directory nameStr. The 
+ *               child is looked up in the path cache, and the directory is
+ *               only searched if it is not there, in which case it is added.
+ *
+ * Arguments   : dir       - Pointer to the FatDir instance.
+ *               nameStr   - The name of the child directory.
+ *               bpb       - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, DIR_NOT_FOUND, FAILED_READ_SECTOR or 
+ *               CORRUPT_FAT_ENTRY.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_SetDirToChild(FatDir *dir, const char nameStr[], 
+                                 const BPB *bpb)
+{
+  uint8_t  err;
+  uint16_t nameHash = fat_HashName(nameStr);
+
+  if (!initialized)
+    fat_PathCacheInvalidate();
+
+  //
+  // search slots from most to least recently used. The entry of a slot whose
+  // parent and hash match is compared with nameStr, in case of a collision
+  // or if the entry has changed.
+  //
+  for (uint8_t orderPos = 0; orderPos < FAT_PATH_CACHE_DIRS; ++orderPos)
+  {
+    PathCacheDir *cached = &dirs[order[orderPos]];
+    if (cached->parentClusIndx != dir->fstClusIndx 
+        || cached->nameHash != nameHash)
+      continue;
+
+    err = fat_MatchEntryName(&cached->ref, nameStr, bpb);
+    if (err == SUCCESS && cached->ref.attr & DIR_ENTRY_ATTR)
+    {
+      ++stats.hits;
+      pvt_SetMostRecent(orderPos);
+      return fat_SetDirToEntry(dir, &dirs[order[0]].ref, nameStr, bpb);
+    }
+    if (err == FAILED_READ_SECTOR)
+      return err;
+  }
+
+  // miss. Search the directory and replace the least recently used slot.
+  ++stats.misses;
+  pvt_SetMostRecent(FAT_PATH_CACHE_DIRS - 1);
+  PathCacheDir *cached = &dirs[order[0]];
+  cached->parentClusIndx = PATH_CACHE_EMPTY_SLOT;
+
+  err = fat_FindEntry(dir, nameStr, DIR_ENTRY_ATTR | VOLUME_ID_ATTR, 
+                      DIR_ENTRY_ATTR, &cached->ref, bpb);
+  if (err == END_OF_DIRECTORY)
+    return DIR_NOT_FOUND;
+  if (err != SUCCESS)
+    return err;
+
+  cached->parentClusIndx = dir->fstClusIndx;
+  cached->nameHash = nameHash;
+  return fat_SetDirToEntry(dir, &cached->ref, nameStr, bpb);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                        (PRIVATE) SET MOST RECENTLY USED SLOT
+ *
+ * Description : Moves the slot at position orderPos of the LRU order to the
+ *               front, shifting the more recently used slots back by one.
+ *
+ * Arguments   : orderPos   - position in order[] of the slot being used.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_SetMostRecent(uint8_t orderPos)
+{
+  uint8_t slot = order[orderPos];
+  for (; orderPos > 0; --orderPos)
+    order[orderPos] = order[orderPos - 1];
+  order[0] = slot;
+}
@@ -0,0 +1,239 @@
+/*
+ * File       : FAT_SORT.C
+ * Version    : 2.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of FAT_SORT.H
+ */
+
+#include <string.h>
+#include <avr/io.h>
+#include "fat_bpb.h"
+#include "fat.h"
+#include "fat_arena.h"
+#include "fat_sort.h"
+
+/*
+ ******************************************************************************
+ *                      "PRIVATE" FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+static uint8_t pvt_SelectPage(FatSort *srt, const BPB *bpb);
+static int8_t pvt_CompareKeys(const FatSortKey *key1, const FatSortKey *key2);
+
+/*
+ ******************************************************************************
+ *                                 FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   INITIALIZE SORTED ITERATOR
+ *
+ * Description : Sets a FatSort instance to the first entry, in name order,
+ *               of a directory.
+ *
+ * Arguments   : srt        - Pointer to the FatSort instance.
+ *               dir        - Pointer to the FatDir instance of the directory.
+ *               keys       - Array of keysMax FatSortKey elements.
+ *               keysMax    - Number of elements in keys. At least 1.
+ *               attrMask   - Attribute bits to test.
+ *               attrVal    - Value the tested bits must have.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_SortInit(FatSort *srt, const FatDir *dir, FatSortKey keys[],
+                  uint8_t keysMax, uint8_t attrMask, uint8_t attrVal)
+{
+  srt->dir = dir;
+  srt->keys = keys;
+  srt->keysMax = keysMax;
+  srt->attrMask = attrMask;
+  srt->attrVal = attrVal;
+  srt->filter = NULL;
+  fat_SortRewind(srt);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            NEXT SORTED ENTRY
+ *
+ * Description : Sets a FatEntryRef to the next entry of the directory in name
+ *               order.
+ *
+ * Arguments   : srt    - Pointer to a FatSort instance set by fat_SortInit.
+ *               ref    - Pointer to the FatEntryRef instance to be set.
+ *               bpb    - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS, END_OF_DIRECTORY or FAILED_READ_SECTOR.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t fat_SortNext(FatSort *srt, FatEntryRef *ref, const BPB *bpb)
+{
+  uint8_t err;
+
+  if (srt->keyPos == srt->keyCnt)
+  {
+    // a pass that did not fill the page selected every entry that was left.
+    if (srt->passCnt && srt->keyCnt < srt->keysMax)
+      return END_OF_DIRECTORY;
+    if ((err = pvt_SelectPage(srt, bpb)) != SUCCESS)
+      return err;
+    if (!srt->keyCnt)
+      return END_OF_DIRECTORY;
+  }
+  srt->last = srt->keys[srt->keyPos++];
+
+  // return to the entry with a cursor borrowed from the arena.
+  FatCursor *cur = fat_ArenaBorrow();
+  if ((err = fat_SeekCursor(cur, srt->dir, srt->last.entNum, bpb))
+      == SUCCESS)
+    err = fat_CursorNextRef(cur, ref, 0, 0, bpb);
+  fat_ArenaReturn(cur);
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            SET SORTED FILTER
+ *
+ * Description : Sets a function that chooses, by their names, which of the
+ *               entries whose attributes match are returned.
+ *
+ * Arguments   : srt      - Pointer to a FatSort instance set by fat_SortInit.
+ *               filter   - Function returning 1 if the entry is returned, or
+ *                          NULL.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_SortSetFilter(FatSort *srt,
+                       uint8_t (*filter)(const char nameStr[], uint8_t attr))
+{
+  srt->filter = filter;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       REWIND SORTED ITERATOR
+ *
+ * Description : Sets a FatSort instance back to the first entry in name
+ *               order.
+ *
+ * Arguments   : srt   - Pointer to a FatSort instance set by fat_SortInit.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void fat_SortRewind(FatSort *srt)
+{
+  srt->keyCnt = 0;
+  srt->keyPos = 0;
+  srt->passCnt = 0;
+}
+
+/*
+ ******************************************************************************
+ *                           "PRIVATE" FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   (PRIVATE) SELECT NEXT PAGE
+ *
+ * Description : Scans the directory and selects, in name order, the first
+ *               srt->keysMax entries that follow srt->last, or the first ones
+ *               of the directory if this is the first pass.
+ *
+ * Arguments   : srt   - Pointer to the FatSort instance. The entries are
+ *                       loaded into srt->keys.
+ *               bpb   - Pointer to the BPB struct instance.
+ *
+ * Returns     : SUCCESS or FAILED_READ_SECTOR.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_SelectPage(FatSort *srt, const BPB *bpb)
+{
+  uint8_t     err;
+  FatEntryRef ref;
+  FatSortKey  cand;
+  char        nameStr[LN_STR_LEN_MAX];
+  uint8_t     fstPass = !srt->passCnt;
+
+  srt->keyCnt = 0;
+  srt->keyPos = 0;
+  ++srt->passCnt;
+
+  FatCursor *cur = fat_ArenaBorrow();
+  fat_InitCursor(cur, srt->dir);
+  while ((err = fat_CursorNextRef(cur, &ref, srt->attrMask, srt->attrVal,
+                                  bpb)) == SUCCESS)
+  {
+    if ((err = fat_GetEntryName(&ref, nameStr, bpb)) != SUCCESS)
+      break;
+    if (!strcmp(nameStr, ".") || !strcmp(nameStr, "..")
+        || (srt->filter && !srt->filter(nameStr, ref.attr)))
+      continue;
+
+    strncpy(cand.key, nameStr, FAT_SORT_KEY_LEN);
+    cand.entNum = ref.entNum;
+    if (!fstPass && pvt_CompareKeys(&cand, &srt->last) <= 0)
+      continue;
+
+    // insert the entry in order, dropping the last one if the page is full.
+    uint8_t pos = srt->keyCnt;
+    if (pos == srt->keysMax)
+    {
+      if (pvt_CompareKeys(&cand, &srt->keys[pos - 1]) >= 0)
+        continue;
+      --pos;
+    }
+    else
+      ++srt->keyCnt;
+
+    for (; pos > 0 && pvt_CompareKeys(&cand, &srt->keys[pos - 1]) < 0; --pos)
+      srt->keys[pos] = srt->keys[pos - 1];
+    srt->keys[pos] = cand;
+  }
+  fat_ArenaReturn(cur);
+  if (err == END_OF_DIRECTORY)
+    return SUCCESS;
+
+  // the pass is made again by the next call.
+  srt->keyCnt = 0;
+  --srt->passCnt;
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       (PRIVATE) COMPARE KEYS
+ *
+ * Description : Compares two keys by their names, ignoring case, and then by
+ *               their entry numbers.
+ *
+ * Arguments   : key1, key2   - Pointers to the keys.
+ *
+ * Returns     : < 0 if key1 is first, > 0 if key2 is first, or 0 if they are
+ *               the same entry.
+ * ----------------------------------------------------------------------------
+ */
+static int8_t pvt_CompareKeys(const FatSortKey *key1, const FatSortKey *key2)
+{
+  int cmp = strncasecmp(key1->key, key2->key, FAT_SORT_KEY_LEN);
+
+  if (cmp)
+    return (cmp < 0) ? -1 : 1;
+  if (key1->entNum != key2->entNum)
+    return (key1->entNum < key2->entNum) ? -1 : 1;
+  return 0;
+}
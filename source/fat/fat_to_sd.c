@@ -19,6 +19,7 @@
 #include "fat_bpb.h"
 #include "fat.h"
 #include "fat_to_disk_if.h"
+#include "fat_to_sd.h"
 
 /*
  ******************************************************************************
@@ -26,6 +27,7 @@
  ******************************************************************************
  */
 static uint8_t pvt_GetCardType(void);
+static uint16_t pvt_GetAddrMult(void);
 
 // macros used in by pvt_GetCardType
 #define GET_CARD_TYPE_ERROR 0xFF
@@ -34,6 +36,25 @@ static uint8_t pvt_GetCardType(void);
 #define CSD_VSN_2           0x40
 #define CSD_BYTE_LEN        16
 
+// times FATtoDisk_ReadSectors restarts a stream that was stopped under it.
+#define STREAM_RESTARTS     2
+
+//
+// Card descriptor. Set once by FATtoSD_Mount (or lazily by pvt_GetAddrMult if
+// the card was never mounted) and then used by every FATtoDisk function to
+// translate sector numbers into card addresses without sending any commands.
+//
+static SDCardDesc cardDesc;
+
+// access counters returned by FATtoSD_GetStats.
+static FATtoSDStats stats;
+
+//
+// Sector that the open read stream will deliver next. Only valid while
+// sd_IsReadStreamOpen returns 1. 
+//
+static uint32_t streamNextBlk;
+
 /*
  ******************************************************************************
  *                                 FUNCTIONS
@@ -59,17 +80,17 @@ static uint8_t pvt_GetCardType(void);
 uint32_t FATtoDisk_FindBootSector(void)
 {
   //
-  // Determine card type. If SDHC then the SD card is block addressable and
-  // the block number will be the address of the block. If SDSC then card is
-  // byte addressable, in which case the address of the block is the address
-  // of the first byte in the block, thus the address would be found by
-  // multiplying the number of the first byte in the block by BLOCK_LEN.
+  // If SDHC then the SD card is block addressable and the block number will
+  // be the address of the block. If SDSC then card is byte addressable, in
+  // which case the address of the block is the address of the first byte in
+  // the block, thus the address would be found by multiplying the number of
+  // the first byte in the block by BLOCK_LEN. The multiplier is taken from 
+  // the card descriptor.
   // 
-  uint16_t addrMult = 1;                    // init for SDHC. Block addressable
-  if (pvt_GetCardType() == SDSC)            // SDSC is byte addressable
-    addrMult = BLOCK_LEN;
+  uint16_t addrMult = pvt_GetAddrMult();
   
   // Send the READ MULTIPLE BLOCK command and confirm R1 Response is good.
+  sd_StopReadStream();
   CS_SD_LOW;
   sd_SendCommand(READ_MULTIPLE_BLOCK, FBS_SEARCH_START_BLOCK * addrMult); 
   if (sd_GetR1() != OUT_OF_IDLE)
@@ -89,17 +110,17 @@ uint32_t FATtoDisk_FindBootSector(void)
     // loop until the 'Start Block Token' has been received from the SD card,
     // which indicates data from requested block is about to be sent.
     //
-    for (uint16_t timeout = 0; sd_ReceiveByteSPI() != START_BLOCK_TKN;)
-      if (++timeout >= TIMEOUT_LIMIT)
+    for (uint32_t timeout = 0; sd_ReceiveByteSPI() != START_BLOCK_TKN; 
+         ++timeout)
+      if (timeout >= SD_READ_TIMEOUT_BYTES)
       {
         CS_SD_HIGH;
-        print_Str("\n\rSTART_TOKEN_TIMEOUT");
+        print_StrP(PSTR("\n\rSTART_TOKEN_TIMEOUT"));
         return FAILED_FIND_BOOT_SECTOR;
       }
 
     // load all bytes of the sector into the block array
-    for (uint16_t byteNum = 0; byteNum < BLOCK_LEN; ++byteNum) 
-      blckArr[byteNum] = sd_ReceiveByteSPI();
+    sd_ReceiveBlockSPI(blckArr, BLOCK_LEN);
     
     // 16-bit CRC. CRC is off (default) so these values do not matter.
     sd_ReceiveByteSPI(); 
@@ -147,28 +168,204 @@ uint32_t FATtoDisk_FindBootSector(void)
 uint8_t FATtoDisk_ReadSingleSector(uint32_t blkNum, uint8_t blkArr[])
 {
   //
-  // Determine card type. If SDHC then the SD card is block addressable and
-  // the block number will be the address of the block. If SDSC then the card
-  // is byte addressable, in which case the address of the block is the number
-  // of the first byte in the block, thus the address would be found by
-  // multiplying the number of the first byte in the block by BLOCK_LEN (=512).
+  // If SDHC then the SD card is block addressable and the block number will
+  // be the address of the block. If SDSC then the card is byte addressable, 
+  // in which case the address of the block is the number of the first byte in
+  // the block, thus the address would be found by multiplying the number of
+  // the first byte in the block by BLOCK_LEN (=512). The multiplier is taken
+  // from the card descriptor so no command is sent to determine it here.
   // 
-  uint16_t addrMult = 1;                    // init for SDHC. Block addressable
-  if (pvt_GetCardType() == SDSC)            // SDSC is block addressable
-    addrMult = BLOCK_LEN;
+  uint16_t addrMult = pvt_GetAddrMult();
+  uint32_t spiBytes = spi_GetByteCount();
+  uint16_t err;
 
   // Load data block into array by passing the array to the Read Block function
-  if (sd_ReadSingleBlock(blkNum * addrMult, blkArr) == READ_SUCCESS)
+  err = sd_ReadSingleBlock(blkNum * addrMult, blkArr);
+
+  // update access counters
+  ++stats.secReads;
+  ++stats.readCmds;
+  stats.spiBytes += spi_GetByteCount() - spiBytes;
+
+  if (err == READ_SUCCESS)
+    return READ_SECTOR_SUCCESS; 
+  return FAILED_READ_SECTOR;
+}
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                           READ CONSECUTIVE SECTORS FROM DISK
+ *                                       
+ * Description : Loads the contents of consecutive sectors/blocks, beginning
+ *               at the specified address on the SD card, into the array 
+ *               blksArr.
+ *
+ * Arguments   : startBlkNum   - Block number address of the first sector to
+ *                               be read.
+ *               blkCnt        - Number of consecutive sectors to read.
+ *               blksArr       - Pointer to the array that will be loaded with
+ *                               the contents of the sectors. Must be of length
+ *                               blkCnt * BLOCK_LEN.
+ * 
+ * Returns     : READ_SECTOR_SUCCES if successful.
+ *               READ_SECTOR_FAILED if failure.
+ * 
+ * Notes       : The sectors are read from a READ_MULTIPLE_BLOCK stream that
+ *               is left open when this function returns. If the next call
+ *               begins at the sector following the last one read, the sectors
+ *               are read from the open stream without sending a command. The
+ *               stream is closed (STOP_TRANSMISSION) by any other SD card
+ *               command, by calling sd_StopReadStream, or when another 
+ *               device on the SPI port is selected, in which case it is 
+ *               started again by the next call.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t FATtoDisk_ReadSectors(uint32_t startBlkNum, uint16_t blkCnt, 
+                              uint8_t blksArr[])
+{
+  uint16_t addrMult = pvt_GetAddrMult();
+  uint32_t spiBytes = spi_GetByteCount();
+  uint16_t err = READ_SUCCESS;
+
+  // (re)start the stream if it is closed or is not at startBlkNum.
+  if (!sd_IsReadStreamOpen() || startBlkNum != streamNextBlk)
+  {
+    err = sd_StartReadStream(startBlkNum * addrMult);
+    ++stats.readCmds;
+  }
+  if (err == READ_SUCCESS)
+    err = sd_ReadStreamBlocks(blkCnt, blksArr);
+
+  //
+  // the stream is stopped if another device takes the SPI port between 
+  // reads, e.g. the decoder's DREQ interrupt. Start it again here.
+  //
+  for (uint8_t att = 0; err == READ_STREAM_CLOSED && att < STREAM_RESTARTS;
+       ++att)
+  {
+    err = sd_StartReadStream(startBlkNum * addrMult);
+    ++stats.readCmds;
+    if (err == READ_SUCCESS)
+      err = sd_ReadStreamBlocks(blkCnt, blksArr);
+  }
+  streamNextBlk = startBlkNum + blkCnt;
+
+  // update access counters
+  stats.secReads += blkCnt;
+  stats.spiBytes += spi_GetByteCount() - spiBytes;
+
+  if (err == READ_SUCCESS)
     return READ_SECTOR_SUCCESS; 
   return FAILED_READ_SECTOR;
-};
+}
+
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                  WRITE SINGLE SECTOR TO DISK
+ *                                       
+ * Description : Writes the contents of blkArr to the sector/block at the 
+ *               specified address on the SD card.
+ *
+ * Arguments   : blkNum    - Block number address of the sector/block on the
+ *                           SD card that should be written.
+ *               blkArr    - Pointer to the BLOCK_LEN array to be written.
+ * 
+ * Returns     : WRITE_SECTOR_SUCCESS if successful.
+ *               FAILED_WRITE_SECTOR if failure.
+ * 
+ * Notes       : An open read stream is stopped by sd_WriteSingleBlock, so it
+ *               is started again by the next FATtoDisk_ReadSectors call.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t FATtoDisk_WriteSingleSector(uint32_t blkNum, const uint8_t blkArr[])
+{
+  uint16_t err = sd_WriteSingleBlock(blkNum * pvt_GetAddrMult(), blkArr);
+
+  ++stats.secWrites;
+  if ((err & 0xFF00) == DATA_WRITE_SUCCESS)
+    return WRITE_SECTOR_SUCCESS;
+  return FAILED_WRITE_SECTOR;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        MOUNT SD CARD FOR FAT
+ *                                       
+ * Description : Sets the card descriptor used by the FATtoDisk functions from
+ *               the CTV instance set by sd_InitModeSPI. 
+ *
+ * Arguments   : ctv   - Pointer to the CTV instance that was set by a 
+ *                       successful call to sd_InitModeSPI.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void FATtoSD_Mount(const CTV *ctv)
+{
+  cardDesc.type = ctv->type;
+  cardDesc.addrMult = (ctv->type == SDSC) ? BLOCK_LEN : 1;
+  cardDesc.mounted = 1;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       GET / RESET STATISTICS
+ *                                       
+ * Description : Copies the disk access counters into st, or clears them.
+ *
+ * Arguments   : st   - Pointer to a FATtoSDStats instance to be loaded.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void FATtoSD_GetStats(FATtoSDStats *st)
+{
+  *st = stats;
+}
+
+void FATtoSD_ResetStats(void)
+{
+  stats.secReads = 0;
+  stats.readCmds = 0;
+  stats.spiBytes = 0;
+  stats.secWrites = 0;
+}
 
 /*
  ******************************************************************************
- *                            "PRIVATE" FUNCTION        
+ *                            "PRIVATE" FUNCTIONS        
  ******************************************************************************
  */
 
+/* 
+ * ----------------------------------------------------------------------------
+ *                                                       GET ADDRESS MULTIPLIER
+ *                                       
+ * Description : Returns the sector to card address multiplier held by the
+ *               card descriptor. If the card has not been mounted with 
+ *               FATtoSD_Mount, the card type is requested from the card once
+ *               and the descriptor is set from the result.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : 1 for block addressable (SDHC) or BLOCK_LEN for byte 
+ *               addressable (SDSC) cards.
+ * ----------------------------------------------------------------------------
+ */
+static uint16_t pvt_GetAddrMult(void)
+{
+  if (!cardDesc.mounted)
+  {
+    uint8_t cardType = pvt_GetCardType();
+    if (cardType == GET_CARD_TYPE_ERROR)   // assume SDHC, try again later
+      return 1;
+    cardDesc.type = cardType;
+    cardDesc.addrMult = (cardType == SDSC) ? BLOCK_LEN : 1;
+    cardDesc.mounted = 1;
+  }
+  return cardDesc.addrMult;
+}
+
 /* 
  * ----------------------------------------------------------------------------
  *                                                             GET SD CARD TYPE
@@ -186,6 +383,7 @@ static uint8_t pvt_GetCardType(void)
 {
   uint8_t cardType;
 
+  sd_StopReadStream();
   CS_SD_LOW;
   sd_SendCommand(SEND_CSD, 0);
   if (sd_GetR1() != OUT_OF_IDLE) 
@@ -195,9 +393,9 @@ static uint8_t pvt_GetCardType(void)
   }
 
   // Get CSD version to determine if card is SDHC or SDSC
-  for (uint16_t timeout = 0; ; ++timeout)
+  for (uint32_t timeout = 0; ; ++timeout)
   {
-    if (timeout >= TIMEOUT_LIMIT)           // if timeout is reached
+    if (timeout >= SD_READ_TIMEOUT_BYTES)   // if timeout is reached
     { 
       // Read in rest of CSD bytes, though not used.
       for(int byteNum = 0; byteNum < CSD_BYTE_LEN - 1; ++byteNum) 
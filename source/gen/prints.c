@@ -15,12 +15,73 @@
 #include "prints.h"
 #include "usart0.h"
 
+/*
+ ******************************************************************************
+ *                       "PRIVATE" FUNCTION PROTOTYPES and DATA
+ ******************************************************************************
+ */
+
+//
+// Powers of 10 used to convert a number to decimal digits by subtraction. 
+// The AVR has no divide instruction, so each 32-bit divide or modulo is a 
+// call to a software routine costing hundreds of cycles, while a digit by 
+// subtraction costs at most 9 compare and subtract steps.
+//
+static const uint32_t pow10[] PROGMEM = {1000000000, 100000000, 10000000, 
+                                         1000000, 100000, 10000, 1000, 100, 
+                                         10, 1};
+
+#define DEC_DIGITS_MAX      10              // digits in 4294967295
+
 /*
  ******************************************************************************
  *                                  FUNCTIONS 
  ******************************************************************************
  */
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                              FORMAT UNSIGNED DECIMAL INTEGER
+ * 
+ * Description : Writes the decimal digits of num to str, right aligned in a
+ *               field of at least width chars. str is not null terminated.
+ * 
+ * Arguments   : str     Array the digits are written to. It must hold at 
+ *                       least max(width, 10) chars.
+ *               num     Unsigned integer to be formatted.
+ *               width   Min number of chars to write.
+ *               pad     Char written before the digits to fill the width, 
+ *                       e.g. ' ' or '0'.
+ * 
+ * Returns     : number of chars written to str.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t print_FmtDec(char *str, uint32_t num, uint8_t width, char pad)
+{
+  // skip the powers of 10 greater than num. The last digit is always output.
+  uint8_t p = 0;
+  while (p < DEC_DIGITS_MAX - 1 && num < pgm_read_dword(&pow10[p]))
+    ++p;
+
+  uint8_t len = 0;
+  for (uint8_t digitCnt = DEC_DIGITS_MAX - p; digitCnt < width; ++digitCnt)
+    str[len++] = pad;
+
+  // each digit is the number of times its power of 10 can be subtracted.
+  for (; p < DEC_DIGITS_MAX; ++p)
+  {
+    uint32_t pw = pgm_read_dword(&pow10[p]);
+    char     digit = '0';
+    while (num >= pw)
+    {
+      num -= pw;
+      ++digit;
+    }
+    str[len++] = digit;
+  }
+  return len;
+}
+
 /*
  * ----------------------------------------------------------------------------
  *                                    PRINT UNSIGNED DECIMAL (BASE-10) INTEGERS 
@@ -34,28 +95,32 @@
  */
 void print_Dec(uint32_t num)
 {
-  const uint8_t radix = 10;                 // decimal radix
-  char digit[10];                           // length is max possible digits
-  int  digitCnt = 0;                        // total number of digits required
+  print_DecW(num, 0, ' ');
+}
 
-  //
-  // 1) Load last digit (remainder) of num into array when divided by 10.
-  // 2) Update the value of the num by dividing itself by 10.
-  // 4) Repeat until number is 0. 
-  // Note: The array is loaded in reverse order.
-  //
-  for (digitCnt = 0; num > 0; digitCnt++)
-  {
-    digit[digitCnt] = num % radix + '0';    // add 48 to convert to ascii
-    num /= radix; 
-  }
+/*
+ * ----------------------------------------------------------------------------
+ *                                   PRINT FIXED WIDTH UNSIGNED DECIMAL INTEGER
+ * 
+ * Description : Prints num in decimal, right aligned in a field of at least
+ *               width chars, e.g. print_DecW(7, 2, '0') prints "07".
+ * 
+ * Arguments   : num     Unsigned integer to be printed to the screen.
+ *               width   Min number of chars to print, up to PRINT_WIDTH_MAX.
+ *               pad     Char printed before the digits to fill the width.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void print_DecW(uint32_t num, uint8_t width, char pad)
+{
+  char digit[PRINT_WIDTH_MAX];
 
-  // print digits.
-  if (digitCnt == 0)
-    usart_Transmit('0');
-  else
-    for (--digitCnt; digitCnt >= 0; digitCnt--)
-      usart_Transmit(digit[digitCnt]);
+  if (width > PRINT_WIDTH_MAX)
+    width = PRINT_WIDTH_MAX;
+  uint8_t len = print_FmtDec(digit, num, width, pad);
+  for (uint8_t i = 0; i < len; ++i)
+    usart_Transmit(digit[i]);
 }
 
 /*
@@ -74,20 +139,19 @@ void print_Dec(uint32_t num)
  */
 void print_Bin(uint32_t num)
 {
-  const uint8_t radix = 2;                  // binary radix
   char digit[32];                           // length is max possible digits
   int  digitCnt = 0;                        // total number of digits required
 
   //
-  // 1) Load remainder of number into digit array when divided by 2. 
-  // 2) Update the value of the number by dividing itself by 2.
+  // 1) Load the lowest bit of number into digit array.
+  // 2) Shift the number right by 1 bit.
   // 4) Repeat until number is 0. 
   // Note: The array is loaded in reverse order.
   //
   for (digitCnt = 0; num > 0; digitCnt++)
   {
-    digit[digitCnt] = num % radix + '0';    // add 48 to convert to ascii
-    num /= radix; 
+    digit[digitCnt] = (num & 1) + '0';      // add 48 to convert to ascii
+    num >>= 1; 
   }
 
   // print digits.
@@ -117,21 +181,20 @@ void print_Bin(uint32_t num)
  */
 void print_Hex(uint32_t num)
 {
-  const uint8_t radix = 16;                 // hex radix
   char digit[8];                            // length is max possible digits
   int  digitCnt = 0;                        // total number of digits required
   
   //
-  // 1) Load last digit (remainder) of num into array when divided by radix.
-  // 2) Update the value of num by dividing itself by the radix.
+  // 1) Load the lowest 4 bits (hex digit) of num into the array.
+  // 2) Shift num right by 4 bits.
   // 3) Convert the array value to an ascii number or letter (A-F) character.
   // 4) Repeat until num is 0. 
   // Note: The array is loaded in reverse order.
   //
   for (digitCnt = 0; num > 0; digitCnt++)
   {
-    digit[digitCnt] = num % radix;
-    num /= radix;
+    digit[digitCnt] = num & 0x0F;
+    num >>= 4;
 
     // convert to ascii characters
     if (digit[digitCnt] < 10)
@@ -168,3 +231,85 @@ void print_Str(char *str)
     usart_Transmit(*str);
 }
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                             PRINT C-STRING IN PROGRAM MEMORY
+ *                                       
+ * Description : Prints a C-string that is stored in program memory (flash).
+ * 
+ * Argument    : str     Pointer to a null-terminated string in program 
+ *                       memory, e.g. PSTR("text") or an array declared 
+ *                       PROGMEM.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void print_StrP(const char *str)
+{
+  for (char c; (c = pgm_read_byte(str)); str++)
+    usart_Transmit(c);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        LINE BUFFER FUNCTIONS
+ *                                       
+ * Description : print_BufInit empties a line buffer. print_BufStr, 
+ *               print_BufStrP (program memory string), print_BufChar and 
+ *               print_BufDec add to the end of the line. 
+ *               print_BufFlush sends the line to the screen in one call and 
+ *               empties it.
+ * 
+ * Argument    : buf     Pointer to a PrintBuf instance.
+ *               str     String to add.
+ *               c       Char to add.
+ *               num     Unsigned integer to add in decimal.
+ *               width   Min number of chars to add for num.
+ *               pad     Char added before the digits of num to fill width.
+ * 
+ * Returns     : void
+ * 
+ * Notes       : If the buffer becomes full it is flushed, so that nothing is
+ *               lost, i.e. a line longer than PRINT_BUF_LEN is sent in more
+ *               than one call.
+ * ----------------------------------------------------------------------------
+ */
+void print_BufInit(PrintBuf *buf)
+{
+  buf->len = 0;
+}
+
+void print_BufChar(PrintBuf *buf, char c)
+{
+  if (buf->len >= PRINT_BUF_LEN)
+    print_BufFlush(buf);
+  buf->str[buf->len++] = c;
+}
+
+void print_BufStr(PrintBuf *buf, const char *str)
+{
+  for (; *str; str++)
+    print_BufChar(buf, *str);
+}
+
+void print_BufStrP(PrintBuf *buf, const char *str)
+{
+  for (char c; (c = pgm_read_byte(str)); str++)
+    print_BufChar(buf, c);
+}
+
+void print_BufDec(PrintBuf *buf, uint32_t num, uint8_t width, char pad)
+{
+  if (width > PRINT_WIDTH_MAX)
+    width = PRINT_WIDTH_MAX;
+  if (buf->len > PRINT_BUF_LEN - PRINT_WIDTH_MAX)
+    print_BufFlush(buf);
+  buf->len += print_FmtDec(buf->str + buf->len, num, width, pad);
+}
+
+void print_BufFlush(PrintBuf *buf)
+{
+  for (uint8_t i = 0; i < buf->len; ++i)
+    usart_Transmit(buf->str[i]);
+  buf->len = 0;
+}
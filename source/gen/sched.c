@@ -0,0 +1,275 @@
+/*
+ * File       : SCHED.C
+ * Version    : 1.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of SCHED.H
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "prints.h"
+#include "sched.h"
+
+/*
+ ******************************************************************************
+ *                               "PRIVATE" DATA
+ ******************************************************************************
+ */
+
+// ms since sched_Init. Incremented by the Timer0 compare interrupt.
+static volatile uint32_t ticks;
+
+static SchedTask *tasks[SCHED_TASKS_MAX];
+static uint8_t taskCnt;
+
+/*
+ ******************************************************************************
+ *                                 FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         INITIALIZE SCHEDULER
+ *
+ * Description : Removes all tasks and starts the 1 ms Timer0 tick.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sched_Init(void)
+{
+  taskCnt = 0;
+  ticks = 0;
+
+  // CTC mode, prescaler 64, compare match A interrupt.
+  TCCR0A = 1 << WGM01;
+  TCCR0B = 1 << CS01 | 1 << CS00;
+  OCR0A = SCHED_TICK_TOP;
+  TCNT0 = 0;
+  TIMSK0 |= 1 << OCIE0A;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                     ADD TASK
+ *
+ * Description : Sets a task instance and adds it to the scheduler. The task
+ *               is ready to run immediately.
+ *
+ * Arguments   : task          - pointer to the SchedTask instance.
+ *               fn            - the task function.
+ *               name          - name of the task, for sched_PrintTrace. It
+ *                               must be in program memory, e.g. PSTR("name").
+ *               relDeadline   - ms after the task becomes ready by which it
+ *                               should have been run.
+ *
+ * Returns     : SCHED_SUCCESS or SCHED_TASKS_FULL.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t sched_AddTask(SchedTask *task, uint16_t (*fn)(void),
+                      const char *name, uint16_t relDeadline)
+{
+  if (taskCnt >= SCHED_TASKS_MAX)
+    return SCHED_TASKS_FULL;
+
+  task->fn = fn;
+  task->name = name;
+  task->relDeadline = relDeadline;
+  task->suspended = 0;
+  task->release = sched_Millis();
+  task->deadline = task->release + relDeadline;
+  tasks[taskCnt++] = task;
+
+  sched_ResetTrace();
+  return SCHED_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    WAKE TASK
+ *
+ * Description : Makes a task ready to run now, whether it was suspended or
+ *               waiting for its next release time.
+ *
+ * Arguments   : task   - pointer to the SchedTask instance.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sched_Wake(SchedTask *task)
+{
+  task->suspended = 0;
+  task->release = sched_Millis();
+  task->deadline = task->release + task->relDeadline;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          RUN NEXT TASK / RUN
+ *
+ * Description : sched_RunNext runs the ready task with the earliest deadline,
+ *               if any. sched_Run calls sched_RunNext forever.
+ *
+ * Arguments   : void
+ *
+ * Returns     : sched_RunNext returns 1 if a task was run, else 0.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t sched_RunNext(void)
+{
+  uint32_t   now = sched_Millis();
+  SchedTask *next = 0;
+
+  //
+  // find the ready task with the earliest deadline. Times are compared by
+  // their difference so that the ms count may wrap.
+  //
+  for (uint8_t t = 0; t < taskCnt; ++t)
+  {
+    SchedTask *task = tasks[t];
+    if (task->suspended || (int32_t)(now - task->release) < 0)
+      continue;
+    if (!next || (int32_t)(task->deadline - next->deadline) < 0)
+      next = task;
+  }
+  if (!next)
+    return 0;
+
+  // run the task and record how long it waited and how long it ran.
+  uint32_t start = sched_Micros();
+  uint32_t latency = start - next->release * 1000;
+  if ((int32_t)latency > 0 && latency > next->maxLatency)
+    next->maxLatency = latency;
+  if ((int32_t)(now - next->deadline) > 0)
+    ++next->missCnt;
+
+  uint16_t delay = next->fn();
+
+  uint32_t end = sched_Micros();
+  if (end - start > next->maxRunTime)
+    next->maxRunTime = end - start;
+  ++next->runCnt;
+
+  // set the time the task is ready again.
+  if (delay == SCHED_SUSPEND)
+    next->suspended = 1;
+  else
+  {
+    next->release = end / 1000 + delay;
+    next->deadline = next->release + next->relDeadline;
+  }
+  return 1;
+}
+
+void sched_Run(void)
+{
+  for (;;)
+    sched_RunNext();
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        MILLISECONDS / MICROS
+ *
+ * Description : Returns the time since sched_Init in ms, or in us.
+ *
+ * Arguments   : void
+ *
+ * Returns     : time in ms or us.
+ * ----------------------------------------------------------------------------
+ */
+uint32_t sched_Millis(void)
+{
+  uint32_t ms;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    ms = ticks;
+  }
+  return ms;
+}
+
+uint32_t sched_Micros(void)
+{
+  uint32_t ms;
+  uint8_t  cnt;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    ms = ticks;
+    cnt = TCNT0;
+
+    // the counter may have been cleared before the tick was counted.
+    if ((TIFR0 & 1 << OCF0A) && cnt < SCHED_TICK_TOP)
+      ++ms;
+  }
+  return ms * 1000 + cnt * SCHED_US_PER_COUNT;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          PRINT / RESET TRACE
+ *
+ * Description : sched_PrintTrace prints, for each task, the number of runs,
+ *               deadline misses, max latency and max run time.
+ *               sched_ResetTrace clears them.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sched_PrintTrace(void)
+{
+  print_StrP(PSTR("\n\r TASK        RUNS      MISSED  "
+                  "MAX LATENCY(us)  MAX RUN(us)"));
+  for (uint8_t t = 0; t < taskCnt; ++t)
+  {
+    const SchedTask *task = tasks[t];
+
+    print_StrP(PSTR("\n\r "));
+    print_StrP(task->name);
+    print_StrP(PSTR("\t"));
+    print_Dec(task->runCnt);
+    print_StrP(PSTR("\t"));
+    print_Dec(task->missCnt);
+    print_StrP(PSTR("\t"));
+    print_Dec(task->maxLatency);
+    print_StrP(PSTR("\t\t"));
+    print_Dec(task->maxRunTime);
+  }
+}
+
+void sched_ResetTrace(void)
+{
+  for (uint8_t t = 0; t < taskCnt; ++t)
+  {
+    tasks[t]->runCnt = 0;
+    tasks[t]->missCnt = 0;
+    tasks[t]->maxLatency = 0;
+    tasks[t]->maxRunTime = 0;
+  }
+}
+
+/*
+ ******************************************************************************
+ *                                INTERRUPTS
+ ******************************************************************************
+ */
+
+// Timer0 compare match A, every 1 ms.
+ISR(TIMER0_COMPA_vect)
+{
+  ++ticks;
+}
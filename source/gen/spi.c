@@ -14,6 +14,30 @@
 #include <avr/io.h>
 #include "spi.h"
 
+#if SPI_BYTE_COUNTER
+static uint32_t byteCnt;                    // see spi_GetByteCount
+#endif
+
+//
+// Per-device SPCR and SPSR values loaded by spi_Select, the chip select pin
+// of each device, and the release hooks set by spi_SetReleaseHook.
+//
+static uint8_t devSPCR[SPI_DEV_CNT];
+static uint8_t devSPSR[SPI_DEV_CNT];
+static const uint8_t devSS[SPI_DEV_CNT] = {SS0, SS1, SS2};
+static void (*releaseHook[SPI_DEV_CNT])(void);
+static volatile uint8_t selDev = SPI_DEV_NONE;
+
+//
+// busy is set from spi_Select until spi_Deselect or spi_Park. idleHook is
+// called each time the bus stops being busy. See spi_SetIdleHook.
+//
+static volatile uint8_t busy = 0;
+static void (*idleHook)(void);
+
+// all chip select pins. Setting these high de-asserts every device.
+#define SS_ALL_MSK           (1 << SS0 | 1 << SS1 | 1 << SS2)
+
 /*
  ******************************************************************************
  *                                  FUNCTIONS
@@ -38,11 +62,24 @@ void spi_MasterInit(void)
              | 1 << DD_SS0 | 1 << DD_SS1 | 1 << DD_SS2;
 
   // Make sure SS pins are high (not asserted) before initializing SPI.
-  SPI_PORT = 1 << SS0 | 1 << SS1;
+  SPI_PORT = SS_ALL_MSK;
+  selDev = SPI_DEV_NONE;
+  busy = 0;
+  idleHook = 0;
   
   // PRSPI in PPR0 must be 0 to enable SPI. Should be 0 by default.
   PRR0 &= ~(1 << PRSPI);
 
+  //
+  // Every device starts in mode 0 at ck/64 = 16MHz/64 = 250KHz. The device
+  // drivers raise their own clock rates once the devices allow it.
+  //
+  for (uint8_t dev = 0; dev < SPI_DEV_CNT; ++dev)
+  {
+    spi_SetProfile(dev, SPI_MODE_0, SPI_CLK_DIV_64);
+    releaseHook[dev] = 0;
+  }
+
   //Enable SPI in master mode. Set clock rate: ck/64 = 16MHz/64 = 250KHz.
   //SPCR: SPIE=0, SPE=1, DORD=0, MSTR=1, CPOL=0, CPHA=0, SPR1=1, SPR0=0
   SPCR = 1 << SPE | 1 << MSTR | 1 << SPR1;
@@ -51,6 +88,154 @@ void spi_MasterInit(void)
   SPSR &= ~(1 << SPI2X);
 }
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       SET SPI DEVICE PROFILE
+ * 
+ * Description : Sets the SPI mode and clock divisor that will be used each
+ *               time the device is selected by spi_Select.
+ * 
+ * Arguments   : dev      - SPI_DEV_SD, SPI_DEV_VS_SCI or SPI_DEV_VS_SDI.
+ *               mode     - SPI_MODE_0 to SPI_MODE_3.
+ *               clkDiv   - one of the SPI_CLK_DIV_n macros.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void spi_SetProfile(uint8_t dev, uint8_t mode, uint8_t clkDiv)
+{
+  devSPCR[dev] = 1 << SPE | 1 << MSTR | mode 
+                 | (clkDiv & (1 << SPR1 | 1 << SPR0));
+  devSPSR[dev] = (clkDiv & 0x04) ? 1 << SPI2X : 0;
+
+  if (selDev == dev)
+  {
+    SPCR = devSPCR[dev];
+    SPSR = devSPSR[dev];
+  }
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      SET DEVICE RELEASE HOOK
+ * 
+ * Description : Sets a function that is called when dev is still selected 
+ *               and a different device is selected with spi_Select.
+ * 
+ * Arguments   : dev    - SPI_DEV_SD, SPI_DEV_VS_SCI or SPI_DEV_VS_SDI.
+ *               hook   - function to call, or 0 for none.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void spi_SetReleaseHook(uint8_t dev, void (*hook)(void))
+{
+  releaseHook[dev] = hook;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                 SELECT / DESELECT SPI DEVICE
+ * 
+ * Description : spi_Select loads the device's mode and clock profile and 
+ *               asserts (sets low) its chip select pin, de-asserting all of
+ *               the others. spi_Deselect de-asserts the device's chip select.
+ * 
+ * Arguments   : dev   - SPI_DEV_SD, SPI_DEV_VS_SCI or SPI_DEV_VS_SDI.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void spi_Select(uint8_t dev)
+{
+  // mark the bus busy first so an interrupt will not take it from here on.
+  busy = 1;
+
+  // let a device that still holds the bus finish with it first.
+  if (selDev != dev && selDev != SPI_DEV_NONE && releaseHook[selDev])
+  {
+    releaseHook[selDev]();
+    busy = 1;
+  }
+
+  // profile must be loaded before the chip select is asserted.
+  SPCR = devSPCR[dev];
+  SPSR = devSPSR[dev];
+  SPI_PORT = (SPI_PORT | SS_ALL_MSK) & ~(1 << devSS[dev]);
+  selDev = dev;
+}
+
+void spi_Deselect(uint8_t dev)
+{
+  SPI_PORT |= 1 << devSS[dev];
+  if (selDev == dev)
+    selDev = SPI_DEV_NONE;
+  busy = 0;
+  if (idleHook)
+    idleHook();
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              PARK SPI DEVICE
+ * 
+ * Description : Leaves the device selected but marks the bus as not busy, so
+ *               another device may be selected, in which case the parked
+ *               device's release hook is called first.
+ * 
+ * Arguments   : dev   - SPI_DEV_SD, SPI_DEV_VS_SCI or SPI_DEV_VS_SDI.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void spi_Park(uint8_t dev)
+{
+  if (selDev == dev)
+    busy = 0;
+  if (idleHook)
+    idleHook();
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              BUS BUSY / IDLE
+ * 
+ * Description : spi_IsBusy returns 1 if a device is selected and in the middle
+ *               of a transaction, else 0. spi_SetIdleHook sets a function that
+ *               is called by spi_Deselect and spi_Park when the bus stops 
+ *               being busy.
+ * 
+ * Arguments   : hook   - function to call, or 0 for none.
+ * 
+ * Returns     : spi_IsBusy returns 1 or 0.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t spi_IsBusy(void)
+{
+  return busy;
+}
+
+void spi_SetIdleHook(void (*hook)(void))
+{
+  idleHook = hook;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      GET SELECTED SPI DEVICE
+ * 
+ * Description : Returns the device that is currently selected.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : SPI_DEV_SD, SPI_DEV_VS_SCI, SPI_DEV_VS_SDI or SPI_DEV_NONE.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t spi_GetSelected(void)
+{
+  return selDev;
+}
+
 /*
  * ----------------------------------------------------------------------------
  *                                                             SPI RECEIVE BYTE
@@ -83,7 +268,109 @@ void spi_MasterTransmit(uint8_t byte)
   // load byte into SPDR to transmit data.
   SPDR = byte;
 
+  #if SPI_BYTE_COUNTER
+  ++byteCnt;
+  #endif
+
   // wait for data transmission to complete.
   while ( !(SPSR & 1 << SPIF))
     ;
 }
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            SPI RECEIVE BLOCK
+ * 
+ * Description : Receives len bytes into buf, sending 0xFF for each one. 
+ * 
+ * Arguments   : buf   - pointer to the array to be loaded. Must be at least 
+ *                       length len.
+ *               len   - number of bytes to receive.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void spi_ReceiveBlock(uint8_t buf[], uint16_t len)
+{
+  if (!len)
+    return;
+
+  #if SPI_BYTE_COUNTER
+  byteCnt += len;
+  #endif
+
+  //
+  // Start the first transfer, then for each byte: wait for it to complete,
+  // read it, start the next transfer and store the byte while the next one
+  // is shifted in. At F_CPU / 2 a transfer takes 16 CPU cycles, which is 
+  // enough time to store the byte and update the loop.
+  //
+  SPDR = 0xFF;
+  while (--len)
+  {
+    while ( !(SPSR & 1 << SPIF))
+      ;
+    uint8_t byte = SPDR;
+    SPDR = 0xFF;
+    *buf++ = byte;
+  }
+  while ( !(SPSR & 1 << SPIF))
+    ;
+  *buf = SPDR;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           SPI TRANSMIT BLOCK
+ * 
+ * Description : Sends len bytes from buf. The received bytes are discarded.
+ * 
+ * Arguments   : buf   - pointer to the array of bytes to send.
+ *               len   - number of bytes to send.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void spi_TransmitBlock(const uint8_t buf[], uint16_t len)
+{
+  if (!len)
+    return;
+
+  #if SPI_BYTE_COUNTER
+  byteCnt += len;
+  #endif
+
+  // load the next byte from buf while the previous one is transferred.
+  SPDR = *buf++;
+  while (--len)
+  {
+    uint8_t byte = *buf++;
+    while ( !(SPSR & 1 << SPIF))
+      ;
+    SPDR = byte;
+  }
+  while ( !(SPSR & 1 << SPIF))
+    ;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           GET SPI BYTE COUNT
+ * 
+ * Description : Returns the number of bytes transmitted (and therefore also
+ *               received) by the SPI port since initialization. The counter
+ *               wraps around at 2^32.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : SPI byte count, or 0 if SPI_BYTE_COUNTER is not set.
+ * ----------------------------------------------------------------------------
+ */
+uint32_t spi_GetByteCount(void)
+{
+  #if SPI_BYTE_COUNTER
+  return byteCnt;
+  #else
+  return 0;
+  #endif
+}
@@ -12,8 +12,43 @@
  */
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #include "usart0.h"
 
+/*
+ ******************************************************************************
+ *                      "PRIVATE" FUNCTION PROTOTYPES and DATA
+ ******************************************************************************
+ */
+
+static void pvt_SendQueued(void);
+
+#define TX_MSK              (USART_TX_BUF_LEN - 1)
+#define RX_MSK              (USART_RX_BUF_LEN - 1)
+
+// stops the compiler moving queue accesses past an index update.
+#define QUEUE_BARRIER       __asm__ __volatile__ ("" ::: "memory")
+
+//
+// Transmit queue. txHead and txTail run freely and are masked with TX_MSK,
+// so txHead - txTail is the number of bytes queued. Only usart_TryTransmit
+// changes txHead and only the UDRE interrupt (or pvt_SendQueued with 
+// interrupts disabled) changes txTail.
+//
+static uint8_t txBuf[USART_TX_BUF_LEN];
+static volatile uint8_t txHead;
+static volatile uint8_t txTail;
+
+//
+// Receive queue, in the same form. Only the RXC interrupt changes rxHead 
+// and only usart_Receive changes rxTail.
+//
+static uint8_t rxBuf[USART_RX_BUF_LEN];
+static volatile uint8_t rxHead;
+static volatile uint8_t rxTail;
+static volatile uint8_t rxDropped;
+
 /*
  ******************************************************************************
  *                                  FUNCTIONS
@@ -37,8 +72,11 @@ void usart_Init(void)
   UBRR0H = (uint8_t)(UBRR_VALUE >> 8);
   UBRR0L = (uint8_t)UBRR_VALUE;
 
-  // Enable USART0 receiver and transmitter
-  UCSR0B = 1 << RXEN0 | 1 << TXEN0;
+  // Enable USART0 receiver, transmitter and RX complete interrupt. Empty the
+  // queues.
+  txHead = txTail = 0;
+  rxHead = rxTail = rxDropped = 0;
+  UCSR0B = 1 << RXCIE0 | 1 << RXEN0 | 1 << TXEN0;
   
   // Set USART - Asynch mode, no parity, data frame = 8 data, 1 stop
   UCSR0C = 1 << UCSZ01 | 1 << UCSZ00;
@@ -48,28 +86,142 @@ void usart_Init(void)
  * ----------------------------------------------------------------------------
  *                                                           USART RECEIVE BYTE
  *                                         
- * Description : Receives a byte using the USART0 on the ATmega target device.
+ * Description : Returns the next received byte from the receive queue. If the
+ *               queue is empty, waits until a byte is received.
  * 
  * Arguments   : void
  * 
- * Returns     : byte received by the USART0, i.e. value in UDR0.
+ * Returns     : byte received by the USART0.
  * ----------------------------------------------------------------------------
 */
 uint8_t usart_Receive(void)
 {
-  // poll the RX complete flag, until it is set
-  while ( !(UCSR0A & 1 << RXC0))
-    ;
-  
-  // return byte received into usart buffer
-  return UDR0; 
+  while (rxHead == rxTail)
+  {
+    // the RXC interrupt cannot run if interrupts are disabled.
+    if (!(SREG & 1 << SREG_I) && (UCSR0A & 1 << RXC0))
+      return UDR0;
+  }
+
+  uint8_t data = rxBuf[rxTail & RX_MSK];
+  QUEUE_BARRIER;
+  ++rxTail;
+  return data;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          USART RECEIVE READY
+ *                                         
+ * Description : Checks whether a received byte is waiting in USART0, so that
+ *               usart_Receive can be called without blocking.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : 1 if a byte has been received, else 0.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t usart_ReceiveReady(void)
+{
+  return (rxHead != rxTail || UCSR0A & 1 << RXC0) ? 1 : 0;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        USART RECEIVE DROPPED
+ *                                         
+ * Description : Returns the number of received bytes that were dropped 
+ *               because the receive queue was full, and clears the count.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : number of dropped bytes, up to 255.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t usart_ReceiveDropped(void)
+{
+  uint8_t cnt;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    cnt = rxDropped;
+    rxDropped = 0;
+  }
+  return cnt;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       INITIALIZE / POLL LINE
+ *                                         
+ * Description : usart_InitLine empties a line. usart_PollLine adds the 
+ *               received bytes to the line, echoing them, until return is 
+ *               received or the receive queue is empty. Never waits.
+ * 
+ * Arguments   : line     pointer to a UsartLine instance.
+ * 
+ * Returns     : usart_PollLine returns USART_LINE_NONE if return has not been 
+ *               received yet, else USART_LINE_READY, or USART_LINE_OVERFLOW if 
+ *               chars were dropped because the line was full.
+ * ----------------------------------------------------------------------------
+ */
+void usart_InitLine(UsartLine *line)
+{
+  line->len = 0;
+  line->overflow = 0;
+  line->done = 0;
+}
+
+uint8_t usart_PollLine(UsartLine *line)
+{
+  // the line returned by the previous call has been used.
+  if (line->done)
+    usart_InitLine(line);
+
+  while (rxHead != rxTail)
+  {
+    uint8_t c = usart_Receive();
+
+    if (c == '\r')
+    {
+      line->str[line->len] = '\0';
+      line->done = 1;
+      return line->overflow ? USART_LINE_OVERFLOW : USART_LINE_READY;
+    }
+    else if (c == USART_BACKSPACE || c == '\b')
+    {
+      //
+      // Ascii backspace is 8 ('\b'). To behave as expected when backspace 
+      // is pressed, i.e. delete previous char, this prints backspace, 
+      // space, backspace.
+      //
+      if (line->len > 0)
+      {
+        usart_Transmit('\b');
+        usart_Transmit(' ');
+        usart_Transmit('\b');
+        --line->len;
+      }
+    }
+    else if (c < ' ' || c > '~')
+      ;                                     // ignore other control chars
+    else if (line->len < USART_LINE_MAX_CHAR - 1)
+    {
+      usart_Transmit(c);
+      line->str[line->len++] = c;
+    }
+    else
+      line->overflow = 1;
+  }
+  return USART_LINE_NONE;
 }
 
 /*
  * ----------------------------------------------------------------------------
  *                                                          USART TRANSMIT BYTE
  *                                       
- * Description : Sends a byte to another device via the USART0.
+ * Description : Queues a byte to be sent by USART0. If the transmit queue is
+ *               full, waits until there is room.
  * 
  * Arguments   : data     byte to sent via USART0.
  * 
@@ -78,10 +230,135 @@ uint8_t usart_Receive(void)
  */
 void usart_Transmit(uint8_t data)
 {
-  // poll Data Reg Empty Flag until it is set.
-  while( !(UCSR0A & 1 << UDRE0))
+  while (!usart_TryTransmit(data))
+  {
+    // the UDRE interrupt cannot empty the queue if interrupts are disabled.
+    if (!(SREG & 1 << SREG_I))
+      pvt_SendQueued();
+  }
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      USART TRY TRANSMIT BYTE
+ *                                       
+ * Description : Queues a byte to be sent by USART0 if there is room in the 
+ *               transmit queue. Never waits.
+ * 
+ * Arguments   : data     byte to sent via USART0.
+ * 
+ * Returns     : 1 if the byte was queued, 0 if the queue was full.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t usart_TryTransmit(uint8_t data)
+{
+  if ((uint8_t)(txHead - txTail) >= USART_TX_BUF_LEN)
+    return 0;
+
+  txBuf[txHead & TX_MSK] = data;
+  QUEUE_BARRIER;
+  ++txHead;
+
+  // the interrupt disables itself when the queue is empty.
+  UCSR0B |= 1 << UDRIE0;
+  return 1;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    USART TRANSMIT QUEUE ROOM
+ *                                       
+ * Description : Returns the number of bytes that can be queued without 
+ *               waiting.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : free bytes in the transmit queue.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t usart_TxRoom(void)
+{
+  return USART_TX_BUF_LEN - (uint8_t)(txHead - txTail);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                  USART FLUSH
+ *                                       
+ * Description : Waits until every queued byte has been sent.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void usart_Flush(void)
+{
+  while (txHead != txTail)
+    if (!(SREG & 1 << SREG_I))
+      pvt_SendQueued();
+
+  // wait for the last byte to leave the data register.
+  while (!(UCSR0A & 1 << UDRE0))
     ;
-  
-  // load data into usart buffer which will transmit it.
-  UDR0 = data;
+}
+
+/*
+ ******************************************************************************
+ *                            "PRIVATE" FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   (PRIVATE) SEND QUEUED BYTE
+ *                                       
+ * Description : Sends the next queued byte by polling UDRE0. Only used when
+ *               interrupts are disabled.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_SendQueued(void)
+{
+  while (!(UCSR0A & 1 << UDRE0))
+    ;
+  UDR0 = txBuf[txTail & TX_MSK];
+  ++txTail;
+}
+
+/*
+ ******************************************************************************
+ *                                INTERRUPTS
+ ******************************************************************************
+ */
+
+// USART0 receive complete. Queue the byte, or drop it if the queue is full.
+ISR(USART0_RX_vect)
+{
+  uint8_t data = UDR0;
+
+  if ((uint8_t)(rxHead - rxTail) >= USART_RX_BUF_LEN)
+  {
+    if (rxDropped < 0xFF)
+      ++rxDropped;
+    return;
+  }
+  rxBuf[rxHead & RX_MSK] = data;
+  QUEUE_BARRIER;
+  ++rxHead;
+}
+
+// USART0 data register empty. Send the next queued byte.
+ISR(USART0_UDRE_vect)
+{
+  if (txHead == txTail)
+  {
+    UCSR0B &= ~(1 << UDRIE0);
+    return;
+  }
+  UDR0 = txBuf[txTail & TX_MSK];
+  ++txTail;
 }
@@ -1,52 +1,666 @@
+/*
+ * File       : MP3.C
+ * Version    : 1.0
+ * Target     : ATMega1280
+ * Compiler   : AVR-GCC 9.3.0
+ * Downloader : AVRDUDE 6.3
+ * License    : GNU GPLv3
+ * Author     : Joshua Fain
+ * Copyright (c) 2020, 2021
+ *
+ * Implementation of MP3.H
+ */
+
+#include <string.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
+#include "spi.h"
+#include "fat_bpb.h"
+#include "fat.h"
 #include "mp3.h"
-#include "prints.h"
 
+/*
+ ******************************************************************************
+ *                      "PRIVATE" FUNCTION PROTOTYPES
+ ******************************************************************************
+ */
+
+static void pvt_SetSlowProfiles(void);
+static void pvt_SetFastProfiles(void);
+static uint8_t pvt_GetEndFillByte(void);
+static uint8_t pvt_SendEndFill(uint8_t endFill, uint16_t len);
+static void pvt_Feed(uint8_t inIsr);
+static void pvt_KickFeed(void);
+static void pvt_RunPendingFeed(void);
+
+#define RING_MSK            (VS_RING_CHUNKS - 1)
+
+// stops the compiler moving ring buffer accesses past an index update.
+#define RING_BARRIER        __asm__ __volatile__ ("" ::: "memory")
+
+// playback states
+#define PLAY_IDLE           0
+#define PLAY_FILE           1               // reading the file into the ring
+#define PLAY_END_FILL       2               // file read, sending endFill
+
+//
+// Ring buffer of SDI chunks. head and tail run freely and are masked with 
+// RING_MSK, so head - tail is the number of chunks in the ring. Only the
+// producer (vs_PlayRefill) changes head and only the consumer (pvt_Feed)
+// changes tail.
+//
+static uint8_t ring[VS_RING_CHUNKS][VS_SDI_CHUNK_LEN];
+static uint8_t chunkLen[VS_RING_CHUNKS];
+static volatile uint8_t head;
+static volatile uint8_t tail;
+
+// playback state used by vs_PlayRefill.
+static volatile uint8_t playState = PLAY_IDLE;
+static FatFile *playFile;
+static uint8_t  endFillByte;
+static uint16_t endFillLeft;
+
+// feeder state. See pvt_Feed.
+static volatile uint8_t feeding;
+static volatile uint8_t feedPending;
+static volatile uint8_t starved;
+static volatile uint8_t primed;
+static VSFeedStats feedStats = { .lowWater = VS_RING_CHUNKS };
+
+/*
+ ******************************************************************************
+ *                                 FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                           INITIALIZE DECODER
+ *
+ * Description : Sets the XRESET and DREQ pins, resets the decoder and sets
+ *               SCI_MODE, SCI_CLOCKF and the volume. The SCI and SDI SPI
+ *               profiles are then raised to the FAST clock divisors.
+ *
+ * Arguments   : void
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_Init(void)
+{
+  // XRESET is an output, DREQ is an input.
+  DDRD |= 1 << DDD0;
+  DDRD &= ~(1 << DDD1);
+
+  if (vs_HardReset() != VS_SUCCESS)
+    return VS_DREQ_TIMEOUT;
+
+  vs_WriteSCI(VS_SCI_MODE, SM_SDINEW);
+  vs_WriteSCI(VS_SCI_CLOCKF, VS_CLOCKF_VAL);
+  if (vs_WaitDREQ() != VS_SUCCESS)
+    return VS_DREQ_TIMEOUT;
+  pvt_SetFastProfiles();
+
+  vs_SetVolume(VS_DEFAULT_VOL, VS_DEFAULT_VOL);
+  return VS_SUCCESS;
+}
 
-void VSReset(void)
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        HARDWARE / SOFT RESET
+ *
+ * Description : vs_HardReset pulses XRESET low. vs_SoftReset sets SM_RESET in
+ *               SCI_MODE. Both then wait for DREQ to go high.
+ *
+ * Arguments   : void
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_HardReset(void)
 {
-	/*
-  Clrb(VS_RST_PRTC,VS_RST_PIN);
-	delay_1ms(500);
-	Setb(VS_RST_PRTS,VS_RST_PIN);
-	delay_1ms(100);
-  */
-         print_Str("\n\rIN RESET \n\rDREQ = 0x");
-    print_Hex(PIND & (1 << DREQ));
   HW_RST_ASSERT
-  _delay_ms(500);
-          print_Str("\n\rDREQ = 0x");
-    print_Hex(PIND & (1 << DREQ));
+  pvt_SetSlowProfiles();
+  _delay_ms(1);
   HW_RST_DEASSERT
-  _delay_ms(500);
-          print_Str("\n\rDREQ = 0x");
-    print_Hex(PIND & (1 << DREQ));
-           print_Str("\n\rEXIT RESET");
+  _delay_ms(1);
+  return vs_WaitDREQ();
+}
+
+uint8_t vs_SoftReset(void)
+{
+  vs_WriteSCI(VS_SCI_MODE, SM_SDINEW | SM_RESET);
+  pvt_SetSlowProfiles();
+  _delay_us(2);                             // DREQ goes low within 2 us.
+  if (vs_WaitDREQ() != VS_SUCCESS)
+    return VS_DREQ_TIMEOUT;
+
+  // CLKI is XTALI again after the reset.
+  vs_WriteSCI(VS_SCI_CLOCKF, VS_CLOCKF_VAL);
+  if (vs_WaitDREQ() != VS_SUCCESS)
+    return VS_DREQ_TIMEOUT;
+  pvt_SetFastProfiles();
+  return VS_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        WAIT FOR DATA REQUEST
+ *
+ * Description : Waits until the decoder sets DREQ high.
+ *
+ * Arguments   : void
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_WaitDREQ(void)
+{
+  for (uint16_t timeout = 0; !DREQ_HIGH; ++timeout)
+    if (timeout >= DREQ_TIMEOUT_LIMIT)
+      return VS_DREQ_TIMEOUT;
+  return VS_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    WRITE / READ SCI REGISTER
+ *
+ * Description : Writes val to, or reads the value of, the SCI register at
+ *               addr.
+ *
+ * Arguments   : addr   - SCI register address, VS_SCI_MODE to VS_SCI_AICTRL3.
+ *               val    - 16-bit value to write.
+ *
+ * Returns     : vs_WriteSCI returns void. vs_ReadSCI returns the register
+ *               value.
+ * ----------------------------------------------------------------------------
+ */
+void vs_WriteSCI(uint8_t addr, uint16_t val)
+{
+  vs_WaitDREQ();
+  XCS_ASSERT;
+  spi_MasterTransmit(VS_INS_WRITE);
+  spi_MasterTransmit(addr);
+  spi_MasterTransmit((uint8_t)(val >> 8));
+  spi_MasterTransmit((uint8_t)val);
+  XCS_DEASSERT;
+}
+
+uint16_t vs_ReadSCI(uint8_t addr)
+{
+  uint16_t val;
+
+  vs_WaitDREQ();
+  XCS_ASSERT;
+  spi_MasterTransmit(VS_INS_READ);
+  spi_MasterTransmit(addr);
+  spi_MasterTransmit(0xFF);
+  val = spi_MasterReceive();
+  val <<= 8;
+  spi_MasterTransmit(0xFF);
+  val |= spi_MasterReceive();
+  XCS_DEASSERT;
+  return val;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                               WRITE SDI DATA
+ *
+ * Description : Sends len bytes of audio data to the decoder's SDI. The data
+ *               is sent in chunks of up to VS_SDI_CHUNK_LEN bytes, waiting
+ *               for DREQ before each chunk.
+ *
+ * Arguments   : data   - pointer to the array of data to send.
+ *               len    - number of bytes to send.
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_WriteSDI(const uint8_t data[], uint16_t len)
+{
+  while (len)
+  {
+    uint8_t cnt = (len > VS_SDI_CHUNK_LEN) ? VS_SDI_CHUNK_LEN : len;
+
+    // DREQ high guarantees room for VS_SDI_CHUNK_LEN bytes.
+    if (vs_WaitDREQ() != VS_SUCCESS)
+      return VS_DREQ_TIMEOUT;
+    XDCS_ASSERT;
+    spi_TransmitBlock(data, cnt);
+    XDCS_DEASSERT;
+
+    data += cnt;
+    len -= cnt;
+  }
+  return VS_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                   SET VOLUME
+ *
+ * Description : Sets the left and right channel volume.
+ *
+ * Arguments   : left    - left channel attenuation. 0x00 is loudest and 0xFE
+ *                         is silent, in 0.5 dB steps.
+ *               right   - right channel attenuation.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void vs_SetVolume(uint8_t left, uint8_t right)
+{
+  vs_WriteSCI(VS_SCI_VOL, (uint16_t)left << 8 | right);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                                    PLAY FILE
+ *
+ * Description : Streams an open file to the decoder from its current
+ *               position until the end of the file, then sends the
+ *               endFillBytes needed for the decoder to finish the file.
+ *
+ * Arguments   : file   - pointer to a FatFile instance opened by fat_Open.
+ *               bpb    - pointer to the BPB struct instance.
+ *
+ * Returns     : VS_SUCCESS, or VS_DREQ_TIMEOUT or VS_FILE_READ_ERROR if the
+ *               file could not be played to the end.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_PlayFile(FatFile *file, const BPB *bpb)
+{
+  uint8_t err = vs_PlayStart(file, bpb);
+
+  while (err == VS_PLAYING)
+  {
+    //
+    // wait for room in the ring buffer. The decoder has stopped taking data
+    // if DREQ stays low for DREQ_TIMEOUT_LIMIT polls.
+    //
+    for (uint16_t timeout = 0; (uint8_t)(head - tail) == VS_RING_CHUNKS; )
+    {
+      if (DREQ_HIGH)
+      {
+        pvt_KickFeed();
+        timeout = 0;
+      }
+      else if (++timeout >= DREQ_TIMEOUT_LIMIT)
+      {
+        vs_PlayStop();
+        return VS_DREQ_TIMEOUT;
+      }
+    }
+    err = vs_PlayRefill(bpb);
+  }
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                   START / REFILL / STOP PLAY
+ *
+ * Description : Non-blocking playback. vs_PlayStart fills the ring buffer 
+ *               from the file and enables the DREQ interrupt (INT1), which
+ *               sends a chunk from the ring buffer to the decoder each time
+ *               DREQ is high. vs_PlayRefill must then be called from the 
+ *               main loop to keep the ring buffer full. vs_PlayStop disables
+ *               the interrupt and empties the ring buffer.
+ *
+ * Arguments   : file   - pointer to a FatFile instance opened by fat_Open.
+ *               bpb    - pointer to the BPB struct instance.
+ *
+ * Returns     : vs_PlayStart and vs_PlayRefill return VS_PLAYING until the
+ *               file and the endFillBytes have all been sent to the decoder,
+ *               then VS_SUCCESS, or VS_FILE_READ_ERROR if the file could not
+ *               be read, which also stops playback. 
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_PlayStart(FatFile *file, const BPB *bpb)
+{
+  vs_PlayStop();
+  endFillByte = pvt_GetEndFillByte();
+  endFillLeft = VS_END_FILL_LEN;
+  playFile = file;
+  starved = 0;
+  primed = 0;
+  playState = PLAY_FILE;
+
+  //
+  // INT1 on the rising edge of DREQ. The ring is filled by vs_PlayRefill 
+  // before the first chunk is sent.
+  //
+  EICRA |= (1 << ISC11) | (1 << ISC10);
+  EIFR = 1 << INTF1;
+  EIMSK |= 1 << INT1;
+  spi_SetIdleHook(pvt_RunPendingFeed);
+
+  return vs_PlayRefill(bpb);
+}
+
+uint8_t vs_PlayRefill(const BPB *bpb)
+{
+  uint8_t err;
+
+  if (playState == PLAY_IDLE)
+    return VS_SUCCESS;
+
+  while ((uint8_t)(head - tail) < VS_RING_CHUNKS)
+  {
+    uint8_t slot = head & RING_MSK;
+
+    if (playState == PLAY_FILE)
+    {
+      uint16_t bytesRead;
+
+      err = fat_Read(playFile, ring[slot], VS_SDI_CHUNK_LEN, &bytesRead, bpb);
+      if (err != SUCCESS && err != END_OF_FILE)
+      {
+        vs_PlayStop();
+        return VS_FILE_READ_ERROR;
+      }
+      if (err == END_OF_FILE)
+        playState = PLAY_END_FILL;
+      if (bytesRead == 0)
+        continue;
+      chunkLen[slot] = bytesRead;
+    }
+    else if (endFillLeft)
+    {
+      uint8_t cnt = (endFillLeft > VS_SDI_CHUNK_LEN) ? VS_SDI_CHUNK_LEN 
+                                                     : endFillLeft;
+      memset(ring[slot], endFillByte, cnt);
+      chunkLen[slot] = cnt;
+      endFillLeft -= cnt;
+    }
+    else
+      break;
+
+    // publish the chunk only once it has been written.
+    RING_BARRIER;
+    ++head;
+    if ((uint8_t)(head - tail) > feedStats.highWater)
+      feedStats.highWater = head - tail;
+  }
+
+  // DREQ may already be high, in which case there is no edge to wait for.
+  pvt_KickFeed();
+
+  if (playState == PLAY_END_FILL && !endFillLeft && head == tail)
+  {
+    vs_PlayStop();
+    return VS_SUCCESS;
+  }
+  return VS_PLAYING;
+}
+
+void vs_PlayStop(void)
+{
+  EIMSK &= ~(1 << INT1);
+  spi_SetIdleHook(0);
+  playState = PLAY_IDLE;
+  feedPending = 0;
+  head = tail = 0;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  GET / RESET FEED STATISTICS
+ *
+ * Description : vs_GetFeedStats copies the DREQ feeder's counters to stats.
+ *               vs_ResetFeedStats clears them.
+ *
+ * Arguments   : stats   - pointer to a VSFeedStats instance.
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void vs_GetFeedStats(VSFeedStats *stats)
+{
+  uint8_t msk = EIMSK & (1 << INT1);
+
+  EIMSK &= ~(1 << INT1);
+  *stats = feedStats;
+  EIMSK |= msk;
+}
+
+void vs_ResetFeedStats(void)
+{
+  uint8_t msk = EIMSK & (1 << INT1);
+
+  EIMSK &= ~(1 << INT1);
+  memset(&feedStats, 0, sizeof(feedStats));
+  feedStats.lowWater = VS_RING_CHUNKS;
+  EIMSK |= msk;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                              CANCEL PLAYBACK
+ *
+ * Description : Stops decoding of the current stream following the
+ *               procedure in the VS1053 datasheet: SM_CANCEL is set and
+ *               endFillBytes are sent until the decoder clears it. If it is
+ *               not cleared, the decoder is soft reset.
+ *
+ * Arguments   : void
+ *
+ * Returns     : VS_SUCCESS, or VS_CANCEL_FAILED if a soft reset was needed.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t vs_CancelPlayback(void)
+{
+  uint8_t endFill;
+
+  vs_PlayStop();
+  endFill = pvt_GetEndFillByte();
+
+  vs_WriteSCI(VS_SCI_MODE, SM_SDINEW | SM_CANCEL);
+  for (uint16_t sent = 0; sent < VS_CANCEL_FILL_MAX;
+       sent += VS_SDI_CHUNK_LEN)
+  {
+    if (pvt_SendEndFill(endFill, VS_SDI_CHUNK_LEN) != VS_SUCCESS)
+      break;
+    if (!(vs_ReadSCI(VS_SCI_MODE) & SM_CANCEL))
+      return VS_SUCCESS;
+  }
+
+  vs_SoftReset();
+  return VS_CANCEL_FAILED;
+}
+
+/*
+ ******************************************************************************
+ *                            "PRIVATE" FUNCTIONS
+ ******************************************************************************
+ */
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                             (PRIVATE) SET SPI CLOCK PROFILES
+ *
+ * Description : Sets the SCI and SDI SPI profiles for CLKI = XTALI (slow), or
+ *               for CLKI set by VS_CLOCKF_VAL (fast).
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_SetSlowProfiles(void)
+{
+  spi_SetProfile(SPI_DEV_VS_SCI, SPI_MODE_0, VS_SCI_CLK_DIV);
+  spi_SetProfile(SPI_DEV_VS_SDI, SPI_MODE_0, VS_SDI_CLK_DIV);
+}
+
+static void pvt_SetFastProfiles(void)
+{
+  spi_SetProfile(SPI_DEV_VS_SCI, SPI_MODE_0, VS_SCI_FAST_CLK_DIV);
+  spi_SetProfile(SPI_DEV_VS_SDI, SPI_MODE_0, VS_SDI_FAST_CLK_DIV);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                  (PRIVATE) GET END FILL BYTE
+ *
+ * Description : Reads the endFillByte parameter from the decoder's memory.
+ *
+ * Arguments   : void
+ *
+ * Returns     : endFillByte
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_GetEndFillByte(void)
+{
+  vs_WriteSCI(VS_SCI_WRAMADDR, VS_END_FILL_BYTE_ADDR);
+  return (uint8_t)vs_ReadSCI(VS_SCI_WRAM);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      (PRIVATE) SEND END FILL
+ *
+ * Description : Sends len copies of endFill to the SDI.
+ *
+ * Arguments   : endFill   - endFillByte read from the decoder.
+ *               len       - number of bytes to send.
+ *
+ * Returns     : VS_SUCCESS or VS_DREQ_TIMEOUT.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_SendEndFill(uint8_t endFill, uint16_t len)
+{
+  uint8_t buf[VS_SDI_CHUNK_LEN];
+
+  memset(buf, endFill, VS_SDI_CHUNK_LEN);
+  while (len)
+  {
+    uint8_t cnt = (len > VS_SDI_CHUNK_LEN) ? VS_SDI_CHUNK_LEN : len;
+    if (vs_WriteSDI(buf, cnt) != VS_SUCCESS)
+      return VS_DREQ_TIMEOUT;
+    len -= cnt;
+  }
+  return VS_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                       (PRIVATE) FEED DECODER
+ *
+ * Description : Sends chunks from the ring buffer to the SDI while DREQ is
+ *               high and the ring buffer is not empty. Called by the INT1
+ *               interrupt and by pvt_KickFeed.
+ *
+ * Arguments   : inIsr   - 1 if called by the INT1 interrupt, else 0.
+ *
+ * Returns     : void
+ *
+ * Notes       : 1) If the SPI port is busy the feed is marked as pending and
+ *                  runs from the SPI idle hook once the port is free.
+ *               2) In the interrupt, another device parked on the bus also
+ *                  counts as busy. Selecting the SDI would call its release
+ *                  hook, e.g. sd_StopReadStream, which sends CMD12 and waits
+ *                  up to SD_READ_TIMEOUT_BYTES for the card with interrupts
+ *                  off. Only pvt_KickFeed stops the SD card's read stream.
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_Feed(uint8_t inIsr)
+{
+  uint8_t selDev = spi_GetSelected();
+
+  // spi_Deselect calls the idle hook, which calls this again.
+  if (feeding)
+    return;
+
+  if (spi_IsBusy() 
+      || (inIsr && selDev != SPI_DEV_NONE && selDev != SPI_DEV_VS_SDI))
+  {
+    if (!feedPending)
+    {
+      feedPending = 1;
+      ++feedStats.deferred;
+    }
+    return;
+  }
+
+  feeding = 1;
+  feedPending = 0;
+  while (DREQ_HIGH && tail != head)
+  {
+    uint8_t slot = tail & RING_MSK;
+
+    if (primed && playState == PLAY_FILE && 
+        (uint8_t)(head - tail) < feedStats.lowWater)
+      feedStats.lowWater = head - tail;
+
+    XDCS_ASSERT;
+    spi_TransmitBlock(ring[slot], chunkLen[slot]);
+    XDCS_DEASSERT;
+
+    // free the slot only once it has been sent.
+    RING_BARRIER;
+    ++tail;
+    ++feedStats.chunksFed;
+    starved = 0;
+  }
+
+  //
+  // The watermarks and underruns are only kept once the decoder's FIFO has
+  // been filled, i.e. DREQ went low with chunks still in the ring. Then 
+  // count each time the decoder is left waiting for the file's data.
+  //
+  if (tail != head)
+    primed = 1;
+  else if (primed && playState == PLAY_FILE && !starved && DREQ_HIGH)
+  {
+    starved = 1;
+    ++feedStats.underruns;
+  }
+  feeding = 0;
 }
 
 /*
-void VSSCIWrite(unsigned char ad, unsigned short data)
+ * ----------------------------------------------------------------------------
+ *                                                          (PRIVATE) KICK FEED
+ *
+ * Description : pvt_KickFeed runs pvt_Feed outside of the INT1 interrupt,
+ *               with INT1 masked. pvt_RunPendingFeed is the SPI idle hook 
+ *               and does the same, but only if a feed was deferred.
+ *
+ * Arguments   : void
+ *
+ * Returns     : void
+ *
+ * Notes       : Feeding only when one is pending avoids stopping the SD 
+ *               card's read stream each time it is parked.
+ * ----------------------------------------------------------------------------
+ */
+static void pvt_KickFeed(void)
 {
-	unsigned char spi_buf[4];
-	spi_buf[0] = VS_INS_WRITE;
-	spi_buf[1] = ad;
-	spi_buf[2] = data >> 8;
-	spi_buf[3] = data;
+  uint8_t msk = EIMSK & (1 << INT1);
 
-	VSSCITransfer(4,spi_buf);
+  EIMSK &= ~(1 << INT1);
+  pvt_Feed(0);
+  EIMSK |= msk;
 }
 
-void VSSDITransfer(unsigned int len, unsigned char *spi_buf)
+static void pvt_RunPendingFeed(void)
+{
+  if (feedPending)
+    pvt_KickFeed();
+}
+
+/*
+ ******************************************************************************
+ *                                INTERRUPTS
+ ******************************************************************************
+ */
+
+// DREQ rising edge. The decoder can take another chunk.
+ISR(INT1_vect)
 {
-	//VSSPIInit();
-	
-	Clrb(VS_DCS_PRTC,VS_DCS_PIN);
-	
-	SPIMasterTransfer2(VS_SPI,len,spi_buf);
-	
-	Setb(VS_DCS_PRTS,VS_DCS_PIN);
-	
-	SPIMasterDisable(VS_SPI);
+  pvt_Feed(1);
 }
-*/
@@ -11,10 +11,12 @@
  * Implementation of SD_SPI_BASE.H
  */
 
+#include <string.h>
 #include <avr/io.h>
 #include "prints.h"
 #include "spi.h"
 #include "sd_spi_base.h"
+#include "sd_spi_rwe.h"
 
 /*
  ******************************************************************************
@@ -23,6 +25,15 @@
  */
 
 static uint8_t pvt_CRC7(uint64_t tca);
+static uint8_t pvt_StatGroup(uint8_t cmd);
+
+// see sd_SetCmdWaitMode.
+static uint8_t cmdWaitMode = SD_CMD_WAIT_MODE;
+
+#if SD_CMD_STATS
+static SDCmdStats cmdStats;                 // see sd_GetCmdStats
+static uint8_t lastStatGroup;               // group of the last command sent
+#endif
 
 /*
  ******************************************************************************
@@ -59,6 +70,9 @@ uint32_t sd_InitModeSPI(CTV *ctv)
   if (prevSuccessFlag)
     return OUT_OF_IDLE;
 
+  // use the slow initialization clock until the card is out of idle.
+  spi_SetProfile(SPI_DEV_SD, SPI_MODE_0, SD_INIT_CLK_DIV);
+
   sd_WaitSendDummySPI(80);                 // wait 80 SPI CCs for power up
 
   //
@@ -184,6 +198,13 @@ uint32_t sd_InitModeSPI(CTV *ctv)
   // Initialization success
   CS_SD_HIGH;
   prevSuccessFlag = 1;
+
+  //
+  // switch to the full speed clock, and have an open read stream stopped if
+  // another device on the SPI bus is selected.
+  //
+  spi_SetProfile(SPI_DEV_SD, SPI_MODE_0, SD_CLK_DIV);
+  spi_SetReleaseHook(SPI_DEV_SD, sd_StopReadStream);
   return OUT_OF_IDLE;
 }
 
@@ -199,8 +220,9 @@ uint32_t sd_InitModeSPI(CTV *ctv)
  * 
  * Notes       : 1) Call as many times as required to send the complete data 
  *                  packet, token, command, etc...
- *               2) This function and sd_ReceiveByteSPI(), are the only direct
- *                  SPI interfacing functions in the SD card module.
+ *               2) This function, sd_ReceiveByteSPI() and the block functions
+ *                  are the only direct SPI interfacing functions in the SD 
+ *                  card module.
  * ----------------------------------------------------------------------------
  */
 void sd_SendByteSPI(uint8_t byte)
@@ -220,8 +242,9 @@ void sd_SendByteSPI(uint8_t byte)
  * 
  * Notes       : 1) Call as many times as necessary to get the complete data
  *                  packet, token, error response, etc... from the SD card.
- *               2) This function and sd_SendByteSPI(), are the only direct
- *                  SPI interfacing functions in the SD card module.
+ *               2) This function, sd_SendByteSPI() and the block functions
+ *                  are the only direct SPI interfacing functions in the SD 
+ *                  card module.
  * ----------------------------------------------------------------------------
  */
 uint8_t sd_ReceiveByteSPI(void)
@@ -230,6 +253,29 @@ uint8_t sd_ReceiveByteSPI(void)
   return spi_MasterReceive();          // return SD card's response
 }
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    RECEIVE / SEND DATA BLOCK
+ * 
+ * Description : Receives len bytes from the SD card into arr, or sends len 
+ *               bytes from arr to the SD card, via SPI.
+ * 
+ * Arguments   : arr   - pointer to the array to be loaded or sent.
+ *               len   - number of bytes. Normally BLOCK_LEN.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sd_ReceiveBlockSPI(uint8_t arr[], uint16_t len)
+{
+  spi_ReceiveBlock(arr, len);
+}
+
+void sd_SendBlockSPI(const uint8_t arr[], uint16_t len)
+{
+  spi_TransmitBlock(arr, len);
+}
+
 /*
  * ----------------------------------------------------------------------------
  *                                                                 SEND COMMAND
@@ -244,8 +290,36 @@ uint8_t sd_ReceiveByteSPI(void)
  */
 void sd_SendCommand(uint8_t cmd, uint32_t arg)
 {
-  // Found forcing some delay between commands can improve stability/behavrior.
-  sd_WaitSendDummySPI(80);
+  #if SD_CMD_STATS
+  uint32_t spiBytes = spi_GetByteCount();
+  lastStatGroup = pvt_StatGroup(cmd);
+  #endif
+
+  //
+  // Found forcing some delay between commands can improve stability/behavrior
+  // on some cards, so this is kept as SD_WAIT_DELAY mode. Otherwise only wait
+  // until the card is not busy. The card is sending data when 
+  // STOP_TRANSMISSION is sent, so there is nothing to wait for.
+  //
+  if (cmdWaitMode == SD_WAIT_DELAY)
+    sd_WaitSendDummySPI(SD_CMD_DELAY_CLKS);
+  else if (cmd != STOP_TRANSMISSION)
+  {
+    uint16_t timeout = 0;
+    while (sd_ReceiveByteSPI() != DMY_TKN)
+      if (++timeout >= SD_READY_TIMEOUT)
+      {
+        #if SD_CMD_STATS
+        ++cmdStats.readyTimeouts;
+        #endif
+        break;
+      }
+  }
+
+  #if SD_CMD_STATS
+  ++cmdStats.cmdCnt[lastStatGroup];
+  cmdStats.waitBytes[lastStatGroup] += spi_GetByteCount() - spiBytes;
+  #endif
                            
   // 
   // Construct the command / argument packet to be sent to the SD card. The
@@ -286,14 +360,81 @@ void sd_SendCommand(uint8_t cmd, uint32_t arg)
 uint8_t sd_GetR1(void)
 {
   uint8_t r1;
+  uint8_t timeout = 0;
   
   // loop until SPDR has new values (i.e != dummy token or TO limit reached.
-  for (uint8_t timeout = 0; (r1 = sd_ReceiveByteSPI()) == DMY_TKN; ++timeout)
-    if(timeout >= TIMEOUT_LIMIT) 
-      return R1_TIMEOUT;
+  while ((r1 = sd_ReceiveByteSPI()) == DMY_TKN)
+    if(++timeout >= TIMEOUT_LIMIT) 
+    {
+      r1 = R1_TIMEOUT;
+      break;
+    }
+
+  #if SD_CMD_STATS
+  cmdStats.r1Bytes[lastStatGroup] += (uint32_t)timeout + 1;
+  #endif
   return r1;
 }
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        SET COMMAND WAIT MODE
+ * 
+ * Description : Sets what sd_SendCommand does before sending a command.
+ * 
+ * Arguments   : mode   - SD_WAIT_READY or SD_WAIT_DELAY.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sd_SetCmdWaitMode(uint8_t mode)
+{
+  cmdWaitMode = mode;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                        GET COMMAND WAIT MODE
+ * 
+ * Description : Returns the current command wait mode.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : SD_WAIT_READY or SD_WAIT_DELAY.
+ * ----------------------------------------------------------------------------
+ */
+uint8_t sd_GetCmdWaitMode(void)
+{
+  return cmdWaitMode;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                            GET / RESET COMMAND LATENCY STATS
+ * 
+ * Description : Copies the command latency counters into st, or clears them.
+ * 
+ * Arguments   : st   - Pointer to an SDCmdStats instance to be loaded.
+ * 
+ * Returns     : void
+ * ----------------------------------------------------------------------------
+ */
+void sd_GetCmdStats(SDCmdStats *st)
+{
+  #if SD_CMD_STATS
+  *st = cmdStats;
+  #else
+  memset(st, 0, sizeof(SDCmdStats));
+  #endif
+}
+
+void sd_ResetCmdStats(void)
+{
+  #if SD_CMD_STATS
+  memset(&cmdStats, 0, sizeof(SDCmdStats));
+  #endif
+}
+
 /*
  * ----------------------------------------------------------------------------
  *                                                      PRINT R1 RESPONSE FLAGS
@@ -308,23 +449,23 @@ uint8_t sd_GetR1(void)
 void sd_PrintR1(uint8_t r1)
 {
   if (r1 & R1_TIMEOUT)
-    print_Str (" R1_TIMEOUT,");
+    print_StrP (PSTR(" R1_TIMEOUT,"));
   if (r1 & PARAMETER_ERROR)
-    print_Str (" PARAMETER_ERROR,");
+    print_StrP (PSTR(" PARAMETER_ERROR,"));
   if (r1 & ADDRESS_ERROR)
-    print_Str (" ADDRESS_ERROR,");
+    print_StrP (PSTR(" ADDRESS_ERROR,"));
   if (r1 & ERASE_SEQUENCE_ERROR)
-    print_Str (" ERASE_SEQUENCE_ERROR,");
+    print_StrP (PSTR(" ERASE_SEQUENCE_ERROR,"));
   if (r1 & COM_CRC_ERROR)
-    print_Str (" COM_CRC_ERROR,");
+    print_StrP (PSTR(" COM_CRC_ERROR,"));
   if (r1 & ILLEGAL_COMMAND)
-    print_Str (" ILLEGAL_COMMAND,");
+    print_StrP (PSTR(" ILLEGAL_COMMAND,"));
   if (r1 & ERASE_RESET)
-    print_Str (" ERASE_RESET,");
+    print_StrP (PSTR(" ERASE_RESET,"));
   if (r1 & IN_IDLE_STATE)
-    print_Str (" IN_IDLE_STATE");
+    print_StrP (PSTR(" IN_IDLE_STATE"));
   if (r1 == OUT_OF_IDLE) // 0
-    print_Str (" OUT_OF_IDLE");
+    print_StrP (PSTR(" OUT_OF_IDLE"));
 }
 
 /*
@@ -350,25 +491,25 @@ void sd_PrintR1(uint8_t r1)
 void sd_PrintInitError(uint32_t initResp)
 {
   if (initResp & FAILED_GO_IDLE_STATE)
-    print_Str (" FAILED_GO_IDLE_STATE,");
+    print_StrP (PSTR(" FAILED_GO_IDLE_STATE,"));
   if (initResp & FAILED_SEND_IF_COND)
-    print_Str (" FAILED_SEND_IF_COND,");
+    print_StrP (PSTR(" FAILED_SEND_IF_COND,"));
   if (initResp & UNSUPPORTED_CARD_TYPE)
-    print_Str (" UNSUPPORTED_CARD_TYPE,");
+    print_StrP (PSTR(" UNSUPPORTED_CARD_TYPE,"));
   if (initResp & FAILED_CRC_ON_OFF)
-    print_Str (" FAILED_CRC_ON_OFF,");
+    print_StrP (PSTR(" FAILED_CRC_ON_OFF,"));
   if (initResp & FAILED_APP_CMD)
-    print_Str (" FAILED_APP_CMD,");
+    print_StrP (PSTR(" FAILED_APP_CMD,"));
   if (initResp & FAILED_SD_SEND_OP_COND)
-    print_Str (" FAILED_SD_SEND_OP_COND,");
+    print_StrP (PSTR(" FAILED_SD_SEND_OP_COND,"));
   if (initResp & OUT_OF_IDLE_TIMEOUT)
-    print_Str (" OUT_OF_IDLE_TIMEOUT,");
+    print_StrP (PSTR(" OUT_OF_IDLE_TIMEOUT,"));
   if (initResp & FAILED_READ_OCR)
-    print_Str (" FAILED_READ_OCR,");
+    print_StrP (PSTR(" FAILED_READ_OCR,"));
   if (initResp & POWER_UP_NOT_COMPLETE)
-    print_Str (" POWER_UP_NOT_COMPLETE,");
+    print_StrP (PSTR(" POWER_UP_NOT_COMPLETE,"));
   if (initResp == OUT_OF_IDLE) // 0
-    print_Str (" INIT_SUCCESS\n\r");
+    print_StrP (PSTR(" INIT_SUCCESS\n\r"));
 }
 
 /*
@@ -430,3 +571,31 @@ static uint8_t pvt_CRC7(uint64_t tca)
   }
   return result;
 }
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                    (PRIVATE) GET STATS GROUP
+ * 
+ * Description : Returns the SD_STAT_ group that the command is counted in.
+ * 
+ * Arguments   : cmd   - SD Card command. See sd_spi_car.h.
+ * 
+ * Returns     : SD_STAT_ group number.
+ * ----------------------------------------------------------------------------
+ */
+static uint8_t pvt_StatGroup(uint8_t cmd)
+{
+  switch (cmd)
+  {
+    case READ_SINGLE_BLOCK:
+      return SD_STAT_READ_SINGLE;
+    case READ_MULTIPLE_BLOCK:
+      return SD_STAT_READ_MULTIPLE;
+    case WRITE_BLOCK:
+      return SD_STAT_WRITE;
+    case STOP_TRANSMISSION:
+      return SD_STAT_STOP;
+    default:
+      return SD_STAT_OTHER;
+  }
+}
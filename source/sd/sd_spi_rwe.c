@@ -18,6 +18,9 @@
 #include "sd_spi_base.h"
 #include "sd_spi_rwe.h"
 
+// set to 1 while a read stream started by sd_StartReadStream is open.
+static uint8_t readStreamOpen = 0;
+
 /*
  ******************************************************************************
  *                                 FUNCTIONS   
@@ -54,6 +57,9 @@ uint16_t sd_ReadSingleBlock(uint32_t blckAddr, uint8_t blckArr[])
 {
   uint8_t r1;                               // for R1 responses
 
+  // the card cannot accept a new command while a read stream is open.
+  sd_StopReadStream();
+
   // request contents of a single data block at blckAddr on the SD card.
   CS_SD_LOW;
   sd_SendCommand(READ_SINGLE_BLOCK, blckAddr);
@@ -68,16 +74,16 @@ uint16_t sd_ReadSingleBlock(uint32_t blckAddr, uint8_t blckArr[])
   // loop until the 'Start Block Token' has been received from the SD card,
   // which indicates data from requested blckAddr is about to be sent.
   //
-  for (uint8_t timeout = 0; sd_ReceiveByteSPI() != START_BLOCK_TKN; ++timeout)
-    if (timeout >= TIMEOUT_LIMIT)
+  for (uint32_t timeout = 0; sd_ReceiveByteSPI() != START_BLOCK_TKN; 
+       ++timeout)
+    if (timeout >= SD_READ_TIMEOUT_BYTES)
     {
       CS_SD_HIGH;
       return (START_TOKEN_TIMEOUT | r1);
     }
 
   // Load SD card block into the array.         
-  for (uint16_t byte = 0; byte < BLOCK_LEN; ++byte)
-    blckArr[byte] = sd_ReceiveByteSPI();
+  sd_ReceiveBlockSPI(blckArr, BLOCK_LEN);
 
   // Get 16-bit CRC. Don't need.
   sd_ReceiveByteSPI();
@@ -90,6 +96,182 @@ uint16_t sd_ReadSingleBlock(uint32_t blckAddr, uint8_t blckArr[])
   return (READ_SUCCESS | r1);
 }
 
+/*
+ * ----------------------------------------------------------------------------
+ *                                                         READ MULTIPLE BLOCKS
+ * 
+ * Description : Reads consecutive data blocks from the SD card into an array
+ *               using a single READ_MULTIPLE_BLOCK command.
+ * 
+ * Arguments   : startBlckAddr   - address of the first data block on the SD
+ *                                 card that will be read into the array.
+ *               blckCnt         - number of consecutive blocks to read.
+ *               blcksArr        - pointer to the array to be loaded with the
+ *                                 contents of the data blocks. Must be length
+ *                                 blckCnt * BLOCK_LEN.
+ * 
+ * Returns     : Read Block Error (upper byte) and R1 Response (lower byte).
+ * ----------------------------------------------------------------------------
+ */
+uint16_t sd_ReadMultipleBlocks(uint32_t startBlckAddr, uint16_t blckCnt, 
+                               uint8_t blcksArr[])
+{
+  uint16_t err;
+
+  err = sd_StartReadStream(startBlckAddr);
+  if (err == READ_SUCCESS)
+    err = sd_ReadStreamBlocks(blckCnt, blcksArr);
+  sd_StopReadStream();
+  return err;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                            START READ STREAM
+ * 
+ * Description : Sends READ_MULTIPLE_BLOCK and leaves the SD card selected and
+ *               sending data blocks, beginning at startBlckAddr, until 
+ *               sd_StopReadStream is called.
+ * 
+ * Arguments   : startBlckAddr   - address of the first data block that will
+ *                                 be read from the stream.
+ * 
+ * Returns     : Read Block Error (upper byte) and R1 Response (lower byte).
+ * ----------------------------------------------------------------------------
+ */
+uint16_t sd_StartReadStream(uint32_t startBlckAddr)
+{
+  uint8_t r1;                               // for R1 responses
+
+  // end any stream that is already open.
+  sd_StopReadStream();
+
+  // request contents of the data blocks beginning at startBlckAddr.
+  CS_SD_LOW;
+  sd_SendCommand(READ_MULTIPLE_BLOCK, startBlckAddr);
+  r1 = sd_GetR1();
+  if (r1 != OUT_OF_IDLE)
+  {
+    CS_SD_HIGH;
+    return (R1_ERROR | r1);
+  }
+
+  // card stays selected, but the bus may be taken by another device.
+  readStreamOpen = 1;
+  spi_Park(SPI_DEV_SD);
+  return (READ_SUCCESS | r1);
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                      READ BLOCKS FROM STREAM
+ * 
+ * Description : Reads the next blckCnt data blocks from an open read stream
+ *               into an array.
+ * 
+ * Arguments   : blckCnt    - number of blocks to read.
+ *               blcksArr   - pointer to the array to be loaded with the
+ *                            contents of the data blocks. Must be length
+ *                            blckCnt * BLOCK_LEN.
+ * 
+ * Returns     : Read Block Error (upper byte) and R1 Response (lower byte).
+ *               READ_STREAM_CLOSED is returned if no stream is open.
+ * 
+ * Notes       : If a block's start token is not received the stream is 
+ *               stopped and START_TOKEN_TIMEOUT is returned.
+ * ----------------------------------------------------------------------------
+ */
+uint16_t sd_ReadStreamBlocks(uint16_t blckCnt, uint8_t blcksArr[])
+{
+  //
+  // take the bus back first. The stream may have been stopped by the release
+  // hook if another device used the bus since the last read.
+  //
+  CS_SD_LOW;
+  if (!readStreamOpen)
+  {
+    CS_SD_HIGH;
+    return READ_STREAM_CLOSED;
+  }
+
+  for (uint16_t blck = 0; blck < blckCnt; ++blck)
+  {
+    //
+    // loop until the 'Start Block Token' has been received from the SD card,
+    // which indicates data from the next block is about to be sent.
+    //
+    for (uint32_t timeout = 0; sd_ReceiveByteSPI() != START_BLOCK_TKN; 
+         ++timeout)
+      if (timeout >= SD_READ_TIMEOUT_BYTES)
+      {
+        sd_StopReadStream();
+        return START_TOKEN_TIMEOUT;
+      }
+
+    // Load SD card block into the array.         
+    sd_ReceiveBlockSPI(blcksArr, BLOCK_LEN);
+    blcksArr += BLOCK_LEN;
+
+    // Get 16-bit CRC. Don't need.
+    sd_ReceiveByteSPI();
+    sd_ReceiveByteSPI();
+  }
+  spi_Park(SPI_DEV_SD);
+  return READ_SUCCESS;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                             STOP READ STREAM
+ * 
+ * Description : Ends an open read stream and de-asserts the SD card's CS.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : void
+ * 
+ * Notes       : Does nothing if no stream is open. 
+ * ----------------------------------------------------------------------------
+ */
+void sd_StopReadStream(void)
+{
+  if (!readStreamOpen)
+    return;
+
+  // the stream may have been parked, so select the card again.
+  CS_SD_LOW;
+
+  // 
+  // stop the card sending data blocks. The byte following the command is a
+  // stuff byte, followed by the R1b response. Then wait while card is busy.
+  //
+  sd_SendCommand(STOP_TRANSMISSION, 0);
+  sd_ReceiveByteSPI();
+  sd_GetR1();
+  for (uint32_t timeout = 0; sd_ReceiveByteSPI() != DMY_TKN; ++timeout)
+    if (timeout >= SD_READ_TIMEOUT_BYTES)
+      break;
+
+  CS_SD_HIGH;
+  readStreamOpen = 0;
+}
+
+/*
+ * ----------------------------------------------------------------------------
+ *                                                          IS READ STREAM OPEN
+ * 
+ * Description : Returns 1 if a read stream is open, else 0.
+ * 
+ * Arguments   : void
+ * 
+ * Returns     : 1 or 0
+ * ----------------------------------------------------------------------------
+ */
+uint8_t sd_IsReadStreamOpen(void)
+{
+  return readStreamOpen;
+}
+
 /*
  * ----------------------------------------------------------------------------
  *                                                           PRINT SINGLE BLOCK
@@ -111,22 +293,22 @@ void sd_PrintSingleBlock(const uint8_t blckArr[])
   const uint8_t radix = 16;                 // hex
 
   // print column headings with spaces added for formatting
-  print_Str("\n\n\r "
-            "BLOCK OFFSET                       "
-            "HEX DATA                             "
-            "ASCII DATA\n\r");
+  print_StrP(PSTR("\n\n\r "
+                  "BLOCK OFFSET                       "
+                  "HEX DATA                             "
+                  "ASCII DATA\n\r"));
 
   // print constents in the data block array
   for (uint16_t row = 0, offset = 0; row < BLOCK_LEN / radix; ++row)
   {
     // Print row address offset. Loop is used to print any needed prefixed 0's
-    print_Str("\n\r     0x");
+    print_StrP(PSTR("\n\r     0x"));
     for (uint16_t os = offset + 1; os < 0x100; os *= radix)
       usart_Transmit('0');
     print_Hex(offset);
 
     // print HEX values of the block's offset row
-    print_Str("   ");
+    print_StrP(PSTR("   "));
     for (offset = row * radix; offset < row * radix + radix; ++offset)
     {
       // every 4 bytes print an extra space.
@@ -148,7 +330,7 @@ void sd_PrintSingleBlock(const uint8_t blckArr[])
     // is printed. If an ascii values greater than the highest printable value
     // is encountered then a period ('.') is printed. 
     //
-    print_Str("     ");
+    print_StrP(PSTR("     "));
     for (offset = row * radix; offset < row * radix + radix; ++offset)
     {
       if (blckArr[offset] < ASCII_PRINT_CHAR_FIRST)    
@@ -181,6 +363,8 @@ uint16_t sd_WriteSingleBlock(uint32_t blckAddr, const uint8_t dataArr[])
   uint8_t  r1;                              // for R1 response
   uint8_t  dataRespTkn = 0;
 
+  sd_StopReadStream();
+
   // send the Write Single Block command to write data to blckAddr on SD card.
   CS_SD_LOW;    
   sd_SendCommand (WRITE_BLOCK, blckAddr);
@@ -194,8 +378,7 @@ uint16_t sd_WriteSingleBlock(uint32_t blckAddr, const uint8_t dataArr[])
   sd_SendByteSPI(START_BLOCK_TKN); 
 
   // send data to write to SD card.
-  for (uint16_t pos = 0; pos < BLOCK_LEN; ++pos) 
-    sd_SendByteSPI (dataArr[pos]);
+  sd_SendBlockSPI(dataArr, BLOCK_LEN);
 
   // Send 16-bit CRC. CRC should be off (default), so these do not matter.
   sd_SendByteSPI(DMY_TKN);
@@ -223,8 +406,8 @@ uint16_t sd_WriteSingleBlock(uint32_t blckAddr, const uint8_t dataArr[])
   //
   if (dataRespTkn == DATA_ACCEPTED_TKN)
   { 
-    for (uint16_t timeout = 0; sd_ReceiveByteSPI() == 0; ++timeout)
-      if (timeout > 4 * TIMEOUT_LIMIT)      // increased timeout limit
+    for (uint32_t timeout = 0; sd_ReceiveByteSPI() == 0; ++timeout)
+      if (timeout >= SD_WRITE_TIMEOUT_BYTES)
       {
         CS_SD_HIGH;
         return (CARD_BUSY_TIMEOUT | r1);
@@ -264,6 +447,8 @@ uint16_t sd_EraseBlocks(uint32_t startBlckAddr, uint32_t endBlckAddr)
 {
   uint8_t r1;                               // for R1 responses
   
+  sd_StopReadStream();
+
   // set Start Address for erase block
   CS_SD_LOW;
   sd_SendCommand(ERASE_WR_BLK_START_ADDR, startBlckAddr);
@@ -323,16 +508,19 @@ void sd_PrintReadError(uint16_t err)
   switch (err & 0xFF00)
   {
     case R1_ERROR:
-      print_Str("\n\r R1_ERROR");
+      print_StrP(PSTR("\n\r R1_ERROR"));
       break;
     case READ_SUCCESS:
-      print_Str("\n\r READ_SUCCESS");
+      print_StrP(PSTR("\n\r READ_SUCCESS"));
       break;
     case START_TOKEN_TIMEOUT:
-      print_Str("\n\r START_TOKEN_TIMEOUT");
+      print_StrP(PSTR("\n\r START_TOKEN_TIMEOUT"));
+      break;
+    case READ_STREAM_CLOSED:
+      print_StrP(PSTR("\n\r READ_STREAM_CLOSED"));
       break;
     default:
-      print_Str("\n\r UNKNOWN RESPONSE");
+      print_StrP(PSTR("\n\r UNKNOWN RESPONSE"));
   }
 }
 
@@ -353,28 +541,28 @@ void sd_PrintWriteError(uint16_t err)
   switch(err & 0xFF00)
   {
     case DATA_WRITE_SUCCESS:
-      print_Str("\n\r DATA_WRITE_SUCCESS");
+      print_StrP(PSTR("\n\r DATA_WRITE_SUCCESS"));
       break;
     case CRC_ERROR_TKN_RECEIVED:
-      print_Str("\n\r CRC_ERROR_TKN_RECEIVED");
+      print_StrP(PSTR("\n\r CRC_ERROR_TKN_RECEIVED"));
       break;
     case WRITE_ERROR_TKN_RECEIVED:
-      print_Str("\n\r WRITE_ERROR_TKN_RECEIVED");
+      print_StrP(PSTR("\n\r WRITE_ERROR_TKN_RECEIVED"));
       break;
     case INVALID_DATA_RESPONSE:
-      print_Str("\n\r INVALID_DATA_RESPONSE");
+      print_StrP(PSTR("\n\r INVALID_DATA_RESPONSE"));
       break;
     case DATA_RESPONSE_TIMEOUT:
-      print_Str("\n\r DATA_RESPONSE_TIMEOUT");
+      print_StrP(PSTR("\n\r DATA_RESPONSE_TIMEOUT"));
       break;
     case CARD_BUSY_TIMEOUT:
-      print_Str("\n\r CARD_BUSY_TIMEOUT");
+      print_StrP(PSTR("\n\r CARD_BUSY_TIMEOUT"));
       break;
     case R1_ERROR:
-      print_Str("\n\r R1_ERROR");
+      print_StrP(PSTR("\n\r R1_ERROR"));
       break;
     default:
-      print_Str("\n\r UNKNOWN RESPONSE");
+      print_StrP(PSTR("\n\r UNKNOWN RESPONSE"));
   }
 }
 
@@ -395,21 +583,21 @@ void sd_PrintEraseError(uint16_t err)
   switch(err & 0xFF00)
   {
     case ERASE_SUCCESSFUL:
-      print_Str("\n\r ERASE_SUCCESSFUL");
+      print_StrP(PSTR("\n\r ERASE_SUCCESSFUL"));
       break;
     case SET_ERASE_START_ADDR_ERROR:
-      print_Str("\n\r SET_ERASE_START_ADDR_ERROR");
+      print_StrP(PSTR("\n\r SET_ERASE_START_ADDR_ERROR"));
       break;
     case SET_ERASE_END_ADDR_ERROR:
-      print_Str("\n\r SET_ERASE_END_ADDR_ERROR");
+      print_StrP(PSTR("\n\r SET_ERASE_END_ADDR_ERROR"));
       break;
     case ERASE_ERROR:
-      print_Str("\n\r ERROR_ERASE");
+      print_StrP(PSTR("\n\r ERROR_ERASE"));
       break;
     case ERASE_BUSY_TIMEOUT:
-      print_Str("\n\r ERASE_BUSY_TIMEOUT");
+      print_StrP(PSTR("\n\r ERASE_BUSY_TIMEOUT"));
       break;
     default:
-      print_Str("\n\r UNKNOWN RESPONSE");
+      print_StrP(PSTR("\n\r UNKNOWN RESPONSE"));
   }
 }
@@ -18,19 +18,54 @@
  * not considered part of the AVR-FAT module.
  *
  * COMMANDS:
- *  (1) cd <DIR>      : Change directory to the directory specified by <DIR>.
+ *  (1) cd <PATH>     : Change directory to the directory specified by <PATH>.
  *  (2) ls <FIELDS>   : List directory contents based on specified <FILTERs>.
  *  (3) open <FILE>   : Print contents of <FILE> to a screen.
  *  (4) pwd           : Print the current working directory to screen.
+ *  (5) stats         : Print the number of sectors read, SPI bytes per
+ *                      sector, sector and path cache hits/misses and the SD
+ *                      command latency counters since the last 'stats', 
+ *                      then reset counters.
+ *  (6) bench         : Read the first cluster of the cwd with single block
+ *                      reads and then with multiple block reads, and print
+ *                      the throughput of each in KB/s at each SPI clock 
+ *                      divisor from 64 down to 2.
+ *  (7) wait          : Switch the SD command wait mode between ready-polling
+ *                      and the fixed delay.
+ *  (8) fmtbench      : Print the CPU cycles taken to format the numbers of 
+ *                      one 'ls /A' line by dividing, as print_Dec used to, 
+ *                      and by print_BufDec.
+ *  (9) cdbench <DIR> : Look up <DIR> in the cwd by decoding the name of every
+ *                      entry, as 'cd' used to, and then by fat_SetDir, and
+ *                      print the entries scanned per second by each. A 
+ *                      name that does not exist times a scan of the whole
+ *                      directory. The cwd is not changed.
+ * (10) idxbench <NAME>: Look up <NAME> in the cwd by a scan of the directory,
+ *                      then time building the name index of the cwd, and 
+ *                      the lookup with it, and print the time each took in
+ *                      us.
+ * (11) lsort         : List the names of the non-hidden entries in the cwd in
+ *                      name order. Directory names end in '/'.
+ * (12) sortbench     : Time the sorted listing of the cwd, and print the ms
+ *                      taken to find the first SORT_PAGE_LEN entries and all
+ *                      of them, and the number of passes over the cwd.
+ * (13) ent <N>       : Print the name of the cwd's non-hidden entry number N,
+ *                      counting from 0, and the us taken to find it. Entries
+ *                      are found from checkpoints kept for the cwd, so e.g.
+ *                      'ent 500' then 'ent 499' only steps back one entry.
+ * (14) index         : Index the names of the cwd, so that 'cd' and 'open'
+ *                      find its entries by reading only their sectors. Only
+ *                      the last directory indexed is. Run it again after
+ *                      changing the directory on another device.
  * 
  * NOTES: 
  * (1)  The module only has READ capabilities.
  * (2)  Quotation marks should NOT surround file or directory names even if 
  *      a space exists in the name.
  * (3)  Directory and file name arguments are case sensitive.
- * (4)  'cd' cmd can be used to reset cwd (current working directory) to point
- *      to the ROOT directory or change it to a CHILD or the PARENT of the 
- *      current directory pointed at by cwd.
+ * (4)  'cd' cmd can be used to set cwd (current working directory) to any
+ *      directory by an absolute path, e.g. /Artist/Album, or a path relative
+ *      to cwd, e.g. ../Album. Names in a path are separated by '/'.
  * (5)  'open' will only work for files that are in the cwd directory. 
  * (6)  Pass ".." (without quotes) as the argument to 'cd' to point cwd to
  *      its parent directory.
@@ -56,6 +91,8 @@
 
 #include <string.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <avr/interrupt.h>
 #include "usart0.h"
 #include "spi.h"
 #include "prints.h"
@@ -64,12 +101,71 @@
 #include "fat_bpb.h"
 #include "fat.h"
 #include "fat_to_disk_if.h"
+#include "fat_to_sd.h"
+#include "fat_cache.h"
+#include "fat_path.h"
+#include "fat_index.h"
+#include "fat_sort.h"
+#include "fat_ckpt.h"
 
 #define SD_CARD_INIT_ATTEMPTS_MAX      5  
-#define CMD_LINE_MAX_CHAR              100  // max num of chars of a cmd/arg
+#define CMD_LINE_MAX_CHAR              USART_LINE_MAX_CHAR  // max cmd/arg chars
 #define MAX_ARG_CNT                    10   // max num of CL arguments
 #define BACKSPACE                      127  // used for keyboard backspace here
 
+// used by the 'bench' command. Timer 1 at clk/64 ticks every 4 us at 16 MHz.
+#define BENCH_BUF_SECS                 4    // max sectors per multi-block read
+#define BENCH_REPS                     8    // times the cluster is read
+#define BENCH_TICKS_PER_SEC            (F_CPU / 64)
+
+// SD card SPI clock divisors used by the 'bench' command, and their values.
+static const uint8_t  benchClkDiv[] = {SPI_CLK_DIV_64, SPI_CLK_DIV_32, 
+                                       SPI_CLK_DIV_16, SPI_CLK_DIV_8,
+                                       SPI_CLK_DIV_4,  SPI_CLK_DIV_2};
+static const uint8_t  benchClkDivVal[] = {64, 32, 16, 8, 4, 2};
+
+// used by the 'cdbench' command. Timer 1 at clk/1024 ticks every 64 us.
+#define CDBENCH_TICKS_PER_SEC          (F_CPU / 1024)
+
+// 
+// name index used by fat_FindEntry, and so by 'cd' and 'open', once 'index'
+// has built it for a directory. Each element is 4 bytes. Directories with 
+// more entries are partly indexed.
+//
+#define NAME_INDEX_ENTS                256
+static FatIndexEnt nameIndexEnts[NAME_INDEX_ENTS];
+static FatNameIndex nameIndex;
+
+//
+// keys used by 'lsort' and 'sortbench'. Each pass over the cwd finds the next
+// SORT_KEYS names, so a larger array takes fewer passes. Each key is
+// FAT_SORT_KEY_LEN + 2 bytes.
+//
+#define SORT_KEYS                      16
+#define SORT_PAGE_LEN                  4    // entries per screen of the LCD
+static FatSortKey sortKeys[SORT_KEYS];
+
+//
+// checkpoints used by 'ent'. One is kept every CKPT_INTERVAL entries of the
+// cwd, so up to CKPTS * CKPT_INTERVAL entries before the interval is doubled.
+// Each is 6 bytes.
+//
+#define CKPTS                          64
+#define CKPT_INTERVAL                  8
+static FatCkpt ckpts[CKPTS];
+
+static void benchClusterRead(const FatDir *dir, const BPB *bpb);
+static void benchFormat(void);
+static void benchSetDir(const FatDir *dir, const char dirStr[], 
+                        const BPB *bpb);
+static void benchIndex(const FatDir *dir, const char nameStr[], 
+                       const BPB *bpb);
+static void listSorted(const FatDir *dir, const BPB *bpb);
+static void benchSort(const FatDir *dir, const BPB *bpb);
+static void printEntryNum(const FatDir *dir, const char numStr[], 
+                          const BPB *bpb);
+static void printCmdStats(void);
+
 //
 // setting this to 1 enables the SD Card Raw Data block read and prints section
 // at the end of the test file as well as the necessary local functions and
@@ -86,9 +182,10 @@ static uint32_t enterBlockNumber();
 
 int main(void)
 {
-  // Initializat usart and spi ports.
+  // Initializat usart and spi ports. Usart transmits from an interrupt.
   usart_Init();
   spi_MasterInit();
+  sei();
 
   //
   // SD card initialization
@@ -99,21 +196,21 @@ int main(void)
   // Loop will continue until SD card init succeeds or max attempts reached.
   for (uint8_t att = 0; att < SD_CARD_INIT_ATTEMPTS_MAX; ++att)
   {
-    print_Str("\n\n\r >> SD Card Initialization Attempt "); 
+    print_StrP(PSTR("\n\n\r >> SD Card Initialization Attempt ")); 
     print_Dec(att);
     sdInitResp = sd_InitModeSPI(&ctv);      // init SD Card
 
     if (sdInitResp != OUT_OF_IDLE)          // Fail to init if not OUT_OF_IDLE
     {    
-      print_Str(": FAILED TO INITIALIZE SD CARD."
-                " Initialization Error Response: "); 
+      print_StrP(PSTR(": FAILED TO INITIALIZE SD CARD."
+                      " Initialization Error Response: ")); 
       sd_PrintInitError(sdInitResp);
-      print_Str(" R1 Response: "); 
+      print_StrP(PSTR(" R1 Response: ")); 
       sd_PrintR1(sdInitResp);
     }
     else
     {   
-      print_Str(": SD CARD INITIALIZATION SUCCESSFUL");
+      print_StrP(PSTR(": SD CARD INITIALIZATION SUCCESSFUL"));
       break;
     }
   }
@@ -125,6 +222,13 @@ int main(void)
   {          
     uint8_t err;                            // for returned errors
     uint8_t quitCL = 0;                     // flag used to exit cmd line  
+
+    // set the card descriptor used by the FATtoDisk functions.
+    FATtoSD_Mount(&ctv);
+    fat_CacheInvalidate();
+    fat_PathCacheInvalidate();
+    fat_IndexInit(&nameIndex, nameIndexEnts, NAME_INDEX_ENTS);
+
     //
     // Create and set Bios Parameter Block instance. Members of this instance
     // are used to calculate where on the disk, the FAT sectors are located. 
@@ -134,7 +238,7 @@ int main(void)
     err = fat_SetBPB(&bpb);
     if (err != BPB_VALID)
     {
-      print_Str("\n\r fat_SetBPB() returned ");
+      print_StrP(PSTR("\n\r fat_SetBPB() returned "));
       fat_PrintErrorBPB(err);
     }
 
@@ -147,81 +251,56 @@ int main(void)
     FatDir cwd;
     fat_SetDirToRoot(&cwd, &bpb);
 
-    print_Str("\n\n\n\r");
+    print_StrP(PSTR("\n\n\n\r"));
     do
     {
-      char inputChar;                       // for input chars of cmd/arg
-      char inputStr[CMD_LINE_MAX_CHAR];     // hold cmd/arg str
-      char cmdStr[CMD_LINE_MAX_CHAR];       // separate cmd from inputStr
-      char argStr[CMD_LINE_MAX_CHAR];       // separate arg from inputStr
-      uint8_t charCnt = 0;                  // number of chars in inputStr
+      static UsartLine line;                // cmd/arg line being typed
+      char cmdStr[CMD_LINE_MAX_CHAR];       // separate cmd from line
+      char argStr[CMD_LINE_MAX_CHAR];       // separate arg from line
+      uint8_t lineStat;                     // returned by usart_PollLine
       uint8_t fieldFlags = 0;               // fields printed with 'ls' cmd
 
       // print cmd prompt to screen with cwd
-      print_Str("\n\r");
+      print_StrP(PSTR("\n\r"));
       print_Str(cwd.lnStr);
-      print_Str(" > ");
+      print_StrP(PSTR(" > "));
 
       // 
-      // get (from user) and parse command and arguments
+      // get (from user) and parse command and arguments. Chars are received
+      // and queued by the USART interrupt, and usart_PollLine handles echo
+      // and backspace, so nothing typed is lost while a command runs.
       //
-      inputChar = usart_Receive();
-      while (inputChar != '\r')
-      {
-        //
-        // Handles backspace \ delete chars. BACKSPACE macro above is set to 
-        // the value of the backspace key on my keyboard, which is ascii 'del'
-        // (127). Ascii backspace is 8 ('\b'). To behave as expected when 
-        // backspace is pressed, i.e. delete previous char, this section prints
-        // backspace ('\b'), space (' '), backspace ('\b').
-        // 
-        if (inputChar == BACKSPACE)         // if backspace entered  
-        {
-          print_Str ("\b \b");              // perform backspace 'delete' op.
-          if (charCnt > 0)                  // reduce char count if > 0
-            --charCnt;
-        }
-        else                                // non-backspace, print last char entered
-        { 
-          usart_Transmit(inputChar);        // print char
-          inputStr[charCnt] = inputChar;    // load char into array
-          ++charCnt;                        // increase char count
-        }
-      
-        // get next char
-        inputChar = usart_Receive();
-        if (charCnt >= CMD_LINE_MAX_CHAR) 
-          break;
-      }
-      inputStr[charCnt] = '\0';
+      do
+        lineStat = usart_PollLine(&line);
+      while (lineStat == USART_LINE_NONE);
 
       // split command and arguments into separate strings
-      char *splitPtr = strchr(inputStr, ' ');
+      char *splitPtr = strchr(line.str, ' ');
       if (splitPtr != NULL)
       {
         *splitPtr = '\0';
         strcpy(argStr, ++splitPtr);
       }
-      strcpy(cmdStr, inputStr);
+      strcpy(cmdStr, line.str);
  
       //
       // Execute Command
       //
-      if (charCnt < CMD_LINE_MAX_CHAR) 
+      if (lineStat == USART_LINE_READY) 
       {
         //
         // Command: "cd" (change directory)
         //
-        if (!strcmp(cmdStr, "cd"))
+        if (!strcmp_P(cmdStr, PSTR("cd")))
         {   
-          err = fat_SetDir(&cwd, argStr, &bpb);
+          err = fat_ResolvePath(&cwd, argStr, &bpb);
           if (err != SUCCESS) 
             fat_PrintError (err);
         }
         //
         // Command: "ls" (list dir contents)
         //
-        else if (!strcmp(cmdStr, "ls"))
+        else if (!strcmp_P(cmdStr, PSTR("ls")))
         {
           for (uint8_t argCnt = 0, lastArgFlag = 0; 
                argCnt < MAX_ARG_CNT || !lastArgFlag; ++argCnt)
@@ -233,23 +312,23 @@ int main(void)
               *argStrPtr = '\0';             // null-term for substring args.
             
             // set flags to print fields according to the arguments specified
-            if (strcmp (argStr, "/LN") == 0) 
+            if (strcmp_P (argStr, PSTR("/LN")) == 0) 
               fieldFlags |= LONG_NAME;
-            else if (strcmp (argStr, "/SN") == 0) 
+            else if (strcmp_P (argStr, PSTR("/SN")) == 0) 
                   fieldFlags |= SHORT_NAME;
-            else if (strcmp (argStr, "/A" ) == 0) 
+            else if (strcmp_P (argStr, PSTR("/A")) == 0) 
                   fieldFlags |= ALL;
-            else if (strcmp (argStr, "/H" ) == 0) 
+            else if (strcmp_P (argStr, PSTR("/H")) == 0) 
                   fieldFlags |= HIDDEN;
-            else if (strcmp (argStr, "/C" ) == 0) 
+            else if (strcmp_P (argStr, PSTR("/C")) == 0) 
                   fieldFlags |= CREATION;
-            else if (strcmp (argStr, "/LA") == 0) 
+            else if (strcmp_P (argStr, PSTR("/LA")) == 0) 
                   fieldFlags |= LAST_ACCESS;
-            else if (strcmp (argStr, "/LM") == 0) 
+            else if (strcmp_P (argStr, PSTR("/LM")) == 0) 
                   fieldFlags |= LAST_MODIFIED;
-            else if (strcmp (argStr, "/FS") == 0) 
+            else if (strcmp_P (argStr, PSTR("/FS")) == 0) 
                   fieldFlags |= FILE_SIZE;
-            else if (strcmp (argStr, "/T" ) == 0) 
+            else if (strcmp_P (argStr, PSTR("/T")) == 0) 
                   fieldFlags |= TYPE;
             
             strcpy(argStr, ++argStrPtr);    // start argStr at next arg 
@@ -260,19 +339,19 @@ int main(void)
             fieldFlags |= LONG_NAME;
           
           // Print column headings
-          print_Str("\n\n\r");
+          print_StrP(PSTR("\n\n\r"));
           if (CREATION & fieldFlags) 
-            print_Str(" CREATION DATE & TIME,");
+            print_StrP(PSTR(" CREATION DATE & TIME,"));
           if (LAST_ACCESS & fieldFlags) 
-            print_Str(" LAST ACCESS DATE,");
+            print_StrP(PSTR(" LAST ACCESS DATE,"));
           if (LAST_MODIFIED & fieldFlags) 
-            print_Str(" LAST MODIFIED DATE & TIME,");
+            print_StrP(PSTR(" LAST MODIFIED DATE & TIME,"));
           if (FILE_SIZE & fieldFlags) 
-            print_Str(" SIZE (Bytes),");
+            print_StrP(PSTR(" SIZE (Bytes),"));
           if (TYPE & fieldFlags) 
-            print_Str(" TYPE,");
-          print_Str(" NAME");
-          print_Str("\n\r");
+            print_StrP(PSTR(" TYPE,"));
+          print_StrP(PSTR(" NAME"));
+          print_StrP(PSTR("\n\r"));
 
           err = fat_PrintDir(&cwd, fieldFlags, &bpb);
           if (err != END_OF_DIRECTORY) 
@@ -282,7 +361,7 @@ int main(void)
         //
         // Command: "open" (print file to screen)
         //
-        else if (!strcmp(cmdStr, "open")) 
+        else if (!strcmp_P(cmdStr, PSTR("open"))) 
         { 
           err = fat_PrintFile(&cwd, argStr, &bpb);
           if (err != END_OF_FILE) 
@@ -292,19 +371,134 @@ int main(void)
         //
         // Command: "pwd" (print working directory)
         //
-        else if (!strcmp(cmdStr, "pwd"))
+        else if (!strcmp_P(cmdStr, PSTR("pwd")))
         {
-          print_Str("\n\r");
+          print_StrP(PSTR("\n\r"));
           print_Str (cwd.lnPathStr);
           print_Str (cwd.lnStr);
         }
 
+        //
+        // Command: "stats" (print and reset disk access counters)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("stats")))
+        {
+          FATtoSDStats st;
+          FATtoSD_GetStats(&st);
+          print_StrP(PSTR("\n\rsectors read: "));
+          print_Dec(st.secReads);
+          print_StrP(PSTR("\n\rread commands: "));
+          print_Dec(st.readCmds);
+          print_StrP(PSTR("\n\rSPI bytes: "));
+          print_Dec(st.spiBytes);
+          if (st.secReads)
+          {
+            print_StrP(PSTR("\n\rSPI bytes per sector: "));
+            print_Dec(st.spiBytes / st.secReads);
+          }
+          FatCacheStats cst;
+          fat_CacheGetStats(&cst);
+          print_StrP(PSTR("\n\rcache hits: "));
+          print_Dec(cst.hits);
+          print_StrP(PSTR("\n\rcache misses: "));
+          print_Dec(cst.misses);
+          FatPathCacheStats pst;
+          fat_PathCacheGetStats(&pst);
+          print_StrP(PSTR("\n\rpath cache hits: "));
+          print_Dec(pst.hits);
+          print_StrP(PSTR("\n\rpath cache misses: "));
+          print_Dec(pst.misses);
+          printCmdStats();
+          FATtoSD_ResetStats();
+          fat_CacheResetStats();
+          fat_PathCacheResetStats();
+          sd_ResetCmdStats();
+        }
+
+        //
+        // Command: "wait" (toggle SD command wait mode)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("wait")))
+        {
+          if (sd_GetCmdWaitMode() == SD_WAIT_READY)
+          {
+            sd_SetCmdWaitMode(SD_WAIT_DELAY);
+            print_StrP(PSTR("\n\rSD command wait: delay"));
+          }
+          else
+          {
+            sd_SetCmdWaitMode(SD_WAIT_READY);
+            print_StrP(PSTR("\n\rSD command wait: ready"));
+          }
+        }
+
+        //
+        // Command: "bench" (single vs multiple block read throughput)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("bench")))
+        {
+          for (uint8_t i = 0; i < sizeof(benchClkDiv); ++i)
+          {
+            print_StrP(PSTR("\n\n\rSPI clock: F_CPU / "));
+            print_Dec(benchClkDivVal[i]);
+            spi_SetProfile(SPI_DEV_SD, SPI_MODE_0, benchClkDiv[i]);
+            benchClusterRead(&cwd, &bpb);
+          }
+          spi_SetProfile(SPI_DEV_SD, SPI_MODE_0, SD_CLK_DIV);
+        }
+
+        //
+        // Command: "fmtbench" (cycles to format an 'ls /A' line's numbers)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("fmtbench")))
+          benchFormat();
+
+        //
+        // Command: "cdbench" (entries per second scanned by a 'cd' lookup)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("cdbench")))
+          benchSetDir(&cwd, argStr, &bpb);
+
+        //
+        // Command: "idxbench" (time to find a name with and without index)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("idxbench")))
+          benchIndex(&cwd, argStr, &bpb);
+
+        //
+        // Command: "lsort" (list the cwd in name order)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("lsort")))
+          listSorted(&cwd, &bpb);
+
+        //
+        // Command: "sortbench" (time to list the cwd in name order)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("sortbench")))
+          benchSort(&cwd, &bpb);
+
+        //
+        // Command: "ent" (print the name of an entry by its number)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("ent")))
+          printEntryNum(&cwd, argStr, &bpb);
+
+        //
+        // Command: "index" (index the names of the cwd)
+        //
+        else if (!strcmp_P(cmdStr, PSTR("index")))
+        {
+          err = fat_IndexBuild(&cwd, &bpb);
+          if (err != SUCCESS) 
+            fat_PrintError (err);
+        }
+
         //
         // Command: "q" (exit cmd-line)
         //
         else if (cmdStr[0] == 'q') 
         { 
-          print_Str ("\n\rquit\n\r"); 
+          print_StrP (PSTR("\n\rquit\n\r")); 
           quitCL = 1; 
         }
         
@@ -312,13 +506,11 @@ int main(void)
         // Invalid Command
         //
         else
-          print_Str ("\n\rInvalid command\n\r");
+          print_StrP (PSTR("\n\rInvalid command\n\r"));
       }
-      print_Str ("\n\r");
-
-      // ensure USART0 Data Register, URD0, is cleared.
-      for (int k = 0; k < 10; k++) 
-        UDR0; 
+      else
+        print_StrP (PSTR("\n\rCommand too long\n\r"));
+      print_StrP (PSTR("\n\r"));
     }
     while (!quitCL);
     // END of COMMAND-LINE TEST                
@@ -340,25 +532,25 @@ int main(void)
 
       do
       {
-        print_Str("\n\n\n\rEnter Start Block\n\r");
+        print_StrP(PSTR("\n\n\n\rEnter Start Block\n\r"));
         startBlck = enterBlockNumber();
-        print_Str("\n\rHow many blocks do you want to print?\n\r");
+        print_StrP(PSTR("\n\rHow many blocks do you want to print?\n\r"));
         numOfBlcks = enterBlockNumber();
-        print_Str("\n\rYou have selected to print "); 
+        print_StrP(PSTR("\n\rYou have selected to print ")); 
         print_Dec(numOfBlcks);
-        print_Str(" blocks beginning at block number "); 
+        print_StrP(PSTR(" blocks beginning at block number ")); 
         print_Dec(startBlck);
-        print_Str("\n\rIs this correct? (y/n)");
+        print_StrP(PSTR("\n\rIs this correct? (y/n)"));
         answer = usart_Receive();
         usart_Transmit(answer);
-        print_Str("\n\r");
+        print_StrP(PSTR("\n\r"));
       }
       while (answer != 'y');
 
       // Print blocks
       for (uint32_t blck = startBlck; blck < startBlck + numOfBlcks; ++blck)
       {
-        print_Str("\n\rBLOCK: ");
+        print_StrP(PSTR("\n\rBLOCK: "));
         print_Dec(blck);
         if (ctv.type == SDHC)               // SDHC is block addressable
           sdErr = sd_ReadSingleBlock(blck, blckArr);
@@ -367,21 +559,21 @@ int main(void)
         
         if (sdErr != READ_SUCCESS)
         { 
-          print_Str("\n\r >> sd_ReadSingleBlock returned ");
+          print_StrP(PSTR("\n\r >> sd_ReadSingleBlock returned "));
           if (sdErr & R1_ERROR)
           {
-            print_Str("R1 error: ");
+            print_StrP(PSTR("R1 error: "));
             sd_PrintR1(sdErr);
           }
           else 
           { 
-            print_Str(" error "); 
+            print_StrP(PSTR(" error ")); 
             sd_PrintReadError(sdErr);
           }
         }
         sd_PrintSingleBlock(blckArr);
       }
-      print_Str("\n\rPress 'q' to quit: ");
+      print_StrP(PSTR("\n\rPress 'q' to quit: "));
       answer = usart_Receive();
       usart_Transmit(answer);
     }
@@ -405,6 +597,378 @@ int main(void)
  ******************************************************************************
  */
 
+//
+// local function used by the 'bench' command. Reads the first cluster of dir
+// BENCH_REPS times with FATtoDisk_ReadSingleSector, then BENCH_REPS times 
+// with FATtoDisk_ReadSectors in runs of up to BENCH_BUF_SECS sectors, timing
+// each read with Timer 1 and printing the throughput of each in KB/s.
+//
+static void benchClusterRead(const FatDir *dir, const BPB *bpb)
+{
+  static uint8_t benchBuf[BENCH_BUF_SECS * SECTOR_LEN];
+  uint32_t fstSec = bpb->dataRegionFirstSector 
+                  + (dir->fstClusIndx - bpb->rootClus) * bpb->secPerClus;
+  uint32_t ticks[2] = {0, 0};               // [0] single, [1] multiple
+  uint8_t  err = READ_SECTOR_SUCCESS;
+
+  // Timer 1 normal mode, clk/64.
+  TCCR1A = 0;
+  TCCR1B = 1 << CS11 | 1 << CS10;
+
+  for (uint8_t rep = 0; rep < BENCH_REPS; ++rep)
+  {
+    for (uint8_t sec = 0; sec < bpb->secPerClus; ++sec)
+    {
+      TCNT1 = 0;
+      err |= FATtoDisk_ReadSingleSector(fstSec + sec, benchBuf);
+      ticks[0] += TCNT1;
+    }
+    for (uint8_t sec = 0; sec < bpb->secPerClus; sec += BENCH_BUF_SECS)
+    {
+      uint8_t cnt = bpb->secPerClus - sec;
+      if (cnt > BENCH_BUF_SECS)
+        cnt = BENCH_BUF_SECS;
+      TCNT1 = 0;
+      err |= FATtoDisk_ReadSectors(fstSec + sec, cnt, benchBuf);
+      ticks[1] += TCNT1;
+    }
+
+    // the stream is left open by FATtoDisk_ReadSectors. Time its stop too.
+    TCNT1 = 0;
+    sd_StopReadStream();
+    ticks[1] += TCNT1;
+  }
+  TCCR1B = 0;
+
+  if (err != READ_SECTOR_SUCCESS)
+  {
+    print_StrP(PSTR("\n\rbench: read failed"));
+    return;
+  }
+
+  // KB read by each method, then KB/s = KB * ticks per sec / ticks.
+  uint32_t kb = (uint32_t)BENCH_REPS * bpb->secPerClus * SECTOR_LEN / 1024;
+  print_StrP(PSTR("\n\rcluster sectors: "));
+  print_Dec(bpb->secPerClus);
+  print_StrP(PSTR("\n\rsingle block KB/s: "));
+  print_Dec(ticks[0] ? kb * BENCH_TICKS_PER_SEC / ticks[0] : 0);
+  print_StrP(PSTR("\n\rmultiple block KB/s: "));
+  print_Dec(ticks[1] ? kb * BENCH_TICKS_PER_SEC / ticks[1] : 0);
+}
+
+//
+// local functions used by the 'fmtbench' command. The numbers of an 'ls /A'
+// line, i.e. month, day, year, hour, min, sec of the creation and modified 
+// times, month, day, year of the access date, and the file size, are 
+// formatted into a PrintBuf BENCH_REPS times, first by divide and modulo as
+// print_Dec used to do, then by print_BufDec. Timer 1 runs at clk/1, so its
+// ticks are CPU cycles. The average cycles per line are printed for each.
+//
+static void divBufDec(PrintBuf *buf, uint32_t num, uint8_t width, char pad)
+{
+  char    digit[10];
+  uint8_t digitCnt = 0;
+
+  do
+  {
+    digit[digitCnt++] = num % 10 + '0';
+    num /= 10;
+  }
+  while (num > 0);
+
+  for (; width > digitCnt; --width)
+    print_BufChar(buf, pad);
+  while (digitCnt > 0)
+    print_BufChar(buf, digit[--digitCnt]);
+}
+
+static void benchFormat(void)
+{
+  static const uint32_t lineNums[] = {12, 31, 2021, 23, 59, 58, 12, 31, 2021,
+                                      12, 31, 2021, 23, 59, 58, 4294967};
+  static const uint8_t  lineWidths[] = {2, 2, 0, 2, 2, 2, 2, 2, 0, 
+                                        2, 2, 0, 2, 2, 2, 10};
+  PrintBuf buf;
+  uint32_t cycles[2] = {0, 0};              // [0] divide, [1] print_BufDec
+
+  // Timer 1 normal mode, clk/1.
+  TCCR1A = 0;
+  TCCR1B = 1 << CS10;
+
+  for (uint8_t rep = 0; rep < BENCH_REPS; ++rep)
+  {
+    print_BufInit(&buf);
+    TCNT1 = 0;
+    for (uint8_t n = 0; n < sizeof(lineWidths); ++n)
+      divBufDec(&buf, lineNums[n], lineWidths[n], '0');
+    cycles[0] += TCNT1;
+
+    print_BufInit(&buf);
+    TCNT1 = 0;
+    for (uint8_t n = 0; n < sizeof(lineWidths); ++n)
+      print_BufDec(&buf, lineNums[n], lineWidths[n], '0');
+    cycles[1] += TCNT1;
+  }
+  TCCR1B = 0;
+
+  print_StrP(PSTR("\n\rcycles per line, divide: "));
+  print_Dec(cycles[0] / BENCH_REPS);
+  print_StrP(PSTR("\n\rcycles per line, print_BufDec: "));
+  print_Dec(cycles[1] / BENCH_REPS);
+}
+
+//
+// local function used by the 'cdbench' command. Searches dir for a directory
+// named dirStr, first by setting a FatEntry to each entry, which decodes 
+// every name, then by fat_SetDir, which skips entries that are not 
+// directories before decoding their names. The sector cache is emptied 
+// before each so both read the directory from the card. Timer 1 runs at 
+// clk/1024, so a search can take up to 4 s.
+//
+static void benchSetDir(const FatDir *dir, const char dirStr[], 
+                        const BPB *bpb)
+{
+  static FatCursor cur;
+  FatEntry ent;
+  FatDir   newDir = *dir;
+  uint32_t entCnt = 0;
+  uint16_t ticks[2];                        // [0] FatEntry, [1] fat_SetDir
+  uint8_t  err;
+
+  // Timer 1 normal mode, clk/1024.
+  TCCR1A = 0;
+  TCCR1B = 1 << CS12 | 1 << CS10;
+
+  fat_CacheInvalidate();
+  fat_InitCursor(&cur, dir);
+  TCNT1 = 0;
+  while ((err = fat_CursorNextEntry(&cur, &ent, bpb)) == SUCCESS)
+  {
+    ++entCnt;
+    if (ent.snEnt[ATTR_BYTE_OFFSET] & DIR_ENTRY_ATTR 
+        && !strcmp(ent.lnStr, dirStr))
+      break;
+  }
+  ticks[0] = TCNT1;
+
+  fat_CacheInvalidate();
+  TCNT1 = 0;
+  fat_SetDir(&newDir, dirStr, bpb);
+  ticks[1] = TCNT1;
+  TCCR1B = 0;
+
+  print_StrP(err == SUCCESS ? PSTR("\n\rfound after ") 
+                            : PSTR("\n\rnot found in "));
+  print_Dec(entCnt);
+  print_StrP(PSTR(" entries"));
+  print_StrP(PSTR("\n\rentries/s, FatEntry: "));
+  print_Dec(ticks[0] ? entCnt * CDBENCH_TICKS_PER_SEC / ticks[0] : 0);
+  print_StrP(PSTR("\n\rentries/s, fat_SetDir: "));
+  print_Dec(ticks[1] ? entCnt * CDBENCH_TICKS_PER_SEC / ticks[1] : 0);
+}
+
+//
+// local function used by the 'idxbench' command. Times fat_FindEntry looking
+// up nameStr in dir with the name index detached, i.e. a scan of the 
+// directory, then fat_IndexBuild of dir, and then fat_FindEntry with the 
+// index. The sector cache is emptied before each.
+//
+static void benchIndex(const FatDir *dir, const char nameStr[], 
+                       const BPB *bpb)
+{
+  FatEntryRef ref;
+  uint16_t    ticks[3];                     // [0] scan, [1] build, [2] index
+  uint8_t     err[3];
+
+  // Timer 1 normal mode, clk/1024.
+  TCCR1A = 0;
+  TCCR1B = 1 << CS12 | 1 << CS10;
+
+  for (uint8_t run = 0; run < 3; ++run)
+  {
+    if (run == 0)
+      fat_IndexInit(NULL, NULL, 0);
+    else if (run == 1)
+      fat_IndexInit(&nameIndex, nameIndexEnts, NAME_INDEX_ENTS);
+
+    fat_CacheInvalidate();
+    TCNT1 = 0;
+    if (run == 1)
+      err[run] = fat_IndexBuild(dir, bpb);
+    else
+      err[run] = fat_FindEntry(dir, nameStr, VOLUME_ID_ATTR, 0, &ref, bpb);
+    ticks[run] = TCNT1;
+  }
+  TCCR1B = 0;
+
+  print_StrP(err[2] == SUCCESS ? PSTR("\n\rfound") : PSTR("\n\rnot found"));
+  if (err[0] != err[2])
+    print_StrP(PSTR(" (scan and index differ)"));
+  print_StrP(PSTR("\n\rus, scan: "));
+  print_Dec(ticks[0] * (1000000UL / CDBENCH_TICKS_PER_SEC));
+  print_StrP(PSTR("\n\rus, index build: "));
+  print_Dec(ticks[1] * (1000000UL / CDBENCH_TICKS_PER_SEC));
+  print_StrP(PSTR("\n\rus, index lookup: "));
+  print_Dec(ticks[2] * (1000000UL / CDBENCH_TICKS_PER_SEC));
+  print_StrP(PSTR("\n\rindexed entries: "));
+  print_Dec(nameIndex.entCnt);
+  if (nameIndex.state == INDEX_PARTIAL)
+    print_StrP(PSTR(" (partial)"));
+}
+
+//
+// local function used by the 'lsort' command. Prints the name of each 
+// non-hidden entry of dir in name order.
+//
+static void listSorted(const FatDir *dir, const BPB *bpb)
+{
+  FatSort     srt;
+  FatEntryRef ref;
+  char        nameStr[LN_STR_LEN_MAX];
+  uint8_t     err;
+
+  print_StrP(PSTR("\n\r"));
+  fat_SortInit(&srt, dir, sortKeys, SORT_KEYS, 
+               HIDDEN_ATTR | VOLUME_ID_ATTR, 0);
+  while ((err = fat_SortNext(&srt, &ref, bpb)) == SUCCESS)
+  {
+    if ((err = fat_GetEntryName(&ref, nameStr, bpb)) != SUCCESS)
+      break;
+    print_StrP(PSTR("\n\r"));
+    print_Str(nameStr);
+    if (ref.attr & DIR_ENTRY_ATTR)
+      print_StrP(PSTR("/"));
+  }
+  if (err != END_OF_DIRECTORY)
+    fat_PrintError(err);
+}
+
+//
+// local function used by the 'sortbench' command. Times fat_SortNext over 
+// every non-hidden entry of dir, from an empty sector cache. Timer 1 runs at
+// clk/1024 and its overflows are counted while waiting for each entry, so a
+// single pass over dir can take up to 4 s.
+//
+static void benchSort(const FatDir *dir, const BPB *bpb)
+{
+  FatSort     srt;
+  FatEntryRef ref;
+  uint32_t    ticks = 0;
+  uint32_t    pageTicks = 0;
+  uint16_t    entCnt = 0;
+  uint8_t     err;
+
+  // Timer 1 normal mode, clk/1024.
+  TCCR1A = 0;
+  TCCR1B = 1 << CS12 | 1 << CS10;
+
+  fat_CacheInvalidate();
+  fat_SortInit(&srt, dir, sortKeys, SORT_KEYS, 
+               HIDDEN_ATTR | VOLUME_ID_ATTR, 0);
+  TCNT1 = 0;
+  TIFR1 = 1 << TOV1;
+  while ((err = fat_SortNext(&srt, &ref, bpb)) == SUCCESS)
+  {
+    if (TIFR1 & 1 << TOV1)
+    {
+      ticks += 0x10000;
+      TIFR1 = 1 << TOV1;
+    }
+    if (++entCnt == SORT_PAGE_LEN)
+      pageTicks = ticks + TCNT1;
+  }
+  ticks += TCNT1;
+  TCCR1B = 0;
+  if (entCnt < SORT_PAGE_LEN)
+    pageTicks = ticks;
+
+  if (err != END_OF_DIRECTORY)
+    fat_PrintError(err);
+  print_StrP(PSTR("\n\rentries: "));
+  print_Dec(entCnt);
+  print_StrP(PSTR(", passes: "));
+  print_Dec(srt.passCnt);
+  print_StrP(PSTR("\n\rms, first page: "));
+  print_Dec(pageTicks * (1000000UL / CDBENCH_TICKS_PER_SEC) / 1000);
+  print_StrP(PSTR("\n\rms, all entries: "));
+  print_Dec(ticks * (1000000UL / CDBENCH_TICKS_PER_SEC) / 1000);
+}
+
+//
+// local function used by the 'ent' command. Finds the non-hidden entry of dir
+// numbered by numStr with fat_SeekEntry and prints its name and the time 
+// taken to find it. The checkpoint table is started again whenever dir is
+// not the directory it was last used for.
+//
+static void printEntryNum(const FatDir *dir, const char numStr[], 
+                          const BPB *bpb)
+{
+  static FatCkptTable tbl;
+  static FatCursor    cur;
+  static uint32_t     tblDirClus = 0;
+  FatEntryRef         ref;
+  char                nameStr[LN_STR_LEN_MAX];
+  uint16_t            ticks;
+  uint8_t             err;
+
+  if (tblDirClus != dir->fstClusIndx)
+  {
+    fat_CkptInit(&tbl, dir, ckpts, CKPTS, CKPT_INTERVAL,
+                 HIDDEN_ATTR | VOLUME_ID_ATTR, 0);
+    tblDirClus = dir->fstClusIndx;
+  }
+
+  // Timer 1 normal mode, clk/1024.
+  TCCR1A = 0;
+  TCCR1B = 1 << CS12 | 1 << CS10;
+  TCNT1 = 0;
+  err = fat_SeekEntry(&tbl, &cur, strtoul(numStr, NULL, 10), &ref, bpb);
+  ticks = TCNT1;
+  TCCR1B = 0;
+
+  if (err == SUCCESS)
+    err = fat_GetEntryName(&ref, nameStr, bpb);
+  if (err != SUCCESS)
+  {
+    print_StrP(PSTR("\n\r"));
+    fat_PrintError(err);
+    return;
+  }
+  print_StrP(PSTR("\n\r"));
+  print_Str(nameStr);
+  print_StrP(PSTR("\n\rus: "));
+  print_Dec(ticks * (1000000UL / CDBENCH_TICKS_PER_SEC));
+}
+
+//
+// local function used by the 'stats' command. Prints the number of commands
+// sent in each SD_STAT_ group, and the average number of bytes clocked before
+// each command and while waiting for its R1 response.
+//
+static void printCmdStats(void)
+{
+  static const char *grpStr[SD_STAT_GROUP_CNT] = 
+                      {"CMD17", "CMD18", "CMD24", "CMD12", "other"};
+  SDCmdStats st;
+
+  sd_GetCmdStats(&st);
+  for (uint8_t grp = 0; grp < SD_STAT_GROUP_CNT; ++grp)
+  {
+    if (!st.cmdCnt[grp])
+      continue;
+    print_StrP(PSTR("\n\r"));
+    print_Str((char *)grpStr[grp]);
+    print_StrP(PSTR(": "));
+    print_Dec(st.cmdCnt[grp]);
+    print_StrP(PSTR(" cmds, wait bytes/cmd: "));
+    print_Dec(st.waitBytes[grp] / st.cmdCnt[grp]);
+    print_StrP(PSTR(", R1 bytes/cmd: "));
+    print_Dec(st.r1Bytes[grp] / st.cmdCnt[grp]);
+  }
+  print_StrP(PSTR("\n\rready timeouts: "));
+  print_Dec(st.readyTimeouts);
+}
+
 #if SD_CARD_READ_DATA
 //
 // local function used by the SD_CARD_READ_BLOCK_DATA that gets and returns the
@@ -429,18 +993,18 @@ static uint32_t enterBlockNumber()
     }
     else if (asciiChar == BACKSPACE)        // if backspace on keyboard entered
     {
-      print_Str("\b ");                     // print backspace and space chars
+      print_StrP(PSTR("\b "));               // print backspace and space chars
       blkNum = blkNum / radix;       // reduce current blkNum by factor of 10
     }
-    print_Str("\r");
+    print_StrP(PSTR("\r"));
     print_Dec(blkNum);
     
     if (blkNum >= MAX_BLOCK_NUM_32_BIT)
     {
       blkNum = 0;                           // reset block number
-      print_Str("\n\rblock number too large. Enter value < ");
+      print_StrP(PSTR("\n\rblock number too large. Enter value < "));
       print_Dec(MAX_BLOCK_NUM_32_BIT);
-      print_Str("\n\r");  
+      print_StrP(PSTR("\n\r"));  
     }
     asciiChar = usart_Receive();
   }
@@ -9,14 +9,23 @@
  * License    : GNU GPLv3
  * Author     : Joshua Fain
  * Copyright (c) 2020, 2021
- * 
- * DESCRIPTION: 
  *
+ * DESCRIPTION:
+ * Initializes the SD card, the FAT volume and the VS1053, then runs a shell,
+ * the audio refill, a playback time display and a background directory scan
+ * as cooperative scheduler tasks, so that playback continues while commands
+ * are typed. Commands:
+ *   play <path>  - play a file, e.g. /Artist/Album/Track.mp3. A path 
+ *                  without a leading '/' is in the root directory.
+ *   stop         - stop playback.
+ *   scan         - count the root directory's entries in the background.
+ *   trace        - print each task's max latency and run time.
  */
 
 #include <string.h>
 #include <stdint.h>
 #include <util/delay.h>
+#include <avr/interrupt.h>
 #include "usart0.h"
 #include "spi.h"
 #include "prints.h"
@@ -25,83 +34,283 @@
 #include "fat_bpb.h"
 #include "fat.h"
 #include "fat_to_disk_if.h"
+#include "fat_to_sd.h"
+#include "fat_cache.h"
+#include "fat_path.h"
 #include "mp3.h"
+#include "sched.h"
 
 #define SD_CARD_INIT_ATTEMPTS_MAX      5
-#define CMD_LINE_MAX_CHAR              100  // max num of chars of a cmd/arg
-#define MAX_ARG_CNT                    10   // max num of CL arguments
-#define BACKSPACE                      127  // used for keyboard backspace here
+
+// task periods and deadlines (ms)
+#define AUDIO_PERIOD                   1
+#define AUDIO_DEADLINE                 2
+#define SHELL_PERIOD                   10
+#define SHELL_DEADLINE                 20
+#define UI_PERIOD                      1000
+#define UI_DEADLINE                    100
+#define INDEX_DEADLINE                 500
+
+//
+// The directory scan reads at most this many sectors each time it runs, so
+// it does not hold up the audio task.
+//
+#define INDEX_SECS_PER_RUN             1
+
+static uint16_t AudioTask(void);
+static uint16_t ShellTask(void);
+static uint16_t UiTask(void);
+static uint16_t IndexTask(void);
+static void RunCommand(char cmdStr[]);
+
+static BPB       bpb;
+static FatDir    root;
+static FatFile   file;
+static uint8_t   playing;
+
+static SchedTask audioTask, shellTask, uiTask, indexTask;
+
+// directory scan state, kept between runs of IndexTask.
+static FatCursor idxCur;
+static FatEntry  idxEnt;
+static uint16_t  idxCnt;
+static uint32_t  idxStart;
+static uint8_t   idxRunning;
 
 
 int main(void)
 {
-  // Initializat usart and spi ports.
+  // Initializat usart and spi ports. Usart transmits from an interrupt.
   usart_Init();
   spi_MasterInit();
+  sei();
 
   //
   // SD card initialization
   //
-  CTV ctv;          
+  CTV ctv;
   uint32_t sdInitResp;
 
   // Loop will continue until SD card init succeeds or max attempts reached.
   for (uint8_t att = 0; att < SD_CARD_INIT_ATTEMPTS_MAX; ++att)
   {
-    print_Str("\n\n\r >> SD Card Initialization Attempt "); 
+    print_StrP(PSTR("\n\n\r >> SD Card Initialization Attempt "));
     print_Dec(att);
     sdInitResp = sd_InitModeSPI(&ctv);      // init SD Card
 
     if (sdInitResp != OUT_OF_IDLE)          // Fail to init if not OUT_OF_IDLE
-    {    
-      print_Str(": FAILED TO INITIALIZE SD CARD."
-                " Initialization Error Response: "); 
+    {
+      print_StrP(PSTR(": FAILED TO INITIALIZE SD CARD."
+                      " Initialization Error Response: "));
       sd_PrintInitError(sdInitResp);
-      print_Str(" R1 Response: "); 
+      print_StrP(PSTR(" R1 Response: "));
       sd_PrintR1(sdInitResp);
     }
     else
-    {   
-      print_Str(": SD CARD INITIALIZATION SUCCESSFUL");
+    {
+      print_StrP(PSTR(": SD CARD INITIALIZATION SUCCESSFUL"));
       break;
     }
   }
-    print_Str("\n\rDDRD = 0x");
-    print_Hex(DDRD);
-  DDRD = (1 << DDD0); // XRESET output
-  DDRD = DDRD & ~(1 << DDD1); // DREQ is input
-    print_Str("\n\rDDRD = 0x");
-    print_Hex(DDRD);
-    print_Str("\n\rDREQ = 0x");
-    print_Hex(PIND & (1 << DREQ));
-  VSReset();
-      print_Str("\n\rDREQ = 0x");
-    print_Hex(PIND & (1 << DREQ));
-  spi_MasterTransmit(VS_SCI_MODE);
-  spi_MasterTransmit((uint8_t)(SM_SDINEW >> 8));
-  spi_MasterTransmit(SM_RESET);
-   // print_Str("\n\rDREQ = 0x");
-   // print_Hex(PIND);
-//  VSSCIWrite(VS_SCI_MODE, SM_SDINEW | SM_RESET); //soft reset, set to new mode and disable layer 1-2
-	//_delay_ms(1);
-	while ( !(PIND & (1 << DREQ))) {
-    //print_Str("DREQ = 0x");
-    print_Hex(PIND);
+  if (sdInitResp != OUT_OF_IDLE)
+    return 0;
+
+  // FAT volume
+  FATtoSD_Mount(&ctv);
+  fat_CacheInvalidate();
+  fat_PathCacheInvalidate();
+
+  uint8_t err = fat_SetBPB(&bpb);
+  if (err != BPB_VALID)
+  {
+    print_StrP(PSTR("\n\r fat_SetBPB() returned "));
+    fat_PrintErrorBPB(err);
+    return 0;
+  }
+  fat_SetDirToRoot(&root, &bpb);
+
+  // VS1053
+  if (vs_Init() != VS_SUCCESS)
+  {
+    print_StrP(PSTR("\n\r vs_Init() failed: DREQ timeout"));
+    return 0;
   }
-      print_Str("\n\rDREQ = 0x");
-    print_Hex(PIND & (1 << DREQ));
+  print_StrP(PSTR("\n\r VS1053 SCI_MODE = 0x"));
+  print_Hex(vs_ReadSCI(VS_SCI_MODE));
+  print_StrP(PSTR(", SCI_CLOCKF = 0x"));
+  print_Hex(vs_ReadSCI(VS_SCI_CLOCKF));
+
+  //
+  // The decoder is fed from the DREQ interrupt during playback, and the 
+  // scheduler's time is kept by the Timer0 interrupt.
+  //
+  sched_Init();
+  sched_AddTask(&audioTask, AudioTask, PSTR("audio"), AUDIO_DEADLINE);
+  sched_AddTask(&shellTask, ShellTask, PSTR("shell"), SHELL_DEADLINE);
+  sched_AddTask(&uiTask,    UiTask,    PSTR("ui"),    UI_DEADLINE);
+  sched_AddTask(&indexTask, IndexTask, PSTR("index"), INDEX_DEADLINE);
+
+  print_StrP(PSTR("\n\r> "));
+  sched_Run();
+  return 0;
+}
+
+/*
+ * Keeps the decoder's ring buffer full while a file is playing.
+ */
+static uint16_t AudioTask(void)
+{
+  if (!playing)
+    return SCHED_SUSPEND;
+
+  uint8_t err = vs_PlayRefill(&bpb);
+  if (err == VS_PLAYING)
+    return AUDIO_PERIOD;
+
+  playing = 0;
+  fat_Close(&file);
+  if (err == VS_SUCCESS)
+    print_StrP(PSTR("\n\r done"));
+  else
+    print_StrP(PSTR("\n\r file read error"));
+  print_StrP(PSTR("\n\r> "));
+  return SCHED_SUSPEND;
+}
+
+/*
+ * Collects the characters received by the USART interrupt without blocking
+ * and runs a command when return is received.
+ */
+static uint16_t ShellTask(void)
+{
+  static UsartLine line;
+
+  uint8_t lineStat = usart_PollLine(&line);
+  if (lineStat == USART_LINE_NONE)
+    return SHELL_PERIOD;
 
+  if (lineStat == USART_LINE_OVERFLOW)
+    print_StrP(PSTR("\n\r command too long"));
+  else
+    RunCommand(line.str);
+  print_StrP(PSTR("\n\r> "));
+  return SHELL_PERIOD;
+}
 
 /*
-  for(;;) {
-    usart_Transmit(usart_Receive());
-    XCS_ASSERT;
-    usart_Transmit(usart_Receive());
-    XDCS_ASSERT;
-    usart_Transmit(usart_Receive());
-    CS_SD_LOW;
-    usart_Transmit(usart_Receive());
+ * Shows the decode time of the file that is playing.
+ */
+static uint16_t UiTask(void)
+{
+  if (playing)
+  {
+    uint16_t sec = vs_ReadSCI(VS_SCI_DEC_TIME);
+    print_StrP(PSTR(" ["));
+    print_Dec(sec / 60);
+    print_StrP(PSTR(":"));
+    if (sec % 60 < 10)
+      print_StrP(PSTR("0"));
+    print_Dec(sec % 60);
+    print_StrP(PSTR("]"));
   }
-*/
-  return 0;
+  return UI_PERIOD;
+}
+
+/*
+ * Counts the entries of the root directory, reading no more than 
+ * INDEX_SECS_PER_RUN sectors each time it runs.
+ */
+static uint16_t IndexTask(void)
+{
+  if (!idxRunning)
+    return SCHED_SUSPEND;
+
+  uint8_t secBudget = INDEX_SECS_PER_RUN;
+
+  for (;;)
+  {
+    uint8_t err = fat_CursorScanEntry(&idxCur, &idxEnt, &secBudget, &bpb);
+    if (err == SUCCESS)
+      ++idxCnt;
+    else if (err == SCAN_YIELD)
+      return 0;
+    else
+    {
+      print_StrP(PSTR("\n\r scan: "));
+      print_Dec(idxCnt);
+      print_StrP(PSTR(" entries in "));
+      print_Dec(sched_Millis() - idxStart);
+      print_StrP(PSTR(" ms"));
+      if (err != END_OF_DIRECTORY)
+        fat_PrintError(err);
+      idxRunning = 0;
+      return SCHED_SUSPEND;
+    }
+  }
+}
+
+static void RunCommand(char cmdStr[])
+{
+  if (!strncmp_P(cmdStr, PSTR("play "), 5))
+  {
+    if (playing)
+    {
+      vs_PlayStop();
+      fat_Close(&file);
+      playing = 0;
+    }
+
+    uint8_t err = fat_OpenPath(&file, &root, cmdStr + 5, &bpb);
+    if (err != SUCCESS)
+    {
+      print_StrP(PSTR("\n\r"));
+      fat_PrintError(err);
+      return;
+    }
+    vs_ResetFeedStats();
+    if (vs_PlayStart(&file, &bpb) != VS_PLAYING)
+    {
+      print_StrP(PSTR("\n\r file read error"));
+      fat_Close(&file);
+      return;
+    }
+    playing = 1;
+    sched_Wake(&audioTask);
+  }
+  else if (!strcmp_P(cmdStr, PSTR("stop")))
+  {
+    if (playing)
+    {
+      vs_CancelPlayback();
+      fat_Close(&file);
+      playing = 0;
+    }
+  }
+  else if (!strcmp_P(cmdStr, PSTR("scan")))
+  {
+    fat_InitCursor(&idxCur, &root);
+    fat_InitEntry(&idxEnt, &bpb);
+    idxCnt = 0;
+    idxStart = sched_Millis();
+    idxRunning = 1;
+    sched_Wake(&indexTask);
+  }
+  else if (!strcmp_P(cmdStr, PSTR("trace")))
+  {
+    VSFeedStats fs;
+    vs_GetFeedStats(&fs);
+
+    sched_PrintTrace();
+    print_StrP(PSTR("\n\r ring high/low water = "));
+    print_Dec(fs.highWater);
+    print_StrP(PSTR("/"));
+    print_Dec(fs.lowWater);
+    print_StrP(PSTR(" of "));
+    print_Dec(VS_RING_CHUNKS);
+    print_StrP(PSTR(", underruns = "));
+    print_Dec(fs.underruns);
+    sched_ResetTrace();
+  }
+  else if (cmdStr[0])
+    print_StrP(PSTR("\n\r commands: play <path>, stop, scan, trace"));
 }
@@ -8,7 +8,7 @@
  */
 
 #include <stdint.h>
-#include <stdlib.h>
+#include <avr/interrupt.h>
 #include <avr/io.h>
 #include <util/delay.h>
 #include <string.h>
@@ -19,7 +19,12 @@
 #include "sd_spi_rwe.h"
 #include "fat_bpb.h"
 #include "fat.h"
-#include "fat_to_disk.h"
+#include "fat_to_disk_if.h"
+#include "fat_to_sd.h"
+#include "fat_cache.h"
+#include "fat_sort.h"
+#include "fat_lib.h"
+#include "fat_ckpt.h"
 #include "lcd_addr.h"
 #include "lcd_base.h"
 #include "lcd_sf.h"
@@ -38,12 +43,34 @@
 
 //navigation macros
 #define NEXT   'n'               // next entry in the directory
+#define PREV   'p'               // previous entry in the directory
 #define SELECT 's'               // select current displayed item
 #define UP     'u'               // up a directory level. e.g. songs --> albums
 
+// library levels
+#define ARTISTS              0
+#define ALBUMS               1
+#define SONGS                2
+
+//
+// Keys used to sort the directories if the library has to be built. Only
+// needed while building, but more of them means fewer passes over each
+// directory.
+//
+#define LIB_SORT_KEYS        12
+
+//
+// Checkpoints of the directory being shown if the library file cannot be
+// used and the directories are browsed instead.
+//
+#define DIR_CKPT_CNT         16
+#define DIR_CKPT_INTERVAL    8
+
 
 void PrintToLCD(char * ln);
+void PrintToLCD_P(const char *ln);
 uint8_t InitModules(void);
+void BrowseDirs(const BPB *bpb);
 
 int main(void)
 {
@@ -57,218 +84,133 @@ int main(void)
     // are used to calculate where on the physical disk volume, the FAT 
     // sectors/blocks are located. This should only be set once here.
     //
-    BPB *bpbPtr = malloc(sizeof(BPB));
-    err = fat_setBPB (bpbPtr);
-    if (err != BOOT_SECTOR_VALID)
+    static BPB bpb;
+    BPB *bpbPtr = &bpb;
+    err = fat_SetBPB (bpbPtr);
+    if (err != BPB_VALID)
     {
-      print_str("\n\r fat_setBPB() returned ");
-      fat_printBootSectorError(err);
+      print_StrP(PSTR("\n\r fat_SetBPB() returned "));
+      fat_PrintErrorBPB(err);
+      return 0;
     }
-    
 
     //
-    // Create and set a FatDir instance. Members of this instance are used for
-    // holding parameters of a FAT directory. This instance can be treated as
-    // the current working directory. The instance should be initialized to 
-    // the root directory with fat_setDirToRoot() prior to using anywhere else.
-    //
-//    FatDir *artistDirPtr = malloc(sizeof(FatDir));
-//    FatDir *albumsDirPtr = malloc(sizeof(FatDir));
-//    FatDir *songsDirPtr  = malloc(sizeof(FatDir));
-    FatDir *cwdPtr  = malloc(sizeof(FatDir));
-    //fat_setDirToRoot (cwdPtr, bpbPtr);
-
-
-    // 
-    // Create and initialize a FatEntry instance. This will set the snEntClusIndx
-    // member to the root directory and all other members to 0 or null strings.
-    // Afterwards, update the snEntClusIndx to point to the first cluster index of 
-    // the FatDir instance (dir).
+    // Open the library file. The artists, albums and songs are browsed from
+    // its records, so no directory is read while browsing. It is only built,
+    // i.e. the directories are walked, if the files on the card have changed
+    // since it was last built.
     //
-    FatEntry * entPtr = malloc(sizeof(FatEntry));
-    // fat_initEntry (entPtr, bpbPtr);
-    usart_transmit('\n');
-    usart_transmit('\r');
+    static FatLib lib;
+    FatLib *libPtr = &lib;
+    err = fat_LibOpen (libPtr, bpbPtr);
+    if (err == LIB_STALE)
+    {
+      FatLibRec  secRecs[LIB_RECS_PER_SEC];
+      FatSortKey keys[LIB_SORT_KEYS];
 
-    uint8_t fatErr;
-    char c;
+      print_StrP(PSTR("\n\rBuilding library..."));
+      PrintToLCD_P(PSTR("Building library..."));
+      err = fat_LibBuild (libPtr, secRecs, keys, LIB_SORT_KEYS, bpbPtr);
+    }
+    if (err != LIB_SUCCESS)
+    {
+      print_StrP(PSTR("\n\r library: "));
+      fat_LibPrintError(err);
+      if (err == LIB_READ_FAILED)
+        return 0;
+
+      // the file is missing, fragmented or too small. Walk the directories.
+      BrowseDirs(bpbPtr);
+      return 0;
+    }
+
+    //
+    // The records shown at each level. first and cnt are the record number of
+    // the first record of the level and the number of records, and pos is the
+    // one being displayed. The artists are records 0 to artistCnt - 1, and
+    // the albums or songs of the selected record are its children.
+    //
+    uint16_t first[SONGS + 1], cnt[SONGS + 1], pos[SONGS + 1];
+    uint8_t  level = ARTISTS;
+    static FatLibRec rec;
+    static FatFile   file;
+    char     name[LIB_NAME_LEN + 1];
+    char     c;
+
+    first[ARTISTS] = 0;
+    cnt[ARTISTS] = libPtr->artistCnt;
+    pos[ARTISTS] = 0;
+    usart_Transmit('\n');
+    usart_Transmit('\r');
 
-    // artist set to root directory. Should never change.
-    //fat_setDirToRoot (cwdPtr, bpbPtr);
     while (1)
     {
-      
-      //                                    ARTISTS
-      //
-      
-      // artist set to root directory.
-      fat_setDirToRoot (cwdPtr, bpbPtr);
-      fat_initEntry (entPtr, bpbPtr);
-
-      while (1)
+      if (level == ARTISTS)
+        print_StrP(PSTR("\n\rARTISTS"));
+      else if (level == ALBUMS)
+        print_StrP(PSTR("\n\rALBUMS"));
+      else
+        print_StrP(PSTR("\n\rSONGS"));
+
+      if (cnt[level] == 0)
       {
-        print_str("\n\rARTISTS");
-        fatErr = fat_setNextEntry (cwdPtr, entPtr, bpbPtr);
-        if (fatErr != END_OF_DIRECTORY)
-        {
-          // only print hidden entries if the HIDDEN filter flag is been set.
-          if (!(entPtr->snEnt[11] & HIDDEN_ATTR))
-          {
-            // if entry not pointing to current director or parent directory entry.
-            if (strcmp(entPtr->snStr, ".") && strcmp(entPtr->snStr, ".."))
-            {
-              PrintToLCD(entPtr->lnStr);
-              usart_transmit('\n');
-              usart_transmit('\r');
-            }
-
-
-            //                               ABLUMS
-            //
-            c = usart_receive();
-            if (c == UP)
-              break;
-            else if (c == SELECT && entPtr->snEnt[11] & DIR_ENTRY_ATTR)
-            {
-              fat_setDir (cwdPtr, entPtr->lnStr, bpbPtr);
-              // set fat entry to first entry of new directory
-              fat_initEntry (entPtr, bpbPtr);
-              entPtr->snEntClusIndx = cwdPtr->fstClusIndx;
-
-              while (1)
-              {
-                print_str("\n\rALBUMS");
-                fatErr = fat_setNextEntry (cwdPtr, entPtr, bpbPtr);
-                if (fatErr != END_OF_DIRECTORY)
-                {
-                  // only print hidden entries if the HIDDEN filter flag is been set.
-                  if (!(entPtr->snEnt[11] & HIDDEN_ATTR))
-                  {
-                    // if entry not pointing to current director or parent directory entry.
-                    if (strcmp(entPtr->snStr, ".") && strcmp(entPtr->snStr, ".."))
-                    {
-                      PrintToLCD(entPtr->lnStr);
-                      usart_transmit('\n');
-                      usart_transmit('\r');
-                    }
-
-                    //                               SONGS
-                    //
-                    c = usart_receive();
-                    if (c == UP)
-                    {
-                      fat_setDir (cwdPtr, "..", bpbPtr);
-                      fat_initEntry (entPtr, bpbPtr);
-                      entPtr->snEntClusIndx = cwdPtr->fstClusIndx;
-                      break;
-                    }
-                    else if (c == SELECT && entPtr->snEnt[11] & DIR_ENTRY_ATTR)
-                    {
-                      fat_setDir (cwdPtr, entPtr->lnStr, bpbPtr);
-                      // set fat entry to first entry of new directory
-                      fat_initEntry (entPtr, bpbPtr);
-                      entPtr->snEntClusIndx = cwdPtr->fstClusIndx;
-
-                      while (1)
-                      {
-                        print_str("\n\rSONGS");
-                        fatErr = fat_setNextEntry (cwdPtr, entPtr, bpbPtr);
-                        if (fatErr != END_OF_DIRECTORY)
-                        {
-                          // only print hidden entries if the HIDDEN filter flag is been set.
-                          if (!(entPtr->snEnt[11] & HIDDEN_ATTR))
-                          {
-                            // if entry not pointing to current director or parent directory entry.
-                            if (strcmp(entPtr->snStr, ".") && strcmp(entPtr->snStr, ".."))
-                            {
-                              PrintToLCD(entPtr->lnStr);
-                              usart_transmit('\n');
-                              usart_transmit('\r');
-                            }
-                            c = usart_receive();
-                            if (c == UP)
-                            {
-                              fat_setDir (cwdPtr, "..", bpbPtr);
-                              fat_initEntry (entPtr, bpbPtr);
-                              entPtr->snEntClusIndx = cwdPtr->fstClusIndx;
-                              break;                            
-                            }
-                            else if (c == SELECT && !(entPtr->snEnt[11] & DIR_ENTRY_ATTR))
-                            {
-                              print_str("Playing Song: ");
-                              PrintToLCD(entPtr->lnStr);
-                            }
-                            // Songs else
-                            else
-                              continue;
-                          }
-                        }
-                        // reset for song loop
-                        else
-                        {
-                          fat_initEntry (entPtr, bpbPtr);
-                          entPtr->snEntClusIndx = cwdPtr->fstClusIndx;
-                        }
-                      }
-                    }
-                    // Albums else
-                    else
-                      continue;
-                  }
-                }
-                // reset for album loop
-                else
-                {
-                  fat_initEntry (entPtr, bpbPtr);
-                  entPtr->snEntClusIndx = cwdPtr->fstClusIndx;
-                }
-              }
-            }
-            // Artists else
-            else
-              continue;
-          }
-        }
-        else
-          break;
+        PrintToLCD_P(PSTR("(empty)"));
+        usart_Transmit('\n');
+        usart_Transmit('\r');
+        if (usart_Receive() == UP && level > ARTISTS)
+          --level;
+        continue;
       }
-    }
-/*
-    while(1)
-    {
-      // search artists
-      fatErr = fat_setNextEntry (cwdPtr, entPtr, bpbPtr);
-      if (fatErr != END_OF_DIRECTORY)
-      {     
-        // only print hidden entries if the HIDDEN filter flag is been set.
-        if (!(entPtr->snEnt[11] & HIDDEN_ATTR))
-        {
-          // if entry not pointing to current director or parent directory entry.
-          if (strcmp(entPtr->snStr, ".") && strcmp(entPtr->snStr, ".."))
-          {
-            PrintToLCD(entPtr->lnStr);
-            usart_transmit('\n');
-            usart_transmit('\r');
-            if (usart_receive() == 'o' && entPtr->snEnt[11] & DIR_ENTRY_ATTR)
-            {
-              fat_setDir (cwdPtr, entPtr->lnStr, bpbPtr);
-              // set fat entry to first entry of new directory
-              fat_initEntry (entPtr, bpbPtr);
-              entPtr->snEntClusIndx = cwdPtr->fstClusIndx;
-            }
-          }
-        }
+
+      if (fat_LibGetRec (libPtr, first[level] + pos[level], &rec) 
+          != LIB_SUCCESS)
+      {
+        print_StrP(PSTR("\n\r failed to read library"));
+        return 0;
       }
-      else
+
+      // record names are not null terminated if LIB_NAME_LEN chars long.
+      memcpy(name, rec.name, LIB_NAME_LEN);
+      name[LIB_NAME_LEN] = '\0';
+      PrintToLCD(name);
+      usart_Transmit('\n');
+      usart_Transmit('\r');
+
+      c = usart_Receive();
+      if (c == NEXT)
+      {
+        if (++pos[level] >= cnt[level])
+          pos[level] = 0;
+      }
+      else if (c == PREV)
+      {
+        if (pos[level]-- == 0)
+          pos[level] = cnt[level] - 1;
+      }
+      else if (c == UP && level > ARTISTS)
+        --level;
+      else if (c == SELECT && level < SONGS)
+      {
+        ++level;
+        first[level] = rec.fstChild;
+        cnt[level] = rec.childCnt;
+        pos[level] = 0;
+      }
+      else if (c == SELECT)
       {
-        fat_initEntry (entPtr, bpbPtr);
-        entPtr->snEntClusIndx = cwdPtr->fstClusIndx;
+        // open the song from the record. No directory has to be searched.
+        if (fat_OpenAtClus (&file, rec.fstClus, rec.fileSize, bpbPtr) 
+            == SUCCESS)
+        {
+          print_StrP(PSTR("Playing Song: "));
+          PrintToLCD(name);
+          fat_Close (&file);
+        }
       }
     }
-*/
   }
   else
-    print_str("\n\rFailed to initialize");
+    print_StrP(PSTR("\n\rFailed to initialize"));
 
   return 0;
 }
@@ -277,11 +219,128 @@ int main(void)
 
 
 
+//
+// Browses the artist, album and song directories when the library file
+// cannot be used. The entries of each directory are shown in the order they
+// are in the directory, and are found by their number from the checkpoints
+// of the directory being shown. Only returns if the card cannot be read.
+//
+void BrowseDirs(const BPB *bpb)
+{
+  static FatDir       dir;
+  static FatCursor    cur;
+  static FatCkptTable tbl;
+  static FatCkpt      ckpts[DIR_CKPT_CNT];
+  static FatFile      file;
+  FatEntryRef ref;
+  char        name[LN_STR_LEN_MAX];
+  uint32_t    dirClus[SONGS + 1];
+  uint16_t    pos[SONGS + 1];
+  uint8_t     level = ARTISTS;
+  uint8_t     newDir = 1;
+  uint8_t     err;
+  char        c;
+
+  fat_SetDirToRoot (&dir, bpb);
+  dirClus[ARTISTS] = dir.fstClusIndx;
+  pos[ARTISTS] = 0;
+
+  while (1)
+  {
+    // artists and albums are directories, and songs are files.
+    if (newDir)
+    {
+      dir.fstClusIndx = dirClus[level];
+      fat_CkptInit (&tbl, &dir, ckpts, DIR_CKPT_CNT, DIR_CKPT_INTERVAL,
+                    DIR_ENTRY_ATTR | HIDDEN_ATTR | VOLUME_ID_ATTR,
+                    (level == SONGS) ? 0 : DIR_ENTRY_ATTR);
+      newDir = 0;
+    }
+
+    err = fat_SeekEntry (&tbl, &cur, pos[level], &ref, bpb);
+
+    // stepped past the last entry. Show the first.
+    if (err == END_OF_DIRECTORY && pos[level] > 0)
+    {
+      pos[level] = 0;
+      continue;
+    }
+
+    if (level == ARTISTS)
+      print_StrP(PSTR("\n\rARTISTS"));
+    else if (level == ALBUMS)
+      print_StrP(PSTR("\n\rALBUMS"));
+    else
+      print_StrP(PSTR("\n\rSONGS"));
+
+    if (err == END_OF_DIRECTORY)
+    {
+      PrintToLCD_P(PSTR("(empty)"));
+      usart_Transmit('\n');
+      usart_Transmit('\r');
+      if (usart_Receive() == UP && level > ARTISTS)
+      {
+        --level;
+        newDir = 1;
+      }
+      continue;
+    }
+
+    if (err != SUCCESS || fat_GetEntryName (&ref, name, bpb) != SUCCESS)
+    {
+      print_StrP(PSTR("\n\r failed to read directory"));
+      return;
+    }
+
+    // show as much of the name as fits on a line of the LCD.
+    name[LIB_NAME_LEN] = '\0';
+    PrintToLCD(name);
+    usart_Transmit('\n');
+    usart_Transmit('\r');
+
+    c = usart_Receive();
+    if (c == NEXT)
+      ++pos[level];
+    else if (c == PREV)
+    {
+      // the last entry is found by seeking past the end of the directory.
+      if (pos[level]-- == 0)
+      {
+        fat_SeekEntry (&tbl, &cur, UINT16_MAX, &ref, bpb);
+        pos[level] = tbl.entCnt - 1;
+      }
+    }
+    else if (c == UP && level > ARTISTS)
+    {
+      --level;
+      newDir = 1;
+    }
+    else if (c == SELECT && level < SONGS)
+    {
+      ++level;
+      dirClus[level] = ref.fstClusIndx;
+      pos[level] = 0;
+      newDir = 1;
+    }
+    else if (c == SELECT)
+    {
+      if (fat_OpenAtClus (&file, ref.fstClusIndx, ref.fileSize, bpb) 
+          == SUCCESS)
+      {
+        print_StrP(PSTR("Playing Song: "));
+        PrintToLCD(name);
+        fat_Close (&file);
+      }
+    }
+  }
+}
+
 uint8_t InitModules(void)
 {
   // usart required for character entry
-  usart_init();
-  spi_masterInit();
+  usart_Init();
+  spi_MasterInit();
+  sei();                                  // usart transmits from interrupt
 
   // Ensure LCD is initialized.
   lcd_init();
@@ -290,17 +349,21 @@ uint8_t InitModules(void)
   lcd_displayCtrl (DISPLAY_ON | CURSOR_ON | BLINKING_ON);
 
   // SD card initialization
-  CTV *ctvPtr = malloc(sizeof(CTV));             // SD card type & version
+  static CTV ctv;                                // SD card type & version
+  CTV *ctvPtr = &ctv;
   uint32_t sdInitResp;                           // SD card init error response
 
   // Attempt SD card init up to 5 times.
   for (uint8_t i = 0; i < 5; i++)
   {
-    sdInitResp = sd_spiModeInit (ctvPtr);        // init SD card into SPI mode
+    sdInitResp = sd_InitModeSPI (ctvPtr);        // init SD card into SPI mode
     if (sdInitResp != 0)   
       continue;
-    else
-      return MODULE_INIT_SUCCESS;
+
+    // FAT module reads the volume through the SD card.
+    FATtoSD_Mount (ctvPtr);
+    fat_CacheInvalidate();
+    return MODULE_INIT_SUCCESS;
   }
   return MODULE_INIT_FAILED;
 }
@@ -310,7 +373,7 @@ void PrintToLCD(char *ln)
   lcd_clearDisplay();
   lcd_returnHome();
 
-  print_str(ln);
+  print_Str(ln);
  
   int ndx = 0;
   
@@ -320,3 +383,17 @@ void PrintToLCD(char *ln)
     ndx++;
   }
 }
+
+// same as PrintToLCD, for a string in program memory, e.g. PSTR("...").
+void PrintToLCD_P(const char *ln)
+{
+  lcd_clearDisplay();
+  lcd_returnHome();
+
+  print_StrP(ln);
+
+  char c;
+
+  while ((c = pgm_read_byte(ln++)) != '\0')
+    lcd_writeData(c);
+}